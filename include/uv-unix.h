@@ -267,9 +267,18 @@ typedef struct {
   int delayed_error;                                                          \
   int accepted_fd;                                                            \
   void* queued_fds;                                                           \
+  size_t read_size;                                                           \
+  void* write_copy;                                                           \
+  void* rate_limit;                                                           \
   UV_STREAM_PRIVATE_PLATFORM_FIELDS                                           \
 
-#define UV_TCP_PRIVATE_FIELDS /* empty */
+#define UV_TCP_PRIVATE_FIELDS                                                 \
+  uv_accept_group_t* accept_group;                                            \
+  void* accept_member;                                                        \
+  unsigned int fastopen_qlen;                                                 \
+  void* connect_multi;                                                        \
+  unsigned int notsent_lowat;                                                 \
+
 
 #define UV_UDP_PRIVATE_FIELDS                                                 \
   uv_alloc_cb alloc_cb;                                                       \
@@ -277,6 +286,7 @@ typedef struct {
   uv__io_t io_watcher;                                                        \
   void* write_queue[2];                                                       \
   void* write_completed_queue[2];                                             \
+  size_t gro_segment_size;                                                    \
 
 #define UV_PIPE_PRIVATE_FIELDS                                                \
   const char* pipe_fname; /* strdup'ed */
@@ -231,11 +231,26 @@ typedef struct uv_cpu_info_s uv_cpu_info_t;
 typedef struct uv_interface_address_s uv_interface_address_t;
 typedef struct uv_dirent_s uv_dirent_t;
 typedef struct uv_passwd_s uv_passwd_t;
+typedef struct uv_accept_group_s uv_accept_group_t;
 
 typedef enum {
-  UV_LOOP_BLOCK_SIGNAL
+  UV_LOOP_BLOCK_SIGNAL,
+  UV_LOOP_MEMORY_BUDGET,
+  UV_LOOP_HANDLE_IO_BUDGET,
+  UV_LOOP_ITERATION_IO_BUDGET
 } uv_loop_option;
 
+typedef struct {
+  size_t budget;
+  size_t used;
+  size_t stream_write_queued;
+  size_t udp_send_queued;
+  size_t write_copy_buffered;
+  unsigned int throttled_streams;
+  uint64_t throttle_count;
+  uint64_t udp_rx_dropped;
+} uv_loop_memory_stats_t;
+
 typedef enum {
   UV_RUN_DEFAULT = 0,
   UV_RUN_ONCE,
@@ -274,6 +289,8 @@ UV_EXTERN void uv_loop_delete(uv_loop_t*);
 UV_EXTERN size_t uv_loop_size(void);
 UV_EXTERN int uv_loop_alive(const uv_loop_t* loop);
 UV_EXTERN int uv_loop_configure(uv_loop_t* loop, uv_loop_option option, ...);
+UV_EXTERN int uv_loop_memory_stats(const uv_loop_t* loop,
+                                   uv_loop_memory_stats_t* stats);
 
 UV_EXTERN int uv_run(uv_loop_t*, uv_run_mode mode);
 UV_EXTERN void uv_stop(uv_loop_t*);
@@ -295,6 +312,9 @@ typedef void (*uv_read_cb)(uv_stream_t* stream,
                            ssize_t nread,
                            const uv_buf_t* buf);
 typedef void (*uv_write_cb)(uv_write_t* req, int status);
+typedef void (*uv_write_copy_cb)(uv_stream_t* handle, int status);
+typedef void (*uv_drain_cb)(uv_stream_t* handle);
+typedef void (*uv_timeout_cb)(uv_stream_t* handle);
 typedef void (*uv_connect_cb)(uv_connect_t* req, int status);
 typedef void (*uv_shutdown_cb)(uv_shutdown_t* req, int status);
 typedef void (*uv_connection_cb)(uv_stream_t* server, int status);
@@ -437,6 +457,19 @@ UV_EXTERN void uv_close(uv_handle_t* handle, uv_close_cb close_cb);
 UV_EXTERN int uv_send_buffer_size(uv_handle_t* handle, int* value);
 UV_EXTERN int uv_recv_buffer_size(uv_handle_t* handle, int* value);
 
+/*
+ * Flags that control the suggested_size argument that is passed to the
+ * uv_alloc_cb of stream and UDP handles, see uv_read_size_mode().
+ */
+enum uv_read_size_flags {
+  /* Derive the suggestion from the sizes of recent reads. */
+  UV_READ_SIZE_ADAPTIVE = 1,
+  /* Query the number of pending bytes with FIONREAD before each read. */
+  UV_READ_SIZE_FIONREAD = 2
+};
+
+UV_EXTERN int uv_read_size_mode(uv_handle_t* handle, unsigned int flags);
+
 UV_EXTERN int uv_fileno(const uv_handle_t* handle, uv_os_fd_t* fd);
 
 UV_EXTERN uv_buf_t uv_buf_init(char* base, unsigned int len);
@@ -484,6 +517,10 @@ UV_EXTERN int uv_write2(uv_write_t* req,
 UV_EXTERN int uv_try_write(uv_stream_t* handle,
                            const uv_buf_t bufs[],
                            unsigned int nbufs);
+UV_EXTERN int uv_write_copy(uv_stream_t* handle,
+                            const uv_buf_t bufs[],
+                            unsigned int nbufs,
+                            uv_write_copy_cb cb);
 
 /* uv_write_t is a subclass of uv_req_t. */
 struct uv_write_s {
@@ -500,6 +537,19 @@ UV_EXTERN int uv_is_writable(const uv_stream_t* handle);
 
 UV_EXTERN int uv_stream_set_blocking(uv_stream_t* handle, int blocking);
 
+UV_EXTERN int uv_stream_set_watermarks(uv_stream_t* handle,
+                                       size_t high,
+                                       size_t low,
+                                       uv_drain_cb drain_cb);
+UV_EXTERN int uv_stream_is_above_watermark(const uv_stream_t* handle);
+UV_EXTERN int uv_stream_set_peer(uv_stream_t* handle, uv_stream_t* peer);
+UV_EXTERN int uv_stream_set_rate_limit(uv_stream_t* handle,
+                                       uint64_t rate,
+                                       size_t burst);
+UV_EXTERN int uv_stream_set_idle_timeout(uv_stream_t* handle,
+                                         uint64_t timeout,
+                                         uv_timeout_cb cb);
+
 UV_EXTERN int uv_is_closing(const uv_handle_t* handle);
 
 
@@ -522,10 +572,44 @@ UV_EXTERN int uv_tcp_keepalive(uv_tcp_t* handle,
                                int enable,
                                unsigned int delay);
 UV_EXTERN int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable);
+UV_EXTERN int uv_tcp_fastopen(uv_tcp_t* handle,
+                              int enable,
+                              unsigned int qlen);
+UV_EXTERN int uv_tcp_notsent_lowat(uv_tcp_t* handle, unsigned int bytes);
+
+typedef struct {
+  uint64_t rtt;             /* smoothed round-trip time, microseconds */
+  uint64_t rtt_var;         /* round-trip time variance, microseconds */
+  uint64_t cwnd;            /* congestion window, bytes */
+  uint64_t retransmits;     /* segments retransmitted so far */
+  uint64_t bytes_in_flight; /* bytes sent but not acknowledged yet */
+  uint64_t delivery_rate;   /* recent delivery rate, bytes per second */
+} uv_tcp_info_t;
+
+typedef void (*uv_tcp_info_cb)(uv_tcp_t* handle,
+                               const uv_tcp_info_t* info,
+                               void* arg);
+
+UV_EXTERN int uv_tcp_get_info(const uv_tcp_t* handle, uv_tcp_info_t* info);
+UV_EXTERN int uv_tcp_get_info_all(uv_loop_t* loop,
+                                  uv_tcp_info_cb cb,
+                                  void* arg);
 
 enum uv_tcp_flags {
   /* Used with uv_tcp_bind, when an IPv6 address is used. */
-  UV_TCP_IPV6ONLY = 1
+  UV_TCP_IPV6ONLY = 1,
+  /*
+   * Used with uv_tcp_bind. Sets SO_REUSEPORT so that several handles, on
+   * different loops or in different processes, can listen on the same address
+   * and port. The kernel spreads the connections over them.
+   */
+  UV_TCP_REUSEPORT = 2,
+  /*
+   * Like UV_TCP_REUSEPORT but hands each connection to the listener whose
+   * index in the group (the order of binding) matches the CPU that received
+   * it. Linux only.
+   */
+  UV_TCP_REUSEPORT_CPU = 4
 };
 
 UV_EXTERN int uv_tcp_bind(uv_tcp_t* handle,
@@ -541,6 +625,38 @@ UV_EXTERN int uv_tcp_connect(uv_connect_t* req,
                              uv_tcp_t* handle,
                              const struct sockaddr* addr,
                              uv_connect_cb cb);
+UV_EXTERN int uv_tcp_connect_multi(uv_connect_t* req,
+                                   uv_tcp_t* handle,
+                                   const struct addrinfo* ai,
+                                   uv_connect_cb cb);
+
+enum uv_accept_group_flags {
+  /* Hand each connection to the worker with the fewest open connections. */
+  UV_ACCEPT_GROUP_LEAST_CONNECTIONS = 1
+};
+
+/*
+ * Distributes the connections of one listening TCP handle to worker handles
+ * that can live on other loops and threads.
+ */
+struct uv_accept_group_s {
+  /* public */
+  void* data;
+  /* private */
+  uv_mutex_t mutex;
+  void* members[2];
+  unsigned int flags;
+};
+
+UV_EXTERN int uv_accept_group_init(uv_accept_group_t* group,
+                                   unsigned int flags);
+UV_EXTERN void uv_accept_group_destroy(uv_accept_group_t* group);
+UV_EXTERN int uv_accept_group_listen(uv_accept_group_t* group,
+                                     uv_tcp_t* server,
+                                     int backlog);
+UV_EXTERN int uv_accept_group_join(uv_accept_group_t* group,
+                                   uv_tcp_t* worker,
+                                   uv_connection_cb cb);
 
 /* uv_connect_t is a subclass of uv_req_t. */
 struct uv_connect_s {
@@ -571,9 +687,59 @@ enum uv_udp_flags {
    * (provided they all set the flag) but only the last one to bind will receive
    * any traffic, in effect "stealing" the port from the previous listener.
    */
-  UV_UDP_REUSEADDR = 4
+  UV_UDP_REUSEADDR = 4,
+  /*
+   * Sets SO_REUSEPORT: the kernel spreads the incoming datagrams over all the
+   * handles bound to the same address and port with this flag.
+   */
+  UV_UDP_REUSEPORT = 8,
+  /*
+   * Like UV_UDP_REUSEPORT but hands each datagram to the handle whose index in
+   * the group (the order of binding) matches the CPU that received it. Linux
+   * only.
+   */
+  UV_UDP_REUSEPORT_CPU = 16,
+  /*
+   * Indicates that the message was received by recvmmsg, so the buffer provided
+   * must not be freed by the recv_cb callback.
+   */
+  UV_UDP_MMSG_CHUNK = 32,
+  /*
+   * Indicates that the buffer provided has been fully utilized by recvmmsg and
+   * that it should now be freed by the recv_cb callback. When this flag is set
+   * in uv_udp_recv_cb, nread will always be 0 and addr will always be NULL.
+   */
+  UV_UDP_MMSG_FREE = 64,
+  /*
+   * Indicates that the buffer holds several datagrams of the same flow that the
+   * kernel coalesced, see uv_udp_set_gro. Used in uv_udp_recv_cb.
+   */
+  UV_UDP_GRO = 128,
+  /*
+   * Used with uv_udp_init_ex. Receives several datagrams with one recvmmsg
+   * call when the buffer from the alloc callback is large enough. Linux only.
+   */
+  UV_UDP_RECVMMSG = 256
+};
+
+enum uv_udp_recv_info_flags {
+  /* Kernel receive timestamp of the datagram. */
+  UV_UDP_RECV_TIMESTAMP = 1,
+  /* Local address the datagram was sent to and the interface it came in on. */
+  UV_UDP_RECV_PKTINFO = 2
 };
 
+typedef struct {
+  /* The UV_UDP_RECV_* fields that have been filled in. */
+  unsigned int flags;
+  /* Wall clock time at which the kernel received the datagram. */
+  uv_timespec_t timestamp;
+  /* Destination address of the datagram, the port is always 0. */
+  struct sockaddr_storage local_addr;
+  /* Index of the interface the datagram came in on, or 0 when unknown. */
+  unsigned int ifindex;
+} uv_udp_recv_info_t;
+
 typedef void (*uv_udp_send_cb)(uv_udp_send_t* req, int status);
 typedef void (*uv_udp_recv_cb)(uv_udp_t* handle,
                                ssize_t nread,
@@ -611,7 +777,16 @@ UV_EXTERN int uv_udp_open(uv_udp_t* handle, uv_os_sock_t sock);
 UV_EXTERN int uv_udp_bind(uv_udp_t* handle,
                           const struct sockaddr* addr,
                           unsigned int flags);
+UV_EXTERN int uv_udp_bind_group(uv_loop_t* loops[],
+                                uv_udp_t* handles[],
+                                unsigned int count,
+                                const struct sockaddr* addr,
+                                unsigned int flags);
 
+UV_EXTERN int uv_udp_connect(uv_udp_t* handle, const struct sockaddr* addr);
+UV_EXTERN int uv_udp_getpeername(const uv_udp_t* handle,
+                                 struct sockaddr* name,
+                                 int* namelen);
 UV_EXTERN int uv_udp_getsockname(const uv_udp_t* handle,
                                  struct sockaddr* name,
                                  int* namelen);
@@ -625,16 +800,35 @@ UV_EXTERN int uv_udp_set_multicast_interface(uv_udp_t* handle,
                                              const char* interface_addr);
 UV_EXTERN int uv_udp_set_broadcast(uv_udp_t* handle, int on);
 UV_EXTERN int uv_udp_set_ttl(uv_udp_t* handle, int ttl);
+UV_EXTERN int uv_udp_set_gro(uv_udp_t* handle, int on);
+UV_EXTERN size_t uv_udp_get_gro_segment_size(const uv_udp_t* handle);
+UV_EXTERN int uv_udp_set_drop_counter(uv_udp_t* handle, int on);
+UV_EXTERN uint64_t uv_udp_get_drop_counter(const uv_udp_t* handle);
+UV_EXTERN int uv_udp_set_recv_info(uv_udp_t* handle, unsigned int flags);
+UV_EXTERN int uv_udp_get_recv_info(const uv_udp_t* handle,
+                                   uv_udp_recv_info_t* info);
 UV_EXTERN int uv_udp_send(uv_udp_send_t* req,
                           uv_udp_t* handle,
                           const uv_buf_t bufs[],
                           unsigned int nbufs,
                           const struct sockaddr* addr,
                           uv_udp_send_cb send_cb);
+UV_EXTERN int uv_udp_send_segmented(uv_udp_send_t* req,
+                                    uv_udp_t* handle,
+                                    const uv_buf_t bufs[],
+                                    unsigned int nbufs,
+                                    size_t segment_size,
+                                    const struct sockaddr* addr,
+                                    uv_udp_send_cb send_cb);
 UV_EXTERN int uv_udp_try_send(uv_udp_t* handle,
                               const uv_buf_t bufs[],
                               unsigned int nbufs,
                               const struct sockaddr* addr);
+UV_EXTERN int uv_udp_try_send_batch(uv_udp_t* handle,
+                                    unsigned int count,
+                                    uv_buf_t* bufs[],
+                                    unsigned int nbufs[],
+                                    struct sockaddr* addrs[]);
 UV_EXTERN int uv_udp_recv_start(uv_udp_t* handle,
                                 uv_alloc_cb alloc_cb,
                                 uv_udp_recv_cb recv_cb);
@@ -1104,7 +1298,8 @@ typedef enum {
   UV_FS_READLINK,
   UV_FS_CHOWN,
   UV_FS_FCHOWN,
-  UV_FS_REALPATH
+  UV_FS_REALPATH,
+  UV_FS_COPYFILE
 } uv_fs_type;
 
 /* uv_fs_t is a subclass of uv_req_t. */
@@ -1182,6 +1377,19 @@ UV_EXTERN int uv_fs_rename(uv_loop_t* loop,
                            const char* path,
                            const char* new_path,
                            uv_fs_cb cb);
+
+/*
+ * This flag can be used with uv_fs_copyfile() to return an error if the
+ * destination already exists.
+ */
+#define UV_FS_COPYFILE_EXCL   0x0001
+
+UV_EXTERN int uv_fs_copyfile(uv_loop_t* loop,
+                             uv_fs_t* req,
+                             const char* path,
+                             const char* new_path,
+                             int flags,
+                             uv_fs_cb cb);
 UV_EXTERN int uv_fs_fsync(uv_loop_t* loop,
                           uv_fs_t* req,
                           uv_file file,
@@ -1464,7 +1672,12 @@ struct uv_loop_s {
   /* Loop reference counting. */
   unsigned int active_handles;
   void* handle_queue[2];
-  void* active_reqs[2];
+  union {
+    void* unused;
+    unsigned int count;
+  } active_reqs;
+  /* Internal storage for state that has no room in this struct. */
+  void* internal_fields;
   /* Internal flag to signal loop stop. */
   unsigned int stop_flag;
   UV_LOOP_PRIVATE_FIELDS
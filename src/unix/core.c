@@ -80,6 +80,10 @@
 #include <sys/ioctl.h>
 #endif
 
+#if defined(__linux__)
+# include <linux/filter.h>
+#endif
+
 static int uv__run_pending(uv_loop_t* loop);
 
 /* Verify that uv_buf_t is ABI-compatible with struct iovec. */
@@ -330,10 +334,12 @@ int uv_loop_alive(const uv_loop_t* loop) {
 
 
 int uv_run(uv_loop_t* loop, uv_run_mode mode) {
+  uv__loop_internal_fields_t* lfields;
   int timeout;
   int r;
   int ran_pending;
 
+  lfields = uv__get_internal_fields(loop);
   r = uv__loop_alive(loop);
   if (!r)
     uv__update_time(loop);
@@ -349,7 +355,11 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
     if ((mode == UV_RUN_ONCE && !ran_pending) || mode == UV_RUN_DEFAULT)
       timeout = uv_backend_timeout(loop);
 
+    lfields->io_budget.callbacks = 0;
+    lfields->io_budget.bytes = 0;
     uv__io_poll(loop, timeout);
+    if (lfields->mem.budget != 0 || lfields->mem.throttled != 0)
+      uv__stream_throttle(loop);
     uv__run_check(loop);
     uv__run_closing_handles(loop);
 
@@ -428,6 +438,45 @@ int uv__socket(int domain, int type, int protocol) {
   return sockfd;
 }
 
+
+int uv__socket_reuseport(int fd) {
+#if defined(SO_REUSEPORT)
+  int yes;
+
+  yes = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)))
+    return -errno;
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+/* Attach a classic BPF program to the SO_REUSEPORT group of `fd` that picks
+ * the socket with the same index as the CPU that received the packet. The
+ * kernel falls back to hashing when the group has fewer sockets than that.
+ */
+int uv__socket_steer_cpu(int fd) {
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+  struct sock_filter code[] = {
+    { BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+    { BPF_RET | BPF_A, 0, 0, 0 },
+  };
+  struct sock_fprog prog;
+
+  prog.len = ARRAY_SIZE(code);
+  prog.filter = code;
+  if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)))
+    return -errno;
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
 /* get a file pointer to a file in read-only and close-on-exec mode */
 FILE* uv__open_file(const char* path) {
   int fd;
@@ -737,6 +786,170 @@ int uv_fileno(const uv_handle_t* handle, uv_os_fd_t* fd) {
 }
 
 
+int uv_read_size_mode(uv_handle_t* handle, unsigned int flags) {
+  if (flags & ~(UV_READ_SIZE_ADAPTIVE | UV_READ_SIZE_FIONREAD))
+    return -EINVAL;
+
+  switch (handle->type) {
+  case UV_TCP:
+  case UV_NAMED_PIPE:
+  case UV_TTY:
+    break;
+
+  case UV_UDP:
+    /* A buffer smaller than the next datagram truncates it, only sizes that
+     * come from FIONREAD are safe.
+     */
+    if (flags & UV_READ_SIZE_ADAPTIVE)
+      return -EINVAL;
+    break;
+
+  default:
+    return -EINVAL;
+  }
+
+  handle->flags &= ~(UV_HANDLE_READ_ADAPTIVE | UV_HANDLE_READ_FIONREAD);
+
+  if (flags & UV_READ_SIZE_ADAPTIVE)
+    handle->flags |= UV_HANDLE_READ_ADAPTIVE;
+
+  if (flags & UV_READ_SIZE_FIONREAD)
+    handle->flags |= UV_HANDLE_READ_FIONREAD;
+
+  return 0;
+}
+
+
+/* Returns the suggested_size to pass to the handle's alloc_cb. `hint` is the
+ * size that the adaptive mode has settled on so far, `max` the upper bound for
+ * this type of handle.
+ */
+size_t uv__read_size_suggest(const uv_handle_t* handle,
+                             int fd,
+                             size_t hint,
+                             size_t max) {
+  size_t size;
+  int n;
+
+  if (handle->flags & UV_HANDLE_READ_FIONREAD) {
+    if (ioctl(fd, FIONREAD, &n) == 0 && n > 0) {
+      /* Ask for a little more than what is pending. A buffer that is filled
+       * to the brim makes uv__read() believe that there is more to read and
+       * costs another read() that returns EAGAIN.
+       */
+      size = ((size_t) n / UV__READ_SIZE_MIN + 1) * UV__READ_SIZE_MIN;
+      if (size > max)
+        size = max;
+      return size;
+    }
+  }
+
+  if (handle->flags & UV_HANDLE_READ_ADAPTIVE)
+    return hint;
+
+  return UV__READ_SIZE_DEFAULT;
+}
+
+
+/* Grows the hint when the last read filled the buffer and shrinks it slowly
+ * when reads keep coming in well under it.
+ */
+size_t uv__read_size_update(size_t hint,
+                            size_t buflen,
+                            ssize_t nread,
+                            size_t max) {
+  if (nread <= 0)
+    return hint;
+
+  if ((size_t) nread >= buflen) {
+    hint *= 2;
+    if (hint > max)
+      hint = max;
+  } else if ((size_t) nread <= hint / 4) {
+    hint /= 2;
+    if (hint < UV__READ_SIZE_MIN)
+      hint = UV__READ_SIZE_MIN;
+  }
+
+  return hint;
+}
+
+
+/* Returns non-zero when a handle that has already made `ncallbacks` callbacks
+ * and moved `nbytes` bytes in the current readiness event should stop and
+ * yield to the other handles. The handle's file descriptor is still readable
+ * so the (level-triggered) poller reports it again on the next tick.
+ *
+ * Every handle is allowed one callback per event, even when the loop-wide
+ * budget is spent, so that nothing starves.
+ */
+static int uv__io_budget_check(const uv_loop_t* loop,
+                               unsigned int handle_callbacks,
+                               unsigned int ncallbacks,
+                               size_t nbytes) {
+  const uv__loop_internal_fields_t* lfields;
+
+  if (ncallbacks == 0)
+    return 0;
+
+  if (handle_callbacks != 0 && ncallbacks >= handle_callbacks)
+    return 1;
+
+  lfields = uv__get_internal_fields(loop);
+  if (lfields->io_budget.handle_bytes != 0 &&
+      nbytes >= lfields->io_budget.handle_bytes)
+    return 1;
+
+  if (lfields->io_budget.loop_callbacks != 0 &&
+      lfields->io_budget.callbacks >= lfields->io_budget.loop_callbacks)
+    return 1;
+
+  if (lfields->io_budget.loop_bytes != 0 &&
+      lfields->io_budget.bytes >= lfields->io_budget.loop_bytes)
+    return 1;
+
+  return 0;
+}
+
+
+int uv__io_budget_exceeded(const uv_loop_t* loop,
+                           unsigned int ncallbacks,
+                           size_t nbytes) {
+  const uv__loop_internal_fields_t* lfields;
+
+  lfields = uv__get_internal_fields(loop);
+  return uv__io_budget_check(loop,
+                             lfields->io_budget.handle_callbacks,
+                             ncallbacks,
+                             nbytes);
+}
+
+
+/* Same for a listen socket that has accepted `naccepted` connections. Those
+ * accept until EAGAIN unless UV_LOOP_HANDLE_IO_BUDGET was set explicitly,
+ * the default callback limit only applies to reads.
+ */
+int uv__io_accept_budget_exceeded(const uv_loop_t* loop,
+                                  unsigned int naccepted) {
+  const uv__loop_internal_fields_t* lfields;
+
+  lfields = uv__get_internal_fields(loop);
+  return uv__io_budget_check(loop,
+                             lfields->io_budget.accept_callbacks,
+                             naccepted,
+                             0);
+}
+
+
+void uv__io_budget_charge(uv_loop_t* loop, size_t nbytes) {
+  uv__loop_internal_fields_t* lfields;
+
+  lfields = uv__get_internal_fields(loop);
+  lfields->io_budget.callbacks++;
+  lfields->io_budget.bytes += nbytes;
+}
+
+
 static int uv__run_pending(uv_loop_t* loop) {
   QUEUE* q;
   QUEUE pq;
@@ -823,7 +1036,10 @@ void uv__io_init(uv__io_t* w, uv__io_cb cb, int fd) {
 
 
 void uv__io_start(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
-  assert(0 == (events & ~(POLLIN | POLLOUT | UV__POLLRDHUP)));
+  assert(0 == (events & ~(POLLIN |
+                          POLLOUT |
+                          UV__POLLRDHUP |
+                          UV__POLLEXCLUSIVE)));
   assert(0 != events);
   assert(w->fd >= 0);
   assert(w->fd < INT_MAX);
@@ -870,7 +1086,7 @@ void uv__io_stop(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
   w->pevents &= ~events;
 
-  if (w->pevents == 0) {
+  if ((w->pevents & ~UV__POLLEXCLUSIVE) == 0) {
     QUEUE_REMOVE(&w->watcher_queue);
     QUEUE_INIT(&w->watcher_queue);
 
@@ -60,6 +60,13 @@
 # include <sys/sendfile.h>
 #endif
 
+#if defined(__linux__)
+# include <sys/ioctl.h>
+# ifndef FICLONE
+#  define FICLONE _IOW(0x94, 9, int)
+# endif
+#endif
+
 #define INIT(subtype)                                                         \
   do {                                                                        \
     req->type = UV_FS;                                                        \
@@ -692,6 +699,148 @@ static ssize_t uv__fs_sendfile(uv_fs_t* req) {
 }
 
 
+/* Copies the contents of `in_fd` to the current position of `out_fd`. Tries,
+ * in order: sharing the extents with FICLONE, copying inside the kernel with
+ * copy_file_range(), and uv__fs_sendfile(), which itself falls back to a
+ * read/write loop.
+ */
+static int uv__fs_copyfile_fd(int in_fd, int out_fd, int64_t size) {
+  uv_fs_t sreq;
+  int64_t off;
+  ssize_t n;
+
+  off = 0;
+
+#if defined(__linux__)
+  {
+    static int no_copy_file_range;
+
+    if (ioctl(out_fd, FICLONE, in_fd) == 0)
+      return 0;
+
+    while (off < size && !no_copy_file_range) {
+      n = uv__copy_file_range(in_fd, &off, out_fd, NULL, size - off, 0);
+      if (n > 0)
+        continue;
+
+      if (n == 0)
+        return 0;  /* The source shrank. */
+
+      if (errno == EINTR)
+        continue;
+
+      if (errno == ENOSYS)
+        no_copy_file_range = 1;
+      else if (errno != EXDEV &&
+               errno != EINVAL &&
+               errno != EOPNOTSUPP &&
+               errno != EPERM)
+        return -1;
+
+      break;
+    }
+  }
+#endif
+
+  while (off < size) {
+    sreq.flags = in_fd;
+    sreq.file = out_fd;
+    sreq.off = off;
+    sreq.bufsml[0].len = size - off;
+    n = uv__fs_sendfile(&sreq);
+    if (n == -1 && errno == EINTR)
+      continue;
+    if (n == -1)
+      return -1;
+    if (n == 0)
+      break;
+    off += n;
+  }
+
+  return 0;
+}
+
+
+static ssize_t uv__fs_copyfile(uv_fs_t* req) {
+  struct stat statbuf;
+  struct stat dst_statbuf;
+  uv_fs_t oreq;
+  int src_fd;
+  int dst_fd;
+  int err;
+  int r;
+
+  /* uv__fs_open() takes care of O_CLOEXEC and the cloexec lock. */
+  oreq.loop = req->loop;
+  oreq.cb = req->cb;
+  oreq.path = req->path;
+  oreq.flags = O_RDONLY;
+  oreq.mode = 0;
+  src_fd = uv__fs_open(&oreq);
+  if (src_fd == -1)
+    return -1;
+
+  if (fstat(src_fd, &statbuf)) {
+    err = errno;
+    uv__close(src_fd);
+    errno = err;
+    return -1;
+  }
+
+  oreq.path = req->new_path;
+  oreq.flags = O_WRONLY | O_CREAT;
+  if (req->flags & UV_FS_COPYFILE_EXCL)
+    oreq.flags |= O_EXCL;
+  oreq.mode = statbuf.st_mode;
+  dst_fd = uv__fs_open(&oreq);
+  if (dst_fd == -1) {
+    err = errno;
+    uv__close(src_fd);
+    errno = err;
+    return -1;
+  }
+
+  /* Copying a file onto itself, or onto a hard link to it, is a no-op. Check
+   * before truncating, O_TRUNC would have destroyed the source.
+   */
+  if (fstat(dst_fd, &dst_statbuf)) {
+    err = errno;
+    uv__close(src_fd);
+    uv__close(dst_fd);
+    errno = err;
+    return -1;
+  }
+
+  if (statbuf.st_dev == dst_statbuf.st_dev &&
+      statbuf.st_ino == dst_statbuf.st_ino) {
+    uv__close(src_fd);
+    uv__close(dst_fd);
+    return 0;
+  }
+
+  err = 0;
+  if (ftruncate(dst_fd, 0) ||
+      fchmod(dst_fd, statbuf.st_mode) ||
+      uv__fs_copyfile_fd(src_fd, dst_fd, statbuf.st_size)) {
+    err = errno;
+  }
+
+  uv__close(src_fd);
+  r = uv__close(dst_fd);
+  if (r != 0 && err == 0)
+    err = -r;
+
+  /* Don't leave a partial copy behind. */
+  if (err != 0) {
+    unlink(req->new_path);
+    errno = err;
+    return -1;
+  }
+
+  return 0;
+}
+
+
 static ssize_t uv__fs_utime(uv_fs_t* req) {
   struct utimbuf buf;
   buf.actime = req->atime;
@@ -958,6 +1107,7 @@ static void uv__fs_work(struct uv__work* w) {
     X(CHMOD, chmod(req->path, req->mode));
     X(CHOWN, chown(req->path, req->uid, req->gid));
     X(CLOSE, close(req->file));
+    X(COPYFILE, uv__fs_copyfile(req));
     X(FCHMOD, fchmod(req->file, req->mode));
     X(FCHOWN, fchown(req->file, req->uid, req->gid));
     X(FDATASYNC, uv__fs_fdatasync(req));
@@ -1265,6 +1415,22 @@ int uv_fs_rename(uv_loop_t* loop,
 }
 
 
+int uv_fs_copyfile(uv_loop_t* loop,
+                   uv_fs_t* req,
+                   const char* path,
+                   const char* new_path,
+                   int flags,
+                   uv_fs_cb cb) {
+  if (flags & ~UV_FS_COPYFILE_EXCL)
+    return -EINVAL;
+
+  INIT(COPYFILE);
+  PATH2;
+  req->flags = flags;
+  POST;
+}
+
+
 int uv_fs_rmdir(uv_loop_t* loop, uv_fs_t* req, const char* path, uv_fs_cb cb) {
   INIT(RMDIR);
   PATH;
@@ -106,6 +106,17 @@ int uv__pthread_sigmask(int how, const sigset_t* set, sigset_t* oset);
 # define UV__POLLRDHUP 0x2000
 #endif
 
+/* Wake up only one of the loops that watch a shared file descriptor, see
+ * uv_tcp_simultaneous_accepts(). Equals EPOLLEXCLUSIVE (Linux 4.5+), which
+ * older kernels ignore. Unlike the other flags it sticks to the watcher when
+ * it is stopped.
+ */
+#if defined(__linux__)
+# define UV__POLLEXCLUSIVE 0x10000000
+#else
+# define UV__POLLEXCLUSIVE 0
+#endif
+
 #if !defined(O_CLOEXEC) && defined(__FreeBSD__)
 /*
  * It may be that we are just missing `__POSIX_VISIBLE >= 200809`.
@@ -115,6 +126,11 @@ int uv__pthread_sigmask(int how, const sigset_t* set, sigset_t* oset);
 #endif
 
 typedef struct uv__stream_queued_fds_s uv__stream_queued_fds_t;
+typedef struct uv__write_copy_s uv__write_copy_t;
+typedef struct uv__rate_limit_s uv__rate_limit_t;
+typedef struct uv__loop_internal_fields_s uv__loop_internal_fields_t;
+typedef struct uv__stream_ext_s uv__stream_ext_t;
+typedef struct uv__udp_ext_s uv__udp_ext_t;
 
 /* handle flags */
 enum {
@@ -133,7 +149,19 @@ enum {
   UV_TCP_SINGLE_ACCEPT    = 0x1000, /* Only accept() when idle. */
   UV_HANDLE_IPV6          = 0x10000, /* Handle is bound to a IPv6 socket. */
   UV_UDP_PROCESSING       = 0x20000, /* Handle is running the send callback queue. */
-  UV_HANDLE_BOUND         = 0x40000  /* Handle is bound to an address and port */
+  UV_HANDLE_BOUND         = 0x40000, /* Handle is bound to an address and port */
+  UV_HANDLE_READ_ADAPTIVE = 0x80000, /* Size reads after recent reads. */
+  UV_HANDLE_READ_FIONREAD = 0x100000, /* Size reads with FIONREAD. */
+  UV_STREAM_READ_PAUSED   = 0x200000, /* Peer's write queue is too long. */
+  UV_STREAM_HIGH_WATERMARK = 0x400000, /* Write queue above high watermark. */
+  UV_STREAM_READ_THROTTLED = 0x800000, /* Loop is over its memory budget. */
+  UV_HANDLE_REUSEPORT_CPU = 0x1000000, /* Steer connections by CPU. */
+  UV_TCP_FASTOPEN         = 0x2000000, /* Use TCP Fast Open. */
+  UV_HANDLE_UDP_RECVMMSG  = 0x4000000, /* Receive datagrams with recvmmsg(). */
+  UV_HANDLE_UDP_GRO       = 0x8000000, /* Kernel coalesces received datagrams. */
+  UV_HANDLE_UDP_CONNECTED = 0x10000000, /* Socket has a default peer. */
+  UV_HANDLE_UDP_RECVINFO  = 0x20000000, /* Timestamp or pktinfo cmsgs on. */
+  UV_HANDLE_UDP_RXQ_OVFL  = 0x40000000  /* Count receive queue drops. */
 };
 
 /* loop flags */
@@ -146,12 +174,118 @@ typedef enum {
   UV_CLOCK_FAST = 1      /* Use the fastest clock with <= 1ms granularity. */
 } uv_clocktype_t;
 
+/* Default number of callbacks per handle and readiness event. */
+#define UV__IO_BUDGET_CALLBACKS 32
+
+/* Bounds for the suggested_size that is passed to alloc_cb. */
+#define UV__READ_SIZE_MIN       1024
+#define UV__READ_SIZE_DEFAULT   (64 * 1024)
+#define UV__READ_SIZE_MAX       (256 * 1024)
+
 struct uv__stream_queued_fds_s {
   unsigned int size;
   unsigned int offset;
   int fds[1];
 };
 
+/* Default size of the buffers that uv_write_copy() coalesces writes into. */
+#define UV__WRITE_COPY_SIZE     (64 * 1024)
+
+struct uv__write_copy_s {
+  uv_write_t req;
+  uv_write_copy_cb cb;
+  char* data;
+  size_t size;
+  size_t len;
+};
+
+/* Token bucket of a stream with a rate limit, see uv_stream_set_rate_limit().
+ * `tokens` is the number of bytes that may be written right now, it grows by
+ * `rate` bytes per second up to `burst`. Not used while the kernel paces the
+ * socket.
+ */
+struct uv__rate_limit_s {
+  uv_timer_t timer;
+  uv_stream_t* stream;
+  uint64_t rate;
+  uint64_t burst;
+  double tokens;
+  uint64_t last;
+  int paced;
+};
+
+/* Loop state that has no room in uv_loop_t. Allocated by uv_loop_init() and
+ * freed when the loop is closed, uv_loop_t keeps its size.
+ */
+struct uv__loop_internal_fields_s {
+  struct {
+    size_t budget;
+    size_t write_queued;
+    size_t send_queued;
+    size_t write_copy;
+    unsigned int throttled;
+    uint64_t throttle_count;
+    uint64_t udp_dropped;
+  } mem;
+  struct {
+    unsigned int handle_callbacks;
+    unsigned int accept_callbacks;
+    size_t handle_bytes;
+    unsigned int loop_callbacks;
+    size_t loop_bytes;
+    unsigned int callbacks;
+    size_t bytes;
+  } io_budget;
+  void* idle_streams[2];        /* Streams with an idle timeout. */
+  uv_timer_t* idle_timer;       /* Created by the first idle timeout. */
+};
+
+#define uv__get_internal_fields(loop)                                         \
+  ((uv__loop_internal_fields_t*) (loop)->internal_fields)
+
+/* State of a handle that is only needed once an optional feature is used. It
+ * is allocated on first use and kept in the reserved handle fields so that the
+ * public structs keep their size. Freed when the handle is closed.
+ */
+#define uv__handle_ext(handle) ((handle)->u.reserved[1])
+
+/* The optional state of a stream, see uv__handle_ext(). */
+struct uv__stream_ext_s {
+  uv_stream_t* stream;
+  size_t write_high_watermark;
+  size_t write_low_watermark;
+  uv_drain_cb drain_cb;
+  uv_stream_t* peer;            /* Paired with uv_stream_set_peer(). */
+  size_t throttle_nread;        /* Read since the last uv__stream_throttle(). */
+  void* idle_queue[2];
+  uint64_t idle_timeout;
+  uint64_t idle_last;           /* Loop time of the last read or write. */
+  uv_timeout_cb timeout_cb;
+};
+
+/* The optional receive state of a UDP handle, see uv__handle_ext(). */
+struct uv__udp_ext_s {
+  struct msghdr* recv_msg;      /* Datagram in the receive callback. */
+  char* recv_slab;              /* Receive buffer when there's no alloc_cb. */
+  size_t recv_slab_size;
+  uint64_t rx_dropped;
+  uint32_t rxq_ovfl;            /* Last SO_RXQ_OVFL total from the kernel. */
+};
+
+/* A worker handle of an accept group. Outlives the worker while connections
+ * that it accepted are still open, see uv__accept_member_release().
+ */
+struct uv__accept_member_s {
+  void* queue[2];
+  uv_accept_group_t* group;
+  uv_tcp_t* handle;             /* The worker, NULL once it left the group. */
+  int wakeup_fd;                /* Write end of the pipe the worker polls. */
+  int* fds;                     /* Accepted, not yet handed to the worker. */
+  unsigned int nfds;
+  unsigned int size;
+  unsigned int connections;     /* Handed to the worker and still open. */
+};
+
 
 #if defined(_AIX) || \
     defined(__APPLE__) || \
@@ -167,6 +301,12 @@ struct uv__stream_queued_fds_s {
 #endif
 
 /* core */
+int uv__io_budget_exceeded(const uv_loop_t* loop,
+                           unsigned int ncallbacks,
+                           size_t nbytes);
+int uv__io_accept_budget_exceeded(const uv_loop_t* loop,
+                                  unsigned int naccepted);
+void uv__io_budget_charge(uv_loop_t* loop, size_t nbytes);
 int uv__cloexec_ioctl(int fd, int set);
 int uv__cloexec_fcntl(int fd, int set);
 int uv__nonblock_ioctl(int fd, int set);
@@ -174,10 +314,20 @@ int uv__nonblock_fcntl(int fd, int set);
 int uv__close(int fd);
 int uv__close_nocheckstdio(int fd);
 int uv__socket(int domain, int type, int protocol);
+int uv__socket_reuseport(int fd);
+int uv__socket_steer_cpu(int fd);
 int uv__dup(int fd);
 ssize_t uv__recvmsg(int fd, struct msghdr *msg, int flags);
 void uv__make_close_pending(uv_handle_t* handle);
 int uv__getiovmax(void);
+size_t uv__read_size_suggest(const uv_handle_t* handle,
+                             int fd,
+                             size_t hint,
+                             size_t max);
+size_t uv__read_size_update(size_t hint,
+                            size_t buflen,
+                            ssize_t nread,
+                            size_t max);
 
 void uv__io_init(uv__io_t* w, uv__io_cb cb, int fd);
 void uv__io_start(uv_loop_t* loop, uv__io_t* w, unsigned int events);
@@ -216,6 +366,9 @@ int uv__open_cloexec(const char* path, int flags);
 int uv_tcp_listen(uv_tcp_t* tcp, int backlog, uv_connection_cb cb);
 int uv__tcp_nodelay(int fd, int on);
 int uv__tcp_keepalive(int fd, int on, unsigned int delay);
+int uv__tcp_notsent_lowat(int fd, unsigned int bytes);
+void uv__accept_group_adopt(uv_tcp_t* worker, uv_stream_t* client, int err);
+void uv__stream_throttle(uv_loop_t* loop);
 
 /* pipe */
 int uv_pipe_listen(uv_pipe_t* handle, int backlog, uv_connection_cb cb);
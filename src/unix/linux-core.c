@@ -214,10 +214,15 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     e.events = w->pevents;
     e.data = w->fd;
 
-    if (w->events == 0)
+    if (w->events == 0) {
       op = UV__EPOLL_CTL_ADD;
-    else
+    } else if ((w->events | w->pevents) & UV__POLLEXCLUSIVE) {
+      /* EPOLLEXCLUSIVE watchers can't be modified, only removed and added. */
+      uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, w->fd, &e);
+      op = UV__EPOLL_CTL_ADD;
+    } else {
       op = UV__EPOLL_CTL_MOD;
+    }
 
     /* XXX Future optimization: do EPOLL_CTL_MOD lazily if we stop watching
      * events, skip the syscall and squelch the events after epoll_wait().
@@ -229,8 +234,13 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       assert(op == UV__EPOLL_CTL_ADD);
 
       /* We've reactivated a file descriptor that's been watched before. */
-      if (uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_MOD, w->fd, &e))
+      if (w->pevents & UV__POLLEXCLUSIVE) {
+        uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, w->fd, &e);
+        if (uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_ADD, w->fd, &e))
+          abort();
+      } else if (uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_MOD, w->fd, &e)) {
         abort();
+      }
     }
 
     w->events = w->pevents;
@@ -147,5 +147,11 @@ int uv__utimesat(int dirfd,
 ssize_t uv__preadv(int fd, const struct iovec *iov, int iovcnt, int64_t offset);
 ssize_t uv__pwritev(int fd, const struct iovec *iov, int iovcnt, int64_t offset);
 int uv__dup3(int oldfd, int newfd, int flags);
+ssize_t uv__copy_file_range(int fd_in,
+                            int64_t* off_in,
+                            int fd_out,
+                            int64_t* off_out,
+                            size_t len,
+                            unsigned int flags);
 
 #endif /* UV_LINUX_SYSCALL_H_ */
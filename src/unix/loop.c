@@ -28,6 +28,7 @@
 #include <unistd.h>
 
 int uv_loop_init(uv_loop_t* loop) {
+  uv__loop_internal_fields_t* lfields;
   void* saved_data;
   int err;
 
@@ -37,9 +38,14 @@ int uv_loop_init(uv_loop_t* loop) {
   memset(loop, 0, sizeof(*loop));
   loop->data = saved_data;
 
+  lfields = uv__calloc(1, sizeof(*lfields));
+  if (lfields == NULL)
+    return UV_ENOMEM;
+  loop->internal_fields = lfields;
+
   heap_init((struct heap*) &loop->timer_heap);
   QUEUE_INIT(&loop->wq);
-  QUEUE_INIT(&loop->active_reqs);
+  loop->active_reqs.count = 0;
   QUEUE_INIT(&loop->idle_handles);
   QUEUE_INIT(&loop->async_handles);
   QUEUE_INIT(&loop->check_handles);
@@ -53,6 +59,8 @@ int uv_loop_init(uv_loop_t* loop) {
   QUEUE_INIT(&loop->watcher_queue);
 
   loop->closing_handles = NULL;
+  QUEUE_INIT(&lfields->idle_streams);
+  lfields->io_budget.handle_callbacks = UV__IO_BUDGET_CALLBACKS;
   uv__update_time(loop);
   uv__async_init(&loop->async_watcher);
   loop->signal_pipefd[0] = -1;
@@ -65,7 +73,7 @@ int uv_loop_init(uv_loop_t* loop) {
 
   err = uv__platform_loop_init(loop);
   if (err)
-    return err;
+    goto fail_platform_init;
 
   err = uv_signal_init(loop, &loop->child_watcher);
   if (err)
@@ -104,11 +112,17 @@ fail_rwlock_init:
 fail_signal_init:
   uv__platform_loop_delete(loop);
 
+fail_platform_init:
+  uv__free(lfields);
+  loop->internal_fields = NULL;
+
   return err;
 }
 
 
 void uv__loop_close(uv_loop_t* loop) {
+  uv__loop_internal_fields_t* lfields;
+
   uv__signal_loop_cleanup(loop);
   uv__platform_loop_delete(loop);
   uv__async_stop(loop, &loop->async_watcher);
@@ -144,16 +158,68 @@ void uv__loop_close(uv_loop_t* loop) {
   uv__free(loop->watchers);
   loop->watchers = NULL;
   loop->nwatchers = 0;
+
+  /* The idle timer is an internal handle that is never closed. */
+  lfields = uv__get_internal_fields(loop);
+  if (lfields->idle_timer != NULL) {
+    uv_timer_stop(lfields->idle_timer);
+    QUEUE_REMOVE(&lfields->idle_timer->handle_queue);
+    uv__free(lfields->idle_timer);
+  }
+
+  uv__free(lfields);
+  loop->internal_fields = NULL;
 }
 
 
 int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap) {
-  if (option != UV_LOOP_BLOCK_SIGNAL)
-    return UV_ENOSYS;
+  uv__loop_internal_fields_t* lfields;
+
+  lfields = uv__get_internal_fields(loop);
+  switch (option) {
+    case UV_LOOP_BLOCK_SIGNAL:
+      if (va_arg(ap, int) != SIGPROF)
+        return UV_EINVAL;
+
+      loop->flags |= UV_LOOP_BLOCK_SIGPROF;
+      return 0;
+
+    case UV_LOOP_MEMORY_BUDGET:
+      /* Throttled streams resume on the next tick if the budget is lifted. */
+      lfields->mem.budget = va_arg(ap, size_t);
+      return 0;
+
+    case UV_LOOP_HANDLE_IO_BUDGET:
+      lfields->io_budget.handle_callbacks = va_arg(ap, unsigned int);
+      lfields->io_budget.accept_callbacks = lfields->io_budget.handle_callbacks;
+      lfields->io_budget.handle_bytes = va_arg(ap, size_t);
+      return 0;
+
+    case UV_LOOP_ITERATION_IO_BUDGET:
+      lfields->io_budget.loop_callbacks = va_arg(ap, unsigned int);
+      lfields->io_budget.loop_bytes = va_arg(ap, size_t);
+      return 0;
+
+    default:
+      return UV_ENOSYS;
+  }
+}
 
-  if (va_arg(ap, int) != SIGPROF)
-    return UV_EINVAL;
 
-  loop->flags |= UV_LOOP_BLOCK_SIGPROF;
+int uv_loop_memory_stats(const uv_loop_t* loop,
+                         uv_loop_memory_stats_t* stats) {
+  const uv__loop_internal_fields_t* lfields;
+
+  lfields = uv__get_internal_fields(loop);
+  stats->budget = lfields->mem.budget;
+  stats->stream_write_queued = lfields->mem.write_queued;
+  stats->udp_send_queued = lfields->mem.send_queued;
+  stats->write_copy_buffered = lfields->mem.write_copy;
+  stats->used = stats->stream_write_queued +
+                stats->udp_send_queued +
+                stats->write_copy_buffered;
+  stats->throttled_streams = lfields->mem.throttled;
+  stats->throttle_count = lfields->mem.throttle_count;
+  stats->udp_rx_dropped = lfields->mem.udp_dropped;
   return 0;
 }
@@ -60,12 +60,84 @@ struct uv__stream_select_s {
 };
 #endif /* defined(__APPLE__) */
 
+/* Upper bound for the number of buffers from different write requests that
+ * uv__write() gathers into a single writev() call. Further capped by
+ * uv__getiovmax().
+ */
+#define UV__WRITE_GATHER_MAX 1024
+
+/* A rate limited stream waits until it may write at least this many
+ * milliseconds' worth of data, or the whole write queue.
+ */
+#define UV__RATE_LIMIT_INTERVAL 5
+
+/* The idle timeout sweeper may run this fraction of the shortest timeout
+ * late, which bounds how often it walks the streams.
+ */
+#define UV__IDLE_SWEEP_SLACK 16
+
+/* Reasons for not polling a reading stream for input. */
+#define UV__STREAM_READ_BLOCKED                                               \
+  (UV_STREAM_READ_PAUSED | UV_STREAM_READ_THROTTLED)
+
 static void uv__stream_connect(uv_stream_t*);
 static void uv__write(uv_stream_t* stream);
 static void uv__read(uv_stream_t* stream);
 static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events);
 static void uv__write_callbacks(uv_stream_t* stream);
 static size_t uv__write_req_size(uv_write_t* req);
+static void uv__write_copy_flush(uv_stream_t* stream);
+static void uv__stream_low_watermark(uv_stream_t* stream);
+static void uv__stream_unpair(uv_stream_t* stream);
+static void uv__rate_limit_pace(uv_stream_t* stream, int fd);
+static size_t uv__rate_limit_take(uv_stream_t* stream);
+static void uv__rate_limit_charge(uv_stream_t* stream, size_t n);
+static void uv__rate_limit_timer_cb(uv_timer_t* timer);
+
+
+/* Returns the optional state of the stream, allocated on first use. Returns
+ * NULL when out of memory.
+ */
+static uv__stream_ext_t* uv__stream_ext(uv_stream_t* stream) {
+  uv__stream_ext_t* ext;
+
+  ext = uv__handle_ext(stream);
+  if (ext == NULL) {
+    ext = uv__calloc(1, sizeof(*ext));
+    if (ext == NULL)
+      return NULL;
+    ext->stream = stream;
+    uv__handle_ext(stream) = ext;
+  }
+
+  return ext;
+}
+
+
+/* Records a read or a write for the idle timeout. */
+static void uv__stream_touch(uv_stream_t* stream) {
+  uv__stream_ext_t* ext;
+
+  ext = uv__handle_ext(stream);
+  if (ext != NULL)
+    ext->idle_last = stream->loop->time;
+}
+
+
+/* Counts what the stream read for uv__stream_throttle(). Only needed while
+ * the loop has a memory budget, streams don't allocate their optional state
+ * for it otherwise.
+ */
+static void uv__stream_count_nread(uv_stream_t* stream, ssize_t nread) {
+  uv__stream_ext_t* ext;
+
+  if (uv__get_internal_fields(stream->loop)->mem.budget == 0)
+    return;
+
+  ext = uv__stream_ext(stream);
+  if (ext != NULL)
+    ext->throttle_nread += nread;
+}
 
 
 void uv__stream_init(uv_loop_t* loop,
@@ -83,6 +155,10 @@ void uv__stream_init(uv_loop_t* loop,
   stream->accepted_fd = -1;
   stream->queued_fds = NULL;
   stream->delayed_error = 0;
+  stream->read_size = UV__READ_SIZE_DEFAULT;
+  stream->write_copy = NULL;
+  uv__handle_ext(stream) = NULL;
+  stream->rate_limit = NULL;
   QUEUE_INIT(&stream->write_queue);
   QUEUE_INIT(&stream->write_completed_queue);
   stream->write_queue_size = 0;
@@ -407,8 +483,16 @@ int uv__stream_open(uv_stream_t* stream, int fd, int flags) {
     /* TODO Use delay the user passed in. */
     if ((stream->flags & UV_TCP_KEEPALIVE) && uv__tcp_keepalive(fd, 1, 60))
       return -errno;
+
+    if (((uv_tcp_t*) stream)->notsent_lowat != 0 &&
+        uv__tcp_notsent_lowat(fd, ((uv_tcp_t*) stream)->notsent_lowat)) {
+      return -errno;
+    }
   }
 
+  if (stream->rate_limit != NULL)
+    uv__rate_limit_pace(stream, fd);
+
 #if defined(__APPLE__)
   enable = 1;
   if (setsockopt(fd, SOL_SOCKET, SO_OOBINLINE, &enable, sizeof(enable)) &&
@@ -440,6 +524,8 @@ void uv__stream_flush_write_queue(uv_stream_t* stream, int error) {
 
 
 void uv__stream_destroy(uv_stream_t* stream) {
+  uv__write_copy_t* wc;
+
   assert(!uv__io_active(&stream->io_watcher, POLLIN | POLLOUT));
   assert(stream->flags & UV_CLOSED);
 
@@ -452,6 +538,16 @@ void uv__stream_destroy(uv_stream_t* stream) {
   uv__stream_flush_write_queue(stream, -ECANCELED);
   uv__write_callbacks(stream);
 
+  if (stream->write_copy != NULL) {
+    wc = stream->write_copy;
+    stream->write_copy = NULL;
+    uv__req_unregister(stream->loop, &wc->req);
+    uv__get_internal_fields(stream->loop)->mem.write_copy -= wc->size;
+    if (wc->cb != NULL)
+      wc->cb(stream, -ECANCELED);
+    uv__free(wc);
+  }
+
   if (stream->shutdown_req) {
     /* The ECANCELED error code is a lie, the shutdown(2) syscall is a
      * fait accompli at this point. Maybe we should revisit this in v0.11.
@@ -463,6 +559,9 @@ void uv__stream_destroy(uv_stream_t* stream) {
     stream->shutdown_req = NULL;
   }
 
+  uv__free(uv__handle_ext(stream));
+  uv__handle_ext(stream) = NULL;
+
   assert(stream->write_queue_size == 0);
 }
 
@@ -511,6 +610,7 @@ static int uv__emfile_trick(uv_loop_t* loop, int accept_fd) {
 
 void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   uv_stream_t* stream;
+  unsigned int count;
   int err;
 
   stream = container_of(w, uv_stream_t, io_watcher);
@@ -523,9 +623,13 @@ void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   /* connection_cb can close the server socket while we're
    * in the loop so check it on each iteration.
    */
-  while (uv__stream_fd(stream) != -1) {
+  for (count = 0; uv__stream_fd(stream) != -1; count++) {
     assert(stream->accepted_fd == -1);
 
+    /* Leave the rest of the backlog for the next tick. */
+    if (uv__io_accept_budget_exceeded(loop, count))
+      return;
+
 #if defined(UV_HAVE_KQUEUE)
     if (w->rcount <= 0)
       return;
@@ -550,6 +654,7 @@ void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
     }
 
     UV_DEC_BACKLOG(w)
+    uv__io_budget_charge(loop, 0);
     stream->accepted_fd = err;
     stream->connection_cb(stream, 0);
 
@@ -560,9 +665,17 @@ void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
     }
 
     if (stream->type == UV_TCP && (stream->flags & UV_TCP_SINGLE_ACCEPT)) {
-      /* Give other processes a chance to accept connections. */
-      struct timespec timeout = { 0, 1 };
-      nanosleep(&timeout, NULL);
+      /* Give other processes a chance to accept connections. The kernel only
+       * wakes up one of them for each connection when the socket is watched
+       * exclusively, the rest of the backlog is for whoever comes next.
+       */
+      if (UV__POLLEXCLUSIVE != 0)
+        return;
+
+      {
+        struct timespec timeout = { 0, 1 };
+        nanosleep(&timeout, NULL);
+      }
     }
   }
 }
@@ -607,6 +720,9 @@ int uv_accept(uv_stream_t* server, uv_stream_t* client) {
   client->flags |= UV_HANDLE_BOUND;
 
 done:
+  if (server->type == UV_TCP && ((uv_tcp_t*) server)->accept_member != NULL)
+    uv__accept_group_adopt((uv_tcp_t*) server, client, err);
+
   /* Process queued fds */
   if (server->queued_fds != NULL) {
     uv__stream_queued_fds_t* queued_fds;
@@ -729,6 +845,75 @@ static void uv__write_req_finish(uv_write_t* req) {
 }
 
 
+/* Accounts for `n` bytes written from the buffers of `req`. Returns the
+ * number of bytes that belong to the requests queued after it.
+ */
+static size_t uv__write_req_update(uv_stream_t* stream,
+                                   uv_write_t* req,
+                                   size_t n) {
+  uv_buf_t* buf;
+  size_t len;
+
+  assert(req->write_index < req->nbufs);
+  buf = req->bufs + req->write_index;
+
+  do {
+    len = n < buf->len ? n : buf->len;
+    buf->base += len;
+    buf->len -= len;
+    n -= len;
+
+    assert(stream->write_queue_size >= len);
+    stream->write_queue_size -= len;
+    uv__get_internal_fields(stream->loop)->mem.write_queued -= len;
+
+    /* Advance to the next buffer if this one is empty. */
+    if (buf->len == 0)
+      buf++;
+    /* Zero-length buffers at the end don't keep the request pending. */
+  } while (buf != req->bufs + req->nbufs && (n > 0 || buf->len == 0));
+
+  req->write_index = buf - req->bufs;
+
+  return n;
+}
+
+
+/* Gathers the pending buffers of the write requests at the head of the
+ * write queue into `iov`. Stops at the first request that sends a handle,
+ * those need a sendmsg() call of their own.
+ */
+static int uv__write_gather(uv_stream_t* stream,
+                            struct iovec* iov,
+                            int iovmax) {
+  uv_write_t* req;
+  QUEUE* q;
+  unsigned int i;
+  int iovcnt;
+
+  iovcnt = 0;
+
+  QUEUE_FOREACH(q, &stream->write_queue) {
+    req = QUEUE_DATA(q, uv_write_t, queue);
+    assert(req->handle == stream);
+
+    if (req->send_handle != NULL)
+      break;
+
+    for (i = req->write_index; i < req->nbufs; i++) {
+      if (iovcnt == iovmax)
+        return iovcnt;
+
+      iov[iovcnt].iov_base = req->bufs[i].base;
+      iov[iovcnt].iov_len = req->bufs[i].len;
+      iovcnt++;
+    }
+  }
+
+  return iovcnt;
+}
+
+
 static int uv__handle_fd(uv_handle_t* handle) {
   switch (handle->type) {
     case UV_NAMED_PIPE:
@@ -744,11 +929,14 @@ static int uv__handle_fd(uv_handle_t* handle) {
 }
 
 static void uv__write(uv_stream_t* stream) {
+  struct iovec gather[UV__WRITE_GATHER_MAX];
   struct iovec* iov;
   QUEUE* q;
   uv_write_t* req;
+  size_t limit;
   int iovmax;
   int iovcnt;
+  int i;
   ssize_t n;
 
 start:
@@ -772,10 +960,48 @@ start:
 
   iovmax = uv__getiovmax();
 
+  /* If more requests are queued behind this one, write their buffers with
+   * the same syscall. Requests that send a handle are never merged.
+   */
+  if (req->send_handle == NULL && QUEUE_NEXT(q) != &stream->write_queue) {
+    if (iovmax > UV__WRITE_GATHER_MAX)
+      iovmax = UV__WRITE_GATHER_MAX;
+    iov = gather;
+    iovcnt = uv__write_gather(stream, iov, iovmax);
+  }
+
   /* Limit iov count to avoid EINVALs from writev() */
   if (iovcnt > iovmax)
     iovcnt = iovmax;
 
+  /* Don't write more than the rate limit allows. The buffers of the request
+   * are not touched, a shortened copy of the iov is written instead.
+   */
+  limit = uv__rate_limit_take(stream);
+  if (limit == 0) {
+    uv__io_stop(stream->loop, &stream->io_watcher, POLLOUT);
+    uv__stream_osx_interrupt_select(stream);
+    return;
+  }
+
+  if (limit < uv__count_bufs((uv_buf_t*) iov, iovcnt)) {
+    if (iov != gather) {
+      if (iovcnt > UV__WRITE_GATHER_MAX)
+        iovcnt = UV__WRITE_GATHER_MAX;
+      memcpy(gather, iov, iovcnt * sizeof(*iov));
+      iov = gather;
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+      if (iov[i].iov_len >= limit) {
+        iov[i].iov_len = limit;
+        iovcnt = i + 1;
+        break;
+      }
+      limit -= iov[i].iov_len;
+    }
+  }
+
   /*
    * Now do the actual writev. Note that we've been updating the pointers
    * inside the iov each time we write. So there is no need to offset it.
@@ -845,6 +1071,13 @@ start:
 #endif
   }
 
+  /* A fast open socket without a cookie for the peer sends a bare SYN on the
+   * first write and fails it with EINPROGRESS. Nothing has been written, try
+   * again once the connection is established.
+   */
+  if (n < 0 && errno == EINPROGRESS)
+    errno = EAGAIN;
+
   if (n < 0) {
     if (errno != EAGAIN && errno != EWOULDBLOCK) {
       /* Error */
@@ -860,50 +1093,39 @@ start:
       goto start;
     }
   } else {
-    /* Successful write */
-
-    while (n >= 0) {
-      uv_buf_t* buf = &(req->bufs[req->write_index]);
-      size_t len = buf->len;
+    uv__rate_limit_charge(stream, n);
+    uv__stream_touch(stream);
 
-      assert(req->write_index < req->nbufs);
-
-      if ((size_t)n < len) {
-        buf->base += n;
-        buf->len -= n;
-        stream->write_queue_size -= n;
-        n = 0;
+    /* Successful write. Retire the requests it covered, in queue order. */
+    for (;;) {
+      n = uv__write_req_update(stream, req, n);
 
+      if (req->write_index < req->nbufs) {
         /* There is more to write. */
+        assert(n == 0);
+
         if (stream->flags & UV_STREAM_BLOCKING) {
           /*
            * If we're blocking then we should not be enabling the write
            * watcher - instead we need to try again.
            */
           goto start;
-        } else {
-          /* Break loop and ensure the watcher is pending. */
-          break;
         }
 
-      } else {
-        /* Finished writing the buf at index req->write_index. */
-        req->write_index++;
-
-        assert((size_t)n >= len);
-        n -= len;
+        /* Break loop and ensure the watcher is pending. */
+        break;
+      }
 
-        assert(stream->write_queue_size >= len);
-        stream->write_queue_size -= len;
+      /* Then we're done with this request! */
+      uv__write_req_finish(req);
 
-        if (req->write_index == req->nbufs) {
-          /* Then we're done! */
-          assert(n == 0);
-          uv__write_req_finish(req);
-          /* TODO: start trying to write the next request. */
-          return;
-        }
+      if (QUEUE_EMPTY(&stream->write_queue)) {
+        assert(n == 0);
+        return;
       }
+
+      q = QUEUE_HEAD(&stream->write_queue);
+      req = QUEUE_DATA(q, uv_write_t, queue);
     }
   }
 
@@ -913,6 +1135,13 @@ start:
   /* Only non-blocking streams should use the write_watcher. */
   assert(!(stream->flags & UV_STREAM_BLOCKING));
 
+  /* Out of tokens, the rate limit timer resumes writing. */
+  if (n == 0 && uv__rate_limit_take(stream) == 0) {
+    uv__io_stop(stream->loop, &stream->io_watcher, POLLOUT);
+    uv__stream_osx_interrupt_select(stream);
+    return;
+  }
+
   /* We're not done. */
   uv__io_start(stream->loop, &stream->io_watcher, POLLOUT);
 
@@ -924,6 +1153,7 @@ start:
 static void uv__write_callbacks(uv_stream_t* stream) {
   uv_write_t* req;
   QUEUE* q;
+  size_t size;
 
   while (!QUEUE_EMPTY(&stream->write_completed_queue)) {
     /* Pop a req off write_completed_queue. */
@@ -933,7 +1163,9 @@ static void uv__write_callbacks(uv_stream_t* stream) {
     uv__req_unregister(stream->loop, req);
 
     if (req->bufs != NULL) {
-      stream->write_queue_size -= uv__write_req_size(req);
+      size = uv__write_req_size(req);
+      stream->write_queue_size -= size;
+      uv__get_internal_fields(stream->loop)->mem.write_queued -= size;
       if (req->bufs != req->bufsml)
         uv__free(req->bufs);
       req->bufs = NULL;
@@ -1105,7 +1337,8 @@ static void uv__read(uv_stream_t* stream) {
   ssize_t nread;
   struct msghdr msg;
   char cmsg_space[CMSG_SPACE(UV__CMSG_FD_SIZE)];
-  int count;
+  unsigned int count;
+  size_t nbytes;
   int err;
   int is_ipc;
 
@@ -1114,7 +1347,8 @@ static void uv__read(uv_stream_t* stream) {
   /* Prevent loop starvation when the data comes in as fast as (or faster than)
    * we can read it. XXX Need to rearm fd if we switch to edge-triggered I/O.
    */
-  count = 32;
+  count = 0;
+  nbytes = 0;
 
   is_ipc = stream->type == UV_NAMED_PIPE && ((uv_pipe_t*) stream)->ipc;
 
@@ -1123,11 +1357,17 @@ static void uv__read(uv_stream_t* stream) {
    */
   while (stream->read_cb
       && (stream->flags & UV_STREAM_READING)
-      && (count-- > 0)) {
+      && !(stream->flags & UV__STREAM_READ_BLOCKED)
+      && !uv__io_budget_exceeded(stream->loop, count, nbytes)) {
     assert(stream->alloc_cb != NULL);
 
     buf = uv_buf_init(NULL, 0);
-    stream->alloc_cb((uv_handle_t*)stream, 64 * 1024, &buf);
+    stream->alloc_cb((uv_handle_t*)stream,
+                     uv__read_size_suggest((uv_handle_t*) stream,
+                                           uv__stream_fd(stream),
+                                           stream->read_size,
+                                           UV__READ_SIZE_MAX),
+                     &buf);
     if (buf.base == NULL || buf.len == 0) {
       /* User indicates it can't or won't handle the read. */
       stream->read_cb(stream, UV_ENOBUFS, &buf);
@@ -1187,6 +1427,18 @@ static void uv__read(uv_stream_t* stream) {
       /* Successful read */
       ssize_t buflen = buf.len;
 
+      uv__stream_count_nread(stream, nread);
+      uv__stream_touch(stream);
+      uv__io_budget_charge(stream->loop, nread);
+      nbytes += nread;
+      count++;
+
+      if (stream->flags & UV_HANDLE_READ_ADAPTIVE)
+        stream->read_size = uv__read_size_update(stream->read_size,
+                                                 buf.len,
+                                                 nread,
+                                                 UV__READ_SIZE_MAX);
+
       if (is_ipc) {
         err = uv__stream_recv_cmsg(stream, &msg);
         if (err != 0) {
@@ -1227,6 +1479,10 @@ int uv_shutdown(uv_shutdown_t* req, uv_stream_t* stream, uv_shutdown_cb cb) {
 
   assert(uv__stream_fd(stream) >= 0);
 
+  /* Data from uv_write_copy() goes out before the FIN. */
+  if (stream->write_copy != NULL)
+    uv__write_copy_flush(stream);
+
   /* Initialize request */
   uv__req_init(stream->loop, req, UV_SHUTDOWN);
   req->handle = stream;
@@ -1251,6 +1507,10 @@ static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
          stream->type == UV_TTY);
   assert(!(stream->flags & UV_CLOSING));
 
+  /* Hand off the data that uv_write_copy() coalesced since the last tick. */
+  if (stream->write_copy != NULL)
+    uv__write_copy_flush(stream);
+
   if (stream->connect_req) {
     uv__stream_connect(stream);
     return;
@@ -1273,6 +1533,7 @@ static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
    */
   if ((events & POLLHUP) &&
       (stream->flags & UV_STREAM_READING) &&
+      !(stream->flags & UV__STREAM_READ_BLOCKED) &&
       (stream->flags & UV_STREAM_READ_PARTIAL) &&
       !(stream->flags & UV_STREAM_READ_EOF)) {
     uv_buf_t buf = { NULL, 0 };
@@ -1285,6 +1546,7 @@ static void uv__stream_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   if (events & (POLLOUT | POLLERR | POLLHUP)) {
     uv__write(stream);
     uv__write_callbacks(stream);
+    uv__stream_low_watermark(stream);
 
     /* Write queue drained. */
     if (QUEUE_EMPTY(&stream->write_queue))
@@ -1327,6 +1589,13 @@ static void uv__stream_connect(uv_stream_t* stream) {
   if (error == -EINPROGRESS)
     return;
 
+  /* Data from uv_write_copy() waited for the connection. Queue it while
+   * connect_req is still set so that it's written by the next POLLOUT or
+   * canceled along with the rest of the write queue.
+   */
+  if (stream->write_copy != NULL)
+    uv__write_copy_flush(stream);
+
   stream->connect_req = NULL;
   uv__req_unregister(stream->loop, req);
 
@@ -1347,13 +1616,14 @@ static void uv__stream_connect(uv_stream_t* stream) {
 }
 
 
-int uv_write2(uv_write_t* req,
-              uv_stream_t* stream,
-              const uv_buf_t bufs[],
-              unsigned int nbufs,
-              uv_stream_t* send_handle,
-              uv_write_cb cb) {
+static int uv__write2(uv_write_t* req,
+                      uv_stream_t* stream,
+                      const uv_buf_t bufs[],
+                      unsigned int nbufs,
+                      uv_stream_t* send_handle,
+                      uv_write_cb cb) {
   int empty_queue;
+  size_t size;
 
   assert(nbufs > 0);
   assert((stream->type == UV_TCP ||
@@ -1378,6 +1648,10 @@ int uv_write2(uv_write_t* req,
       return -EBADF;
   }
 
+  /* Keep the order of the data, coalesced writes go out first. */
+  if (stream->write_copy != NULL)
+    uv__write_copy_flush(stream);
+
   /* It's legal for write_queue_size > 0 even when the write_queue is empty;
    * it means there are error-state requests in the write_completed_queue that
    * will touch up write_queue_size later, see also uv__write_req_finish().
@@ -1404,7 +1678,9 @@ int uv_write2(uv_write_t* req,
   memcpy(req->bufs, bufs, nbufs * sizeof(bufs[0]));
   req->nbufs = nbufs;
   req->write_index = 0;
-  stream->write_queue_size += uv__count_bufs(bufs, nbufs);
+  size = uv__count_bufs(bufs, nbufs);
+  stream->write_queue_size += size;
+  uv__get_internal_fields(stream->loop)->mem.write_queued += size;
 
   /* Append the request to write_queue. */
   QUEUE_INSERT_TAIL(&stream->write_queue, &req->queue);
@@ -1434,6 +1710,87 @@ int uv_write2(uv_write_t* req,
 }
 
 
+static void uv__stream_pause_reading(uv_stream_t* stream,
+                                     unsigned int reason) {
+  stream->flags |= reason;
+  uv__io_stop(stream->loop, &stream->io_watcher, POLLIN);
+  uv__stream_osx_interrupt_select(stream);
+}
+
+
+static void uv__stream_resume_reading(uv_stream_t* stream,
+                                      unsigned int reason) {
+  stream->flags &= ~reason;
+
+  if ((stream->flags & UV_STREAM_READING) &&
+      !(stream->flags & UV__STREAM_READ_BLOCKED) &&
+      uv__stream_fd(stream) >= 0) {
+    uv__io_start(stream->loop, &stream->io_watcher, POLLIN);
+    uv__stream_osx_interrupt_select(stream);
+  }
+}
+
+
+/* Marks the stream when the write queue crosses the high watermark. The mark
+ * stays until the drain callback runs, see uv__stream_low_watermark().
+ */
+static void uv__stream_high_watermark(uv_stream_t* stream) {
+  uv__stream_ext_t* ext;
+
+  if (stream->flags & UV_STREAM_HIGH_WATERMARK)
+    return;
+
+  ext = uv__handle_ext(stream);
+  if (ext == NULL ||
+      ext->write_high_watermark == 0 ||
+      stream->write_queue_size < ext->write_high_watermark) {
+    return;
+  }
+
+  stream->flags |= UV_STREAM_HIGH_WATERMARK;
+  if (ext->peer != NULL)
+    uv__stream_pause_reading(ext->peer, UV_STREAM_READ_PAUSED);
+}
+
+
+static void uv__stream_low_watermark(uv_stream_t* stream) {
+  uv__stream_ext_t* ext;
+
+  if (!(stream->flags & UV_STREAM_HIGH_WATERMARK))
+    return;
+
+  /* The mark is only set on streams that have the optional state. */
+  ext = uv__handle_ext(stream);
+  if (stream->write_queue_size > ext->write_low_watermark)
+    return;
+
+  stream->flags &= ~UV_STREAM_HIGH_WATERMARK;
+  if (ext->peer != NULL)
+    uv__stream_resume_reading(ext->peer, UV_STREAM_READ_PAUSED);
+
+  /* A write callback may have closed the stream. */
+  if (ext->drain_cb != NULL && !uv__is_closing(stream))
+    ext->drain_cb(stream);
+}
+
+
+int uv_write2(uv_write_t* req,
+              uv_stream_t* stream,
+              const uv_buf_t bufs[],
+              unsigned int nbufs,
+              uv_stream_t* send_handle,
+              uv_write_cb cb) {
+  int err;
+
+  err = uv__write2(req, stream, bufs, nbufs, send_handle, cb);
+  if (err != 0)
+    return err;
+
+  uv__stream_high_watermark(stream);
+  return 0;
+}
+
+
 /* The buffers to be written must remain valid until the callback is called.
  * This is not required for the uv_buf_t array.
  */
@@ -1461,13 +1818,23 @@ int uv_try_write(uv_stream_t* stream,
   size_t req_size;
   uv_write_t req;
 
-  /* Connecting or already writing some data */
-  if (stream->connect_req != NULL || stream->write_queue_size != 0)
+  /* Connecting */
+  if (stream->connect_req != NULL)
+    return -EAGAIN;
+
+  /* Data from uv_write_copy() goes out first. The flush writes it right away
+   * if it can, what is left makes the write queue non-empty.
+   */
+  if (stream->write_copy != NULL)
+    uv__write_copy_flush(stream);
+
+  /* Already writing some data */
+  if (stream->write_queue_size != 0)
     return -EAGAIN;
 
   has_pollout = uv__io_active(&stream->io_watcher, POLLOUT);
 
-  r = uv_write(&req, stream, bufs, nbufs, uv_try_write_cb);
+  r = uv__write2(&req, stream, bufs, nbufs, NULL, uv_try_write_cb);
   if (r != 0)
     return r;
 
@@ -1479,6 +1846,7 @@ int uv_try_write(uv_stream_t* stream,
     req_size = 0;
   written -= req_size;
   stream->write_queue_size -= req_size;
+  uv__get_internal_fields(stream->loop)->mem.write_queued -= req_size;
 
   /* Unqueue request, regardless of immediateness */
   QUEUE_REMOVE(&req.queue);
@@ -1500,6 +1868,106 @@ int uv_try_write(uv_stream_t* stream,
 }
 
 
+static void uv__write_copy_cb(uv_write_t* req, int status) {
+  uv__write_copy_t* wc;
+
+  wc = container_of(req, uv__write_copy_t, req);
+  if (wc->cb != NULL)
+    wc->cb(req->handle, status);
+
+  uv__free(wc);
+}
+
+
+/* Moves the buffer that uv_write_copy() is filling to the write queue. */
+static void uv__write_copy_flush(uv_stream_t* stream) {
+  uv__write_copy_t* wc;
+  uv_buf_t buf;
+  int err;
+
+  wc = stream->write_copy;
+  stream->write_copy = NULL;
+
+  /* uv_write2() registers the request again. */
+  uv__req_unregister(stream->loop, &wc->req);
+  uv__get_internal_fields(stream->loop)->mem.write_copy -= wc->size;
+
+  buf = uv_buf_init(wc->data, wc->len);
+  err = uv_write2(&wc->req, stream, &buf, 1, NULL, uv__write_copy_cb);
+  if (err < 0)
+    uv__write_copy_cb(&wc->req, err);
+}
+
+
+int uv_write_copy(uv_stream_t* stream,
+                  const uv_buf_t bufs[],
+                  unsigned int nbufs,
+                  uv_write_copy_cb cb) {
+  uv__write_copy_t* wc;
+  unsigned int i;
+  size_t size;
+  size_t len;
+
+  assert((stream->type == UV_TCP ||
+          stream->type == UV_NAMED_PIPE ||
+          stream->type == UV_TTY) &&
+         "uv_write_copy (unix) does not yet support other types of streams");
+
+  if (uv__stream_fd(stream) < 0)
+    return -EBADF;
+
+  len = uv__count_bufs(bufs, nbufs);
+  wc = stream->write_copy;
+
+  /* A buffer carries at most one callback, each callback runs exactly once.
+   * Also start over when the data doesn't fit in the remaining space.
+   */
+  if (wc != NULL) {
+    if ((wc->cb != NULL && cb != NULL) || len > wc->size - wc->len) {
+      uv__write_copy_flush(stream);
+      wc = NULL;
+    }
+  }
+
+  if (wc == NULL) {
+    size = len > UV__WRITE_COPY_SIZE ? len : UV__WRITE_COPY_SIZE;
+    wc = uv__malloc(sizeof(*wc) + size);
+    if (wc == NULL)
+      return -ENOMEM;
+
+    /* Keeps the loop alive until the buffer is handed off. */
+    uv__req_init(stream->loop, &wc->req, UV_WRITE);
+    wc->req.handle = stream;
+    wc->cb = NULL;
+    wc->data = (char*) (wc + 1);
+    wc->size = size;
+    wc->len = 0;
+    stream->write_copy = wc;
+    uv__get_internal_fields(stream->loop)->mem.write_copy += size;
+
+    /* Flush from the pending queue, before the loop blocks for I/O again.
+     * Not while connecting: uv__stream_io() would take the feed for the
+     * connect event. uv__stream_connect() flushes the buffer instead.
+     */
+    if (stream->connect_req == NULL)
+      uv__io_feed(stream->loop, &stream->io_watcher);
+  }
+
+  for (i = 0; i < nbufs; i++) {
+    memcpy(wc->data + wc->len, bufs[i].base, bufs[i].len);
+    wc->len += bufs[i].len;
+  }
+
+  if (cb != NULL)
+    wc->cb = cb;
+
+  if (wc->len == wc->size)
+    uv__write_copy_flush(stream);
+
+  return 0;
+}
+
+
 int uv_read_start(uv_stream_t* stream,
                   uv_alloc_cb alloc_cb,
                   uv_read_cb read_cb) {
@@ -1524,7 +1992,11 @@ int uv_read_start(uv_stream_t* stream,
   stream->read_cb = read_cb;
   stream->alloc_cb = alloc_cb;
 
-  uv__io_start(stream->loop, &stream->io_watcher, POLLIN);
+  /* A paused stream starts reading when its peer's write queue drains or when
+   * the loop is back under its memory budget.
+   */
+  if (!(stream->flags & UV__STREAM_READ_BLOCKED))
+    uv__io_start(stream->loop, &stream->io_watcher, POLLIN);
   uv__handle_start(stream);
   uv__stream_osx_interrupt_select(stream);
 
@@ -1575,9 +2047,16 @@ int uv___stream_fd(const uv_stream_t* handle) {
 #endif /* defined(__APPLE__) */
 
 
+static void uv__rate_limit_close_cb(uv_handle_t* handle) {
+  uv__free(container_of(handle, uv__rate_limit_t, timer));
+}
+
+
 void uv__stream_close(uv_stream_t* handle) {
   unsigned int i;
   uv__stream_queued_fds_t* queued_fds;
+  uv__stream_ext_t* ext;
+  uv__rate_limit_t* rl;
 
 #if defined(__APPLE__)
   /* Terminate select loop first */
@@ -1604,6 +2083,24 @@ void uv__stream_close(uv_stream_t* handle) {
   uv_read_stop(handle);
   uv__handle_stop(handle);
 
+  ext = uv__handle_ext(handle);
+  if (ext != NULL && ext->peer != NULL)
+    uv__stream_unpair(handle);
+
+  if (handle->flags & UV_STREAM_READ_THROTTLED) {
+    handle->flags &= ~UV_STREAM_READ_THROTTLED;
+    uv__get_internal_fields(handle->loop)->mem.throttled--;
+  }
+
+  if (ext != NULL && ext->idle_timeout != 0)
+    uv_stream_set_idle_timeout(handle, 0, NULL);
+
+  if (handle->rate_limit != NULL) {
+    rl = handle->rate_limit;
+    handle->rate_limit = NULL;
+    uv_close((uv_handle_t*) &rl->timer, uv__rate_limit_close_cb);
+  }
+
   if (handle->io_watcher.fd != -1) {
     /* Don't close stdio file descriptors.  Nothing good comes from it. */
     if (handle->io_watcher.fd > STDERR_FILENO)
@@ -1635,3 +2132,487 @@ int uv_stream_set_blocking(uv_stream_t* handle, int blocking) {
    */
   return uv__nonblock(uv__stream_fd(handle), !blocking);
 }
+
+
+int uv_stream_set_watermarks(uv_stream_t* handle,
+                             size_t high,
+                             size_t low,
+                             uv_drain_cb drain_cb) {
+  uv__stream_ext_t* ext;
+
+  if (high != 0 && low >= high)
+    return -EINVAL;
+
+  ext = uv__stream_ext(handle);
+  if (ext == NULL)
+    return -ENOMEM;
+
+  ext->write_high_watermark = high;
+  ext->write_low_watermark = low;
+  ext->drain_cb = drain_cb;
+
+  /* Disabling the watermarks lets the peer read again. */
+  if (high == 0 && (handle->flags & UV_STREAM_HIGH_WATERMARK)) {
+    handle->flags &= ~UV_STREAM_HIGH_WATERMARK;
+    if (ext->peer != NULL)
+      uv__stream_resume_reading(ext->peer, UV_STREAM_READ_PAUSED);
+  }
+
+  return 0;
+}
+
+
+int uv_stream_is_above_watermark(const uv_stream_t* handle) {
+  return !!(handle->flags & UV_STREAM_HIGH_WATERMARK);
+}
+
+
+static void uv__stream_unpair(uv_stream_t* stream) {
+  uv__stream_ext_t* ext;
+  uv_stream_t* peer;
+
+  ext = uv__handle_ext(stream);
+  peer = ext->peer;
+  ext->peer = NULL;
+  ext = uv__handle_ext(peer);
+  ext->peer = NULL;
+
+  if (stream->flags & UV_STREAM_HIGH_WATERMARK)
+    uv__stream_resume_reading(peer, UV_STREAM_READ_PAUSED);
+
+  if (peer->flags & UV_STREAM_HIGH_WATERMARK)
+    uv__stream_resume_reading(stream, UV_STREAM_READ_PAUSED);
+}
+
+
+int uv_stream_set_peer(uv_stream_t* handle, uv_stream_t* peer) {
+  uv__stream_ext_t* handle_ext;
+  uv__stream_ext_t* peer_ext;
+
+  if (handle == peer)
+    return -EINVAL;
+
+  if (uv__is_closing(handle) || (peer != NULL && uv__is_closing(peer)))
+    return -EINVAL;
+
+  if (peer == NULL) {
+    handle_ext = uv__handle_ext(handle);
+    if (handle_ext != NULL && handle_ext->peer != NULL)
+      uv__stream_unpair(handle);
+    return 0;
+  }
+
+  /* Both sides keep the pairing in their optional state. */
+  handle_ext = uv__stream_ext(handle);
+  peer_ext = uv__stream_ext(peer);
+  if (handle_ext == NULL || peer_ext == NULL)
+    return -ENOMEM;
+
+  if (handle_ext->peer != NULL)
+    uv__stream_unpair(handle);
+
+  if (peer_ext->peer != NULL)
+    uv__stream_unpair(peer);
+
+  handle_ext->peer = peer;
+  peer_ext->peer = handle;
+
+  if (handle->flags & UV_STREAM_HIGH_WATERMARK)
+    uv__stream_pause_reading(peer, UV_STREAM_READ_PAUSED);
+
+  if (peer->flags & UV_STREAM_HIGH_WATERMARK)
+    uv__stream_pause_reading(handle, UV_STREAM_READ_PAUSED);
+
+  return 0;
+}
+
+
+static int uv__stream_is_throttleable(uv_handle_t* handle) {
+  switch (handle->type) {
+    case UV_NAMED_PIPE:
+    case UV_TCP:
+    case UV_TTY:
+      return ((uv_stream_t*) handle)->flags & UV_STREAM_READING &&
+             !uv__is_closing(handle);
+    default:
+      return 0;
+  }
+}
+
+
+/* Called once per loop iteration when a memory budget is set. Above the
+ * budget, stops reading on the streams that read the most since the last
+ * time the budget was exceeded. Resumes them all once memory use falls
+ * below three quarters of the budget.
+ */
+void uv__stream_throttle(uv_loop_t* loop) {
+  uv__loop_internal_fields_t* lfields;
+  uv__stream_ext_t* ext;
+  uv_stream_t* stream;
+  uv_handle_t* handle;
+  size_t nstreams;
+  size_t total;
+  size_t used;
+  size_t budget;
+  QUEUE* q;
+
+  lfields = uv__get_internal_fields(loop);
+  budget = lfields->mem.budget;
+  used = lfields->mem.write_queued +
+         lfields->mem.send_queued +
+         lfields->mem.write_copy;
+
+  if (used > budget && budget != 0) {
+    /* The heaviest producers are the ones that read at least the average.
+     * Streams without the optional state haven't read under the budget.
+     */
+    nstreams = 0;
+    total = 0;
+    QUEUE_FOREACH(q, &loop->handle_queue) {
+      handle = QUEUE_DATA(q, uv_handle_t, handle_queue);
+      if (!uv__stream_is_throttleable(handle))
+        continue;
+
+      stream = (uv_stream_t*) handle;
+      ext = uv__handle_ext(stream);
+      if ((stream->flags & UV_STREAM_READ_THROTTLED) ||
+          ext == NULL ||
+          ext->throttle_nread == 0) {
+        continue;
+      }
+
+      total += ext->throttle_nread;
+      nstreams++;
+    }
+
+    if (nstreams == 0)
+      return;
+
+    QUEUE_FOREACH(q, &loop->handle_queue) {
+      handle = QUEUE_DATA(q, uv_handle_t, handle_queue);
+      if (!uv__stream_is_throttleable(handle))
+        continue;
+
+      stream = (uv_stream_t*) handle;
+      ext = uv__handle_ext(stream);
+      if ((stream->flags & UV_STREAM_READ_THROTTLED) || ext == NULL)
+        continue;
+
+      if (ext->throttle_nread != 0 &&
+          ext->throttle_nread >= total / nstreams) {
+        uv__stream_pause_reading(stream, UV_STREAM_READ_THROTTLED);
+        lfields->mem.throttled++;
+        lfields->mem.throttle_count++;
+      }
+
+      ext->throttle_nread = 0;
+    }
+
+    return;
+  }
+
+  if (lfields->mem.throttled == 0)
+    return;
+
+  if (budget != 0 && used > budget - budget / 4)
+    return;
+
+  QUEUE_FOREACH(q, &loop->handle_queue) {
+    handle = QUEUE_DATA(q, uv_handle_t, handle_queue);
+    switch (handle->type) {
+      case UV_NAMED_PIPE:
+      case UV_TCP:
+      case UV_TTY:
+        stream = (uv_stream_t*) handle;
+        if (stream->flags & UV_STREAM_READ_THROTTLED) {
+          uv__stream_resume_reading(stream, UV_STREAM_READ_THROTTLED);
+          lfields->mem.throttled--;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  assert(lfields->mem.throttled == 0);
+}
+
+
+/* Lets the kernel pace TCP sockets, which spreads the segments out evenly
+ * instead of sending bursts and needs no timer.
+ */
+static void uv__rate_limit_pace(uv_stream_t* stream, int fd) {
+#if defined(SO_MAX_PACING_RATE)
+  uv__rate_limit_t* rl;
+  unsigned int val;
+
+  rl = stream->rate_limit;
+  if (stream->type != UV_TCP)
+    return;
+
+  /* ~0U turns pacing off again, rates that don't fit use the token bucket. */
+  val = ~0U;
+  if (rl->rate != 0 && rl->rate < ~0U)
+    val = rl->rate;
+
+  if (setsockopt(fd, SOL_SOCKET, SO_MAX_PACING_RATE, &val, sizeof(val)) == 0)
+    rl->paced = (val != ~0U);
+  else
+    rl->paced = 0;
+#endif
+}
+
+
+/* Returns the number of bytes that uv__write() may write now, SIZE_MAX when
+ * there is no limit. Returns 0 and arms the timer when it has to wait.
+ */
+static size_t uv__rate_limit_take(uv_stream_t* stream) {
+  uv__rate_limit_t* rl;
+  uint64_t now;
+  double need;
+  double quantum;
+  double delay;
+
+  rl = stream->rate_limit;
+  if (rl == NULL || rl->rate == 0 || rl->paced)
+    return SIZE_MAX;
+
+  if (stream->flags & UV_STREAM_BLOCKING)
+    return SIZE_MAX;
+
+  now = uv__hrtime(UV_CLOCK_PRECISE);
+  rl->tokens += (double) (now - rl->last) * rl->rate / 1e9;
+  if (rl->tokens > rl->burst)
+    rl->tokens = rl->burst;
+  rl->last = now;
+
+  /* Don't dribble out a few bytes on every wakeup. */
+  quantum = (double) rl->rate * UV__RATE_LIMIT_INTERVAL / 1000;
+  if (quantum > rl->burst)
+    quantum = rl->burst;
+  if (quantum < 1)
+    quantum = 1;
+
+  need = stream->write_queue_size;
+  if (need > quantum)
+    need = quantum;
+
+  if (rl->tokens >= need && rl->tokens >= 1)
+    return (size_t) rl->tokens;
+
+  delay = (need - rl->tokens) * 1000 / rl->rate;
+  uv_timer_start(&rl->timer,
+                 uv__rate_limit_timer_cb,
+                 delay < 1 ? 1 : (uint64_t) delay + 1,
+                 0);
+  return 0;
+}
+
+
+static void uv__rate_limit_charge(uv_stream_t* stream, size_t n) {
+  uv__rate_limit_t* rl;
+
+  rl = stream->rate_limit;
+  if (rl == NULL || rl->rate == 0 || rl->paced)
+    return;
+
+  rl->tokens -= n;
+  if (rl->tokens < 0)
+    rl->tokens = 0;
+}
+
+
+static void uv__rate_limit_resume(uv_stream_t* stream) {
+  if (QUEUE_EMPTY(&stream->write_queue) ||
+      stream->connect_req != NULL ||
+      uv__stream_fd(stream) == -1) {
+    return;
+  }
+
+  uv__io_start(stream->loop, &stream->io_watcher, POLLOUT);
+  uv__stream_osx_interrupt_select(stream);
+}
+
+
+static void uv__rate_limit_timer_cb(uv_timer_t* timer) {
+  uv__rate_limit_t* rl;
+
+  rl = container_of(timer, uv__rate_limit_t, timer);
+  uv__rate_limit_resume(rl->stream);
+}
+
+
+int uv_stream_set_rate_limit(uv_stream_t* handle,
+                             uint64_t rate,
+                             size_t burst) {
+  uv__rate_limit_t* rl;
+
+  if (handle->flags & (UV_CLOSING | UV_CLOSED))
+    return -EINVAL;
+
+  rl = handle->rate_limit;
+  if (rl == NULL) {
+    if (rate == 0)
+      return 0;
+
+    rl = uv__malloc(sizeof(*rl));
+    if (rl == NULL)
+      return -ENOMEM;
+
+    uv_timer_init(handle->loop, &rl->timer);
+    rl->timer.flags |= UV__HANDLE_INTERNAL;
+    uv__handle_unref(&rl->timer);
+    rl->stream = handle;
+    rl->paced = 0;
+    handle->rate_limit = rl;
+  }
+
+  if (burst == 0)
+    burst = rate / 10;
+  if (burst == 0)
+    burst = 1;
+
+  rl->rate = rate;
+  rl->burst = burst;
+  rl->tokens = burst;
+  rl->last = uv__hrtime(UV_CLOCK_PRECISE);
+
+  if (uv__stream_fd(handle) != -1)
+    uv__rate_limit_pace(handle, uv__stream_fd(handle));
+
+  /* Writes that were waiting for tokens may go out now. */
+  uv_timer_stop(&rl->timer);
+  uv__rate_limit_resume(handle);
+
+  return 0;
+}
+
+
+/* Idle timeouts. Reads and writes only store the loop time in the stream.
+ * A single timer per loop walks the streams that have a timeout when the
+ * earliest of them may have expired, and reschedules itself for the next
+ * one. It runs at most once per UV__IDLE_SWEEP_SLACK-th of the shortest
+ * timeout.
+ */
+static void uv__stream_idle_sweep(uv_timer_t* timer);
+
+
+static void uv__stream_idle_schedule(uv_loop_t* loop, uint64_t deadline) {
+  uv_timer_t* timer;
+  uint64_t delay;
+
+  timer = uv__get_internal_fields(loop)->idle_timer;
+  if (uv__is_active(timer) && timer->timeout <= deadline)
+    return;
+
+  delay = deadline > loop->time ? deadline - loop->time : 0;
+  uv_timer_start(timer, uv__stream_idle_sweep, delay, 0);
+}
+
+
+static void uv__stream_idle_sweep(uv_timer_t* timer) {
+  uv__loop_internal_fields_t* lfields;
+  uv__stream_ext_t* ext;
+  uv_loop_t* loop;
+  uint64_t deadline;
+  uint64_t next;
+  uint64_t slack;
+  QUEUE queue;
+  QUEUE* q;
+
+  loop = timer->loop;
+  lfields = uv__get_internal_fields(loop);
+  next = UINT64_MAX;
+  slack = UINT64_MAX;
+
+  /* Like uv_walk(), the callbacks can close streams or change timeouts. The
+   * optional state of a closed stream lives until the close callback.
+   */
+  QUEUE_MOVE(&lfields->idle_streams, &queue);
+  while (!QUEUE_EMPTY(&queue)) {
+    q = QUEUE_HEAD(&queue);
+    ext = QUEUE_DATA(q, uv__stream_ext_t, idle_queue);
+
+    QUEUE_REMOVE(q);
+    QUEUE_INSERT_TAIL(&lfields->idle_streams, q);
+
+    if (ext->idle_last + ext->idle_timeout <= loop->time) {
+      ext->idle_last = loop->time;
+      ext->timeout_cb(ext->stream);
+
+      /* Closed, or the timeout was removed. */
+      if (ext->idle_timeout == 0)
+        continue;
+    }
+
+    deadline = ext->idle_last + ext->idle_timeout;
+    if (deadline < next)
+      next = deadline;
+    if (ext->idle_timeout / UV__IDLE_SWEEP_SLACK < slack)
+      slack = ext->idle_timeout / UV__IDLE_SWEEP_SLACK;
+  }
+
+  if (next == UINT64_MAX)
+    return;
+
+  if (next < loop->time + slack)
+    next = loop->time + slack;
+
+  uv__stream_idle_schedule(loop, next);
+}
+
+
+int uv_stream_set_idle_timeout(uv_stream_t* handle,
+                               uint64_t timeout,
+                               uv_timeout_cb cb) {
+  uv__loop_internal_fields_t* lfields;
+  uv__stream_ext_t* ext;
+  uv_timer_t* timer;
+  uv_loop_t* loop;
+
+  loop = handle->loop;
+  lfields = uv__get_internal_fields(loop);
+
+  if (timeout == 0) {
+    ext = uv__handle_ext(handle);
+    if (ext == NULL || ext->idle_timeout == 0)
+      return 0;
+
+    QUEUE_REMOVE(&ext->idle_queue);
+    ext->idle_timeout = 0;
+    ext->timeout_cb = NULL;
+
+    if (QUEUE_EMPTY(&lfields->idle_streams))
+      uv_timer_stop(lfields->idle_timer);
+
+    return 0;
+  }
+
+  if (cb == NULL || (handle->flags & (UV_CLOSING | UV_CLOSED)))
+    return -EINVAL;
+
+  ext = uv__stream_ext(handle);
+  if (ext == NULL)
+    return -ENOMEM;
+
+  /* The loop's sweep timer is created the first time it's needed. */
+  if (lfields->idle_timer == NULL) {
+    timer = uv__malloc(sizeof(*timer));
+    if (timer == NULL)
+      return -ENOMEM;
+    uv_timer_init(loop, timer);
+    uv__handle_unref(timer);
+    timer->flags |= UV__HANDLE_INTERNAL;
+    lfields->idle_timer = timer;
+  }
+
+  if (ext->idle_timeout == 0)
+    QUEUE_INSERT_TAIL(&lfields->idle_streams, &ext->idle_queue);
+
+  ext->idle_timeout = timeout;
+  ext->idle_last = loop->time;
+  ext->timeout_cb = cb;
+  uv__stream_idle_schedule(loop, loop->time + timeout);
+
+  return 0;
+}
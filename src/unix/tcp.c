@@ -22,11 +22,76 @@
 #include "uv.h"
 #include "internal.h"
 
+#include <stddef.h> /* offsetof */
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <assert.h>
 #include <errno.h>
 
+#if defined(__linux__)
+# ifndef TCP_FASTOPEN
+#  define TCP_FASTOPEN 23
+# endif
+# ifndef TCP_FASTOPEN_CONNECT
+#  define TCP_FASTOPEN_CONNECT 30
+# endif
+# ifndef TCP_NOTSENT_LOWAT
+#  define TCP_NOTSENT_LOWAT 25
+# endif
+
+/* Mirror of the kernel's struct tcp_info up to tcpi_delivery_rate. The C
+ * libraries disagree on how much of it their struct tcp_info covers, glibc
+ * stops at tcpi_total_retrans while musl follows the kernel. Older kernels
+ * return a shorter struct, the returned length tells which fields are valid.
+ */
+struct uv__tcp_info {
+  uint8_t tcpi_state;
+  uint8_t tcpi_ca_state;
+  uint8_t tcpi_retransmits;
+  uint8_t tcpi_probes;
+  uint8_t tcpi_backoff;
+  uint8_t tcpi_options;
+  uint8_t tcpi_wscale;  /* snd_wscale : 4, rcv_wscale : 4 */
+  uint8_t tcpi_flags;   /* delivery_rate_app_limited : 1 and newer bits */
+  uint32_t tcpi_rto;
+  uint32_t tcpi_ato;
+  uint32_t tcpi_snd_mss;
+  uint32_t tcpi_rcv_mss;
+  uint32_t tcpi_unacked;
+  uint32_t tcpi_sacked;
+  uint32_t tcpi_lost;
+  uint32_t tcpi_retrans;
+  uint32_t tcpi_fackets;
+  uint32_t tcpi_last_data_sent;
+  uint32_t tcpi_last_ack_sent;
+  uint32_t tcpi_last_data_recv;
+  uint32_t tcpi_last_ack_recv;
+  uint32_t tcpi_pmtu;
+  uint32_t tcpi_rcv_ssthresh;
+  uint32_t tcpi_rtt;
+  uint32_t tcpi_rttvar;
+  uint32_t tcpi_snd_ssthresh;
+  uint32_t tcpi_snd_cwnd;
+  uint32_t tcpi_advmss;
+  uint32_t tcpi_reordering;
+  uint32_t tcpi_rcv_rtt;
+  uint32_t tcpi_rcv_space;
+  uint32_t tcpi_total_retrans;
+  uint64_t tcpi_pacing_rate;
+  uint64_t tcpi_max_pacing_rate;
+  uint64_t tcpi_bytes_acked;
+  uint64_t tcpi_bytes_received;
+  uint32_t tcpi_segs_out;
+  uint32_t tcpi_segs_in;
+  uint32_t tcpi_notsent_bytes;
+  uint32_t tcpi_min_rtt;
+  uint32_t tcpi_data_segs_in;
+  uint32_t tcpi_data_segs_out;
+  uint64_t tcpi_delivery_rate;
+};
+#endif
+
 
 static int maybe_new_socket(uv_tcp_t* handle, int domain, int flags) {
   int sockfd;
@@ -64,6 +129,11 @@ int uv_tcp_init_ex(uv_loop_t* loop, uv_tcp_t* tcp, unsigned int flags) {
     return -EINVAL;
 
   uv__stream_init(loop, (uv_stream_t*)tcp, UV_TCP);
+  tcp->accept_group = NULL;
+  tcp->accept_member = NULL;
+  tcp->fastopen_qlen = 0;
+  tcp->connect_multi = NULL;
+  tcp->notsent_lowat = 0;
 
   /* If anything fails beyond this point we need to remove the handle from
    * the handle queue, since it was added by uv__handle_init in uv_stream_init.
@@ -107,6 +177,21 @@ int uv__tcp_bind(uv_tcp_t* tcp,
   if (setsockopt(tcp->io_watcher.fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)))
     return -errno;
 
+  if (flags & (UV_TCP_REUSEPORT | UV_TCP_REUSEPORT_CPU)) {
+    err = uv__socket_reuseport(tcp->io_watcher.fd);
+    if (err)
+      return err;
+  }
+
+  /* The group only exists once the socket listens, attach the program then. */
+  if (flags & UV_TCP_REUSEPORT_CPU) {
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+    tcp->flags |= UV_HANDLE_REUSEPORT_CPU;
+#else
+    return -ENOTSUP;
+#endif
+  }
+
 #ifdef IPV6_V6ONLY
   if (addr->sa_family == AF_INET6) {
     on = (flags & UV_TCP_IPV6ONLY) != 0;
@@ -163,6 +248,21 @@ int uv__tcp_connect(uv_connect_t* req,
 
   handle->delayed_error = 0;
 
+#if defined(__linux__)
+  /* Defers the SYN until the first write so that it can carry the data. The
+   * socket reports itself writable in the meantime. Kernels older than 4.11
+   * don't know about it and connect without fast open.
+   */
+  if (handle->flags & UV_TCP_FASTOPEN) {
+    r = 1;
+    setsockopt(uv__stream_fd(handle),
+               IPPROTO_TCP,
+               TCP_FASTOPEN_CONNECT,
+               &r,
+               sizeof(r));
+  }
+#endif
+
   do {
     errno = 0;
     r = connect(uv__stream_fd(handle), addr, addrlen);
@@ -201,6 +301,267 @@ int uv__tcp_connect(uv_connect_t* req,
 }
 
 
+/* Happy Eyeballs (RFC 8305). Every address gets a hidden TCP handle of its
+ * own. The next attempt starts when the previous one fails or when it hasn't
+ * connected after UV__CONNECT_ATTEMPT_DELAY milliseconds, whichever comes
+ * first. The first attempt that connects hands its socket over to the user's
+ * handle and the others are closed.
+ */
+#define UV__CONNECT_ATTEMPT_DELAY 250
+
+struct uv__connect_attempt_s {
+  uv_tcp_t handle;
+  uv_connect_t req;
+  struct sockaddr_storage addr;
+  int closed;
+};
+
+struct uv__connect_multi_s {
+  uv_connect_t* req;
+  uv_tcp_t* handle;  /* NULL once the race is over. */
+  uv_timer_t timer;
+  struct uv__connect_attempt_s* attempts;
+  unsigned int nattempts;
+  unsigned int next;
+  unsigned int pending;
+  unsigned int refs;
+  int error;
+};
+
+
+static void uv__connect_multi_close_cb(uv_handle_t* handle) {
+  struct uv__connect_multi_s* multi;
+
+  multi = handle->data;
+  if (--multi->refs == 0)
+    uv__free(multi);
+}
+
+
+static void uv__connect_multi_stop(struct uv__connect_multi_s* multi) {
+  struct uv__connect_attempt_s* a;
+  unsigned int i;
+
+  multi->handle->connect_multi = NULL;
+  multi->handle = NULL;
+  uv_close((uv_handle_t*) &multi->timer, uv__connect_multi_close_cb);
+
+  for (i = 0; i < multi->next; i++) {
+    a = multi->attempts + i;
+    if (!a->closed) {
+      a->closed = 1;
+      uv_close((uv_handle_t*) &a->handle, uv__connect_multi_close_cb);
+    }
+  }
+}
+
+
+static void uv__connect_multi_finish(struct uv__connect_multi_s* multi,
+                                     int status) {
+  uv_connect_t* req;
+  uv_tcp_t* handle;
+
+  req = multi->req;
+  handle = multi->handle;
+  uv__connect_multi_stop(multi);
+
+  handle->connect_req = NULL;
+  uv__req_unregister(handle->loop, req);
+  req->cb(req, status);
+}
+
+
+static void uv__connect_multi_attempt_cb(uv_connect_t* req, int status);
+static void uv__connect_multi_timer_cb(uv_timer_t* timer);
+
+
+/* Starts attempts until one of them is in progress or there are none left. */
+static void uv__connect_multi_next(struct uv__connect_multi_s* multi) {
+  struct uv__connect_attempt_s* a;
+  int err;
+
+  while (multi->next < multi->nattempts) {
+    a = multi->attempts + multi->next++;
+    uv_tcp_init(multi->handle->loop, &a->handle);
+    a->handle.flags |= UV__HANDLE_INTERNAL;
+    a->handle.data = multi;
+    multi->refs++;
+
+    err = uv_tcp_connect(&a->req,
+                         &a->handle,
+                         (const struct sockaddr*) &a->addr,
+                         uv__connect_multi_attempt_cb);
+    if (err == 0) {
+      multi->pending++;
+      uv_timer_start(&multi->timer,
+                     uv__connect_multi_timer_cb,
+                     UV__CONNECT_ATTEMPT_DELAY,
+                     0);
+      return;
+    }
+
+    multi->error = err;
+    a->closed = 1;
+    uv_close((uv_handle_t*) &a->handle, uv__connect_multi_close_cb);
+  }
+}
+
+
+static void uv__connect_multi_timer_cb(uv_timer_t* timer) {
+  uv__connect_multi_next(timer->data);
+}
+
+
+static void uv__connect_multi_attempt_cb(uv_connect_t* req, int status) {
+  struct uv__connect_attempt_s* a;
+  struct uv__connect_multi_s* multi;
+  int err;
+  int fd;
+
+  a = container_of(req, struct uv__connect_attempt_s, req);
+  multi = a->handle.data;
+
+  /* Closed after the race was decided. */
+  if (multi->handle == NULL)
+    return;
+
+  multi->pending--;
+
+  if (status == 0) {
+    /* Take the socket away from the attempt before it is closed. */
+    fd = uv__stream_fd(&a->handle);
+    uv__io_stop(a->handle.loop, &a->handle.io_watcher, POLLIN | POLLOUT);
+    a->handle.io_watcher.fd = -1;
+
+    /* The handle takes the address family of the attempt that won. */
+    if (a->addr.ss_family == AF_INET6)
+      multi->handle->flags |= UV_HANDLE_IPV6;
+
+    err = uv__stream_open((uv_stream_t*) multi->handle,
+                          fd,
+                          UV_STREAM_READABLE | UV_STREAM_WRITABLE);
+    if (err)
+      uv__close(fd);
+
+    uv__connect_multi_finish(multi, err);
+    return;
+  }
+
+  multi->error = status;
+  a->closed = 1;
+  uv_close((uv_handle_t*) &a->handle, uv__connect_multi_close_cb);
+
+  uv__connect_multi_next(multi);
+  if (multi->pending == 0)
+    uv__connect_multi_finish(multi, multi->error);
+}
+
+
+/* Returns the first address at or after `ai` that a TCP handle can connect
+ * to. AF_UNSPEC matches both IPv4 and IPv6.
+ */
+static const struct addrinfo* uv__connect_multi_find(const struct addrinfo* ai,
+                                                     int family) {
+  for (; ai != NULL; ai = ai->ai_next) {
+    if (ai->ai_family != AF_INET && ai->ai_family != AF_INET6)
+      continue;
+    if (family != AF_UNSPEC && ai->ai_family != family)
+      continue;
+    if (ai->ai_socktype != 0 && ai->ai_socktype != SOCK_STREAM)
+      continue;
+    if (ai->ai_protocol != 0 && ai->ai_protocol != IPPROTO_TCP)
+      continue;
+    if (ai->ai_addr == NULL || ai->ai_addrlen > sizeof(struct sockaddr_storage))
+      continue;
+    return ai;
+  }
+
+  return NULL;
+}
+
+
+int uv_tcp_connect_multi(uv_connect_t* req,
+                         uv_tcp_t* handle,
+                         const struct addrinfo* ai,
+                         uv_connect_cb cb) {
+  struct uv__connect_multi_s* multi;
+  const struct addrinfo* cur[2];
+  const struct addrinfo* p;
+  int family[2];
+  unsigned int n;
+  unsigned int i;
+  unsigned int k;
+  int err;
+
+  if (handle->connect_req != NULL)
+    return -EALREADY;
+
+  if (uv__stream_fd(handle) != -1)
+    return -EBUSY;
+
+  n = 0;
+  for (p = uv__connect_multi_find(ai, AF_UNSPEC);
+       p != NULL;
+       p = uv__connect_multi_find(p->ai_next, AF_UNSPEC)) {
+    n++;
+  }
+
+  if (n == 0)
+    return -EINVAL;
+
+  multi = uv__calloc(1, sizeof(*multi) + n * sizeof(*multi->attempts));
+  if (multi == NULL)
+    return -ENOMEM;
+
+  multi->attempts = (struct uv__connect_attempt_s*) (multi + 1);
+  multi->nattempts = n;
+
+  /* Alternate between the address families, starting with the family of the
+   * first address.
+   */
+  family[0] = uv__connect_multi_find(ai, AF_UNSPEC)->ai_family;
+  family[1] = family[0] == AF_INET6 ? AF_INET : AF_INET6;
+  cur[0] = uv__connect_multi_find(ai, family[0]);
+  cur[1] = uv__connect_multi_find(ai, family[1]);
+
+  for (i = 0, k = 0; i < n; k ^= 1) {
+    if (cur[k] == NULL)
+      continue;
+    memcpy(&multi->attempts[i++].addr, cur[k]->ai_addr, cur[k]->ai_addrlen);
+    cur[k] = uv__connect_multi_find(cur[k]->ai_next, family[k]);
+  }
+
+  multi->req = req;
+  multi->handle = handle;
+  multi->refs = 1;
+  uv_timer_init(handle->loop, &multi->timer);
+  multi->timer.flags |= UV__HANDLE_INTERNAL;
+  multi->timer.data = multi;
+
+  uv__req_init(handle->loop, req, UV_CONNECT);
+  req->cb = cb;
+  req->handle = (uv_stream_t*) handle;
+  QUEUE_INIT(&req->queue);
+  handle->connect_req = req;
+  handle->connect_multi = multi;
+
+  uv__connect_multi_next(multi);
+
+  /* Don't call back when every address failed right away, uv_tcp_connect()
+   * doesn't either.
+   */
+  if (multi->pending == 0) {
+    err = multi->error;
+    uv__connect_multi_stop(multi);
+    handle->connect_req = NULL;
+    uv__req_unregister(handle->loop, req);
+    return err;
+  }
+
+  return 0;
+}
+
+
 int uv_tcp_open(uv_tcp_t* handle, uv_os_sock_t sock) {
   int err;
 
@@ -258,6 +619,15 @@ int uv_tcp_getpeername(const uv_tcp_t* handle,
 }
 
 
+#if defined(__linux__)
+static int uv__tcp_fastopen_listen(int fd, unsigned int qlen) {
+  if (setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen)))
+    return -errno;
+  return 0;
+}
+#endif
+
+
 int uv_tcp_listen(uv_tcp_t* tcp, int backlog, uv_connection_cb cb) {
   static int single_accept = -1;
   int err;
@@ -298,15 +668,41 @@ int uv_tcp_listen(uv_tcp_t* tcp, int backlog, uv_connection_cb cb) {
   }
 #endif
 
+#if defined(__linux__)
+  /* Not fatal, the handle accepts regular connections either way. */
+  if (tcp->flags & UV_TCP_FASTOPEN) {
+    if (tcp->fastopen_qlen != 0)
+      uv__tcp_fastopen_listen(tcp->io_watcher.fd, tcp->fastopen_qlen);
+    else
+      uv__tcp_fastopen_listen(tcp->io_watcher.fd, backlog);
+  }
+#endif
+
   if (listen(tcp->io_watcher.fd, backlog))
     return -errno;
 
+  /* The program can't be attached before listen(): it would give the socket
+   * a reuseport group of its own, which then can't join the group of the
+   * other listeners. On failure, shutdown(SHUT_RD) takes the socket back out
+   * of the listening state and the group. It can listen again later.
+   */
+  if (tcp->flags & UV_HANDLE_REUSEPORT_CPU) {
+    err = uv__socket_steer_cpu(tcp->io_watcher.fd);
+    if (err) {
+      shutdown(tcp->io_watcher.fd, SHUT_RD);
+      return err;
+    }
+  }
+
   tcp->connection_cb = cb;
   tcp->flags |= UV_HANDLE_BOUND;
 
   /* Start listening for connections. */
   tcp->io_watcher.cb = uv__server_io;
-  uv__io_start(tcp->loop, &tcp->io_watcher, POLLIN);
+  if (tcp->flags & UV_TCP_SINGLE_ACCEPT)
+    uv__io_start(tcp->loop, &tcp->io_watcher, POLLIN | UV__POLLEXCLUSIVE);
+  else
+    uv__io_start(tcp->loop, &tcp->io_watcher, POLLIN);
 
   return 0;
 }
@@ -341,6 +737,17 @@ int uv__tcp_keepalive(int fd, int on, unsigned int delay) {
 }
 
 
+int uv__tcp_notsent_lowat(int fd, unsigned int bytes) {
+#if defined(TCP_NOTSENT_LOWAT)
+  if (setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &bytes, sizeof(bytes)))
+    return -errno;
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
 int uv_tcp_nodelay(uv_tcp_t* handle, int on) {
   int err;
 
@@ -381,15 +788,422 @@ int uv_tcp_keepalive(uv_tcp_t* handle, int on, unsigned int delay) {
 }
 
 
+int uv_tcp_notsent_lowat(uv_tcp_t* handle, unsigned int bytes) {
+#if defined(TCP_NOTSENT_LOWAT)
+  int err;
+
+  if (uv__stream_fd(handle) != -1) {
+    err = uv__tcp_notsent_lowat(uv__stream_fd(handle), bytes);
+    if (err)
+      return err;
+  }
+
+  handle->notsent_lowat = bytes;
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+static int uv__tcp_get_info(int fd, uv_tcp_info_t* info) {
+#if defined(__linux__)
+  struct uv__tcp_info ti;
+  socklen_t len;
+  uint64_t packets;
+
+  memset(&ti, 0, sizeof(ti));
+  len = sizeof(ti);
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &ti, &len))
+    return -errno;
+
+  /* Same as tcp_packets_in_flight() in the kernel. */
+  packets = ti.tcpi_unacked;
+  packets -= ti.tcpi_sacked + ti.tcpi_lost;
+  packets += ti.tcpi_retrans;
+
+  info->rtt = ti.tcpi_rtt;
+  info->rtt_var = ti.tcpi_rttvar;
+  info->cwnd = (uint64_t) ti.tcpi_snd_cwnd * ti.tcpi_snd_mss;
+  info->retransmits = ti.tcpi_total_retrans;
+  info->bytes_in_flight = packets * ti.tcpi_snd_mss;
+  info->delivery_rate = 0;
+  if (len >= offsetof(struct uv__tcp_info, tcpi_delivery_rate) +
+             sizeof(ti.tcpi_delivery_rate)) {
+    info->delivery_rate = ti.tcpi_delivery_rate;
+  }
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+int uv_tcp_get_info(const uv_tcp_t* handle, uv_tcp_info_t* info) {
+  if (uv__stream_fd(handle) == -1)
+    return -EBADF;
+
+  return uv__tcp_get_info(uv__stream_fd(handle), info);
+}
+
+
+int uv_tcp_get_info_all(uv_loop_t* loop, uv_tcp_info_cb cb, void* arg) {
+#if defined(__linux__)
+  uv_tcp_info_t info;
+  uv_tcp_t* handle;
+  QUEUE queue;
+  QUEUE* q;
+  int count;
+  int err;
+
+  /* Like uv_walk(), so that the callback can close handles or open new ones;
+   * handles that are opened by the callback are not visited.
+   */
+  count = 0;
+  QUEUE_MOVE(&loop->handle_queue, &queue);
+  while (!QUEUE_EMPTY(&queue)) {
+    q = QUEUE_HEAD(&queue);
+    handle = QUEUE_DATA(q, uv_tcp_t, handle_queue);
+
+    QUEUE_REMOVE(q);
+    QUEUE_INSERT_TAIL(&loop->handle_queue, q);
+
+    if (handle->type != UV_TCP)
+      continue;
+    if (handle->flags & (UV__HANDLE_INTERNAL | UV_CLOSING | UV_CLOSED))
+      continue;
+    if (uv__stream_fd(handle) == -1 || handle->io_watcher.cb == uv__server_io)
+      continue;
+
+    err = uv__tcp_get_info(uv__stream_fd(handle), &info);
+    if (err)
+      continue;
+
+    count++;
+    cb(handle, &info, arg);
+  }
+
+  return count;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+int uv_tcp_fastopen(uv_tcp_t* handle, int enable, unsigned int qlen) {
+#if defined(__linux__)
+  int err;
+
+  /* Listening handles are switched over right away, everything else when it
+   * starts to listen or connect.
+   */
+  if (handle->io_watcher.cb == uv__server_io) {
+    err = uv__tcp_fastopen_listen(uv__stream_fd(handle),
+                                  !enable ? 0 : qlen ? qlen : SOMAXCONN);
+    if (err)
+      return err;
+  }
+
+  if (enable) {
+    handle->flags |= UV_TCP_FASTOPEN;
+    handle->fastopen_qlen = qlen;
+  } else {
+    handle->flags &= ~UV_TCP_FASTOPEN;
+    handle->fastopen_qlen = 0;
+  }
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+/* Accept groups. The listening handle accepts connections on its own loop and
+ * appends the file descriptors to the queue of one of the workers. A worker
+ * polls the read end of a pipe that is written to when its queue stops being
+ * empty and drained once the worker emptied the queue again. All of this is
+ * done under the group's mutex; it is held just long enough to move one file
+ * descriptor.
+ */
+int uv_accept_group_init(uv_accept_group_t* group, unsigned int flags) {
+  if (flags & ~UV_ACCEPT_GROUP_LEAST_CONNECTIONS)
+    return -EINVAL;
+
+  QUEUE_INIT(&group->members);
+  group->flags = flags;
+
+  return uv_mutex_init(&group->mutex);
+}
+
+
+void uv_accept_group_destroy(uv_accept_group_t* group) {
+  assert(QUEUE_EMPTY(&group->members));
+  uv_mutex_destroy(&group->mutex);
+}
+
+
+static struct uv__accept_member_s* uv__accept_group_pick(
+    uv_accept_group_t* group) {
+  struct uv__accept_member_s* member;
+  struct uv__accept_member_s* m;
+  QUEUE* q;
+
+  if (QUEUE_EMPTY(&group->members))
+    return NULL;
+
+  q = QUEUE_HEAD(&group->members);
+  member = QUEUE_DATA(q, struct uv__accept_member_s, queue);
+
+  if (group->flags & UV_ACCEPT_GROUP_LEAST_CONNECTIONS) {
+    QUEUE_FOREACH(q, &group->members) {
+      m = QUEUE_DATA(q, struct uv__accept_member_s, queue);
+      if (m->connections < member->connections)
+        member = m;
+    }
+  }
+
+  /* Move it to the back, that makes ties go round-robin. */
+  QUEUE_REMOVE(&member->queue);
+  QUEUE_INSERT_TAIL(&group->members, &member->queue);
+
+  return member;
+}
+
+
+static int uv__accept_member_push(struct uv__accept_member_s* member, int fd) {
+  unsigned int size;
+  int* fds;
+  int r;
+
+  if (member->nfds == member->size) {
+    size = member->size == 0 ? 8 : member->size * 2;
+    fds = uv__realloc(member->fds, size * sizeof(*fds));
+    if (fds == NULL)
+      return -ENOMEM;
+    member->fds = fds;
+    member->size = size;
+  }
+
+  member->fds[member->nfds++] = fd;
+  member->connections++;
+
+  if (member->nfds == 1) {
+    do
+      r = write(member->wakeup_fd, "", 1);
+    while (r == -1 && errno == EINTR);
+    /* EAGAIN means the pipe is full and the worker will wake up anyway. */
+  }
+
+  return 0;
+}
+
+
+static void uv__accept_group_connection_cb(uv_stream_t* server, int status) {
+  struct uv__accept_member_s* member;
+  uv_accept_group_t* group;
+  int err;
+  int fd;
+
+  /* EMFILE and friends. There is no one to report them to. */
+  if (status != 0)
+    return;
+
+  group = ((uv_tcp_t*) server)->accept_group;
+  fd = server->accepted_fd;
+  server->accepted_fd = -1;
+
+  uv_mutex_lock(&group->mutex);
+  member = uv__accept_group_pick(group);
+  err = -ENOENT;
+  if (member != NULL)
+    err = uv__accept_member_push(member, fd);
+  uv_mutex_unlock(&group->mutex);
+
+  if (err != 0)
+    uv__close(fd);
+}
+
+
+int uv_accept_group_listen(uv_accept_group_t* group,
+                           uv_tcp_t* server,
+                           int backlog) {
+  if (server->accept_member != NULL)
+    return -EINVAL;
+
+  server->accept_group = group;
+  return uv_listen((uv_stream_t*) server,
+                   backlog,
+                   uv__accept_group_connection_cb);
+}
+
+
+static void uv__accept_group_io(uv_loop_t* loop,
+                                uv__io_t* w,
+                                unsigned int events) {
+  struct uv__accept_member_s* member;
+  uv_tcp_t* handle;
+  unsigned int count;
+  char buf[32];
+  ssize_t r;
+  int fd;
+
+  handle = container_of(w, uv_tcp_t, io_watcher);
+  member = handle->accept_member;
+  assert(events == POLLIN);
+
+  /* connection_cb can close the worker (and free the member), check on each
+   * iteration.
+   */
+  for (count = 0; uv__stream_fd(handle) != -1; count++) {
+    assert(handle->accepted_fd == -1);
+
+    if (uv__io_accept_budget_exceeded(loop, count))
+      return;
+
+    uv_mutex_lock(&member->group->mutex);
+
+    if (member->nfds == 0) {
+      do
+        r = read(w->fd, buf, sizeof(buf));
+      while (r > 0 || (r == -1 && errno == EINTR));
+      uv_mutex_unlock(&member->group->mutex);
+      return;
+    }
+
+    fd = member->fds[0];
+    member->nfds--;
+    memmove(member->fds, member->fds + 1, member->nfds * sizeof(*member->fds));
+    uv_mutex_unlock(&member->group->mutex);
+
+    uv__io_budget_charge(loop, 0);
+    handle->accepted_fd = fd;
+    handle->connection_cb((uv_stream_t*) handle, 0);
+
+    if (handle->accepted_fd != -1) {
+      /* The user hasn't called uv_accept() yet. */
+      uv__io_stop(loop, &handle->io_watcher, POLLIN);
+      return;
+    }
+  }
+}
+
+
+int uv_accept_group_join(uv_accept_group_t* group,
+                         uv_tcp_t* worker,
+                         uv_connection_cb cb) {
+  struct uv__accept_member_s* member;
+  int fds[2];
+  int err;
+
+  if (cb == NULL)
+    return -EINVAL;
+
+  if (uv__stream_fd(worker) != -1 || worker->accept_group != NULL)
+    return -EBUSY;
+
+  member = uv__calloc(1, sizeof(*member));
+  if (member == NULL)
+    return -ENOMEM;
+
+  err = uv__make_pipe(fds, UV__F_NONBLOCK);
+  if (err) {
+    uv__free(member);
+    return err;
+  }
+
+  member->group = group;
+  member->handle = worker;
+  member->wakeup_fd = fds[1];
+
+  worker->accept_member = member;
+  worker->connection_cb = cb;
+  uv__io_init(&worker->io_watcher, uv__accept_group_io, fds[0]);
+  uv__io_start(worker->loop, &worker->io_watcher, POLLIN);
+  uv__handle_start(worker);
+
+  uv_mutex_lock(&group->mutex);
+  QUEUE_INSERT_TAIL(&group->members, &member->queue);
+  uv_mutex_unlock(&group->mutex);
+
+  return 0;
+}
+
+
+/* Called when the worker or one of the connections that it accepted closes.
+ * The last one to go frees the member.
+ */
+static void uv__accept_member_release(struct uv__accept_member_s* member,
+                                      uv_tcp_t* handle) {
+  uv_mutex_t* mutex;
+  int done;
+
+  mutex = &member->group->mutex;
+  uv_mutex_lock(mutex);
+
+  if (member->handle == handle) {
+    QUEUE_REMOVE(&member->queue);
+    member->handle = NULL;
+
+    while (member->nfds > 0) {
+      uv__close(member->fds[--member->nfds]);
+      member->connections--;
+    }
+
+    /* uv__stream_close() closes it. */
+    if (handle->accepted_fd != -1)
+      member->connections--;
+
+    uv__close(member->wakeup_fd);
+  } else {
+    member->connections--;
+  }
+
+  done = member->handle == NULL && member->connections == 0;
+  uv_mutex_unlock(mutex);
+
+  if (done) {
+    uv__free(member->fds);
+    uv__free(member);
+  }
+}
+
+
+void uv__accept_group_adopt(uv_tcp_t* worker, uv_stream_t* client, int err) {
+  if (err == 0 && client->type == UV_TCP)
+    ((uv_tcp_t*) client)->accept_member = worker->accept_member;
+  else
+    /* Can't tell when it closes, stop counting it right away. */
+    uv__accept_member_release(worker->accept_member, NULL);
+}
+
+
 int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable) {
   if (enable)
     handle->flags &= ~UV_TCP_SINGLE_ACCEPT;
   else
     handle->flags |= UV_TCP_SINGLE_ACCEPT;
+
+  /* Switch a listening socket over right away. */
+  if (handle->io_watcher.cb == uv__server_io) {
+    handle->io_watcher.pevents &= ~UV__POLLEXCLUSIVE;
+    if (!enable)
+      handle->io_watcher.pevents |= UV__POLLEXCLUSIVE;
+    if (uv__io_active(&handle->io_watcher, POLLIN))
+      uv__io_start(handle->loop, &handle->io_watcher, POLLIN);
+  }
+
   return 0;
 }
 
 
 void uv__tcp_close(uv_tcp_t* handle) {
+  if (handle->connect_multi != NULL)
+    uv__connect_multi_stop(handle->connect_multi);
+  if (handle->accept_member != NULL) {
+    uv__accept_member_release(handle->accept_member, handle);
+    handle->accept_member = NULL;
+  }
   uv__stream_close((uv_stream_t*)handle);
 }
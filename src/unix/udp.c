@@ -27,6 +27,9 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
+#if defined(__linux__)
+# include <netinet/udp.h>
+#endif
 #if defined(__MVS__)
 #include <xti.h>
 #endif
@@ -39,6 +42,77 @@
 # define IPV6_DROP_MEMBERSHIP IPV6_LEAVE_GROUP
 #endif
 
+/* Every datagram that recvmmsg() receives gets a slot of the largest possible
+ * size in the buffer from the alloc callback, so none can be truncated.
+ */
+#define UV__UDP_DGRAM_MAXSIZE (64 * 1024)
+
+/* Upper bound for the number of datagrams per recvmmsg() or sendmmsg() call. */
+#define UV__MMSG_MAXWIDTH 32
+
+/* Largest UDP payload, which also caps what one UDP_SEGMENT send can carry. */
+#define UV__UDP_PAYLOAD_MAX4 65507
+#define UV__UDP_PAYLOAD_MAX6 65527
+
+/* Segments per UDP_SEGMENT send that every kernel with GSO accepts. */
+#define UV__UDP_GSO_MAXSEGS 64
+
+#if defined(__linux__)
+# ifndef SOL_UDP
+#  define SOL_UDP 17
+# endif
+# ifndef UDP_SEGMENT
+#  define UDP_SEGMENT 103
+# endif
+# ifndef UDP_GRO
+#  define UDP_GRO 104
+# endif
+# ifndef SO_RXQ_OVFL
+#  define SO_RXQ_OVFL 40
+# endif
+# ifndef SO_MEMINFO
+#  define SO_MEMINFO 55
+# endif
+/* SK_MEMINFO_DROPS from <linux/sock_diag.h>, an enum that can't be tested. */
+# define UV__SK_MEMINFO_DROPS 8
+#endif
+
+/* Receive timestamps: nanoseconds where the platform has them. */
+#if defined(SO_TIMESTAMPNS)
+# define UV__SO_TIMESTAMP SO_TIMESTAMPNS
+# define UV__SCM_TIMESTAMP SCM_TIMESTAMPNS
+#elif defined(SO_TIMESTAMP)
+# define UV__SO_TIMESTAMP SO_TIMESTAMP
+# define UV__SCM_TIMESTAMP SCM_TIMESTAMP
+#endif
+
+/* Room for the control messages that the receive path asks for: the GRO
+ * segment size, the drop counter, a timestamp and an IPv4 or IPv6 pktinfo.
+ */
+#define UV__UDP_CMSG_SPACE                                                    \
+  (CMSG_SPACE(sizeof(int)) +                                                  \
+   CMSG_SPACE(sizeof(uint32_t)) +                                             \
+   CMSG_SPACE(sizeof(struct timespec)) +                                      \
+   CMSG_SPACE(sizeof(struct in6_addr) + sizeof(unsigned int)))
+
+/* Aligned like struct cmsghdr, which can't be an array member itself. */
+union uv__udp_cmsg_buf {
+  char buf[UV__UDP_CMSG_SPACE];
+  size_t align;
+};
+
+/* Handle flags that need control messages on receive. */
+#define UV__UDP_CMSG_FLAGS                                                    \
+  (UV_HANDLE_UDP_GRO | UV_HANDLE_UDP_RECVINFO | UV_HANDLE_UDP_RXQ_OVFL)
+
+#if defined(__linux__)
+/* Set once sendmmsg() turned out to be missing, never cleared. */
+static int uv__sendmmsg_unavail;
+
+/* UDP_SEGMENT support: 0 = not probed yet, 1 = available, -1 = missing. */
+static int uv__udp_gso_avail;
+#endif
+
 
 static void uv__udp_run_completed(uv_udp_t* handle);
 static void uv__udp_io(uv_loop_t* loop, uv__io_t* w, unsigned int revents);
@@ -49,6 +123,39 @@ static int uv__udp_maybe_deferred_bind(uv_udp_t* handle,
                                        unsigned int flags);
 
 
+/* Returns the optional receive state of the handle, allocated on first use.
+ * Returns NULL when out of memory.
+ */
+static uv__udp_ext_t* uv__udp_ext(uv_udp_t* handle) {
+  if (uv__handle_ext(handle) == NULL)
+    uv__handle_ext(handle) = uv__calloc(1, sizeof(uv__udp_ext_t));
+  return uv__handle_ext(handle);
+}
+
+
+/* Makes the datagram in the receive callback readable with
+ * uv_udp_get_recv_info(), NULL once the callback returned. Handles without the
+ * optional state never asked for it.
+ */
+static void uv__udp_set_recv_msg(uv_udp_t* handle, struct msghdr* h) {
+  uv__udp_ext_t* ext;
+
+  ext = uv__handle_ext(handle);
+  if (ext != NULL)
+    ext->recv_msg = h;
+}
+
+
+/* Length of the peer address of a datagram, 0 on a connected socket. */
+static socklen_t uv__udp_addrlen(const struct sockaddr* addr) {
+  if (addr->sa_family == AF_INET6)
+    return sizeof(struct sockaddr_in6);
+  if (addr->sa_family == AF_INET)
+    return sizeof(struct sockaddr_in);
+  return 0;
+}
+
+
 void uv__udp_close(uv_udp_t* handle) {
   uv__io_close(handle->loop, &handle->io_watcher);
   uv__handle_stop(handle);
@@ -62,6 +169,7 @@ void uv__udp_close(uv_udp_t* handle) {
 
 void uv__udp_finish_close(uv_udp_t* handle) {
   uv_udp_send_t* req;
+  uv__udp_ext_t* ext;
   QUEUE* q;
 
   assert(!uv__io_active(&handle->io_watcher, POLLIN | POLLOUT));
@@ -84,6 +192,12 @@ void uv__udp_finish_close(uv_udp_t* handle) {
   /* Now tear down the handle. */
   handle->recv_cb = NULL;
   handle->alloc_cb = NULL;
+  ext = uv__handle_ext(handle);
+  if (ext != NULL) {
+    uv__free(ext->recv_slab);
+    uv__free(ext);
+    uv__handle_ext(handle) = NULL;
+  }
   /* but _do not_ touch close_cb */
 }
 
@@ -91,6 +205,7 @@ void uv__udp_finish_close(uv_udp_t* handle) {
 static void uv__udp_run_completed(uv_udp_t* handle) {
   uv_udp_send_t* req;
   QUEUE* q;
+  size_t size;
 
   assert(!(handle->flags & UV_UDP_PROCESSING));
   handle->flags |= UV_UDP_PROCESSING;
@@ -102,7 +217,9 @@ static void uv__udp_run_completed(uv_udp_t* handle) {
     req = QUEUE_DATA(q, uv_udp_send_t, queue);
     uv__req_unregister(handle->loop, req);
 
-    handle->send_queue_size -= uv__count_bufs(req->bufs, req->nbufs);
+    size = uv__count_bufs(req->bufs, req->nbufs);
+    handle->send_queue_size -= size;
+    uv__get_internal_fields(handle->loop)->mem.send_queued -= size;
     handle->send_queue_count--;
 
     if (req->bufs != req->bufsml)
@@ -148,37 +265,231 @@ static void uv__udp_io(uv_loop_t* loop, uv__io_t* w, unsigned int revents) {
 }
 
 
+/* Picks up the control messages of a received datagram. Returns the
+ * UV_UDP_* flags that they add.
+ */
+static unsigned int uv__udp_parse_cmsg(uv_udp_t* handle, struct msghdr* h) {
+  uv__loop_internal_fields_t* lfields;
+  struct cmsghdr* cmsg;
+  uv__udp_ext_t* ext;
+  unsigned int flags;
+  uint32_t drops;
+  int val;
+
+  flags = 0;
+  handle->gro_segment_size = 0;
+
+  if (h->msg_control == NULL)
+    return 0;
+
+  for (cmsg = CMSG_FIRSTHDR(h); cmsg != NULL; cmsg = CMSG_NXTHDR(h, cmsg)) {
+#if defined(__linux__)
+    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+      memcpy(&val, CMSG_DATA(cmsg), sizeof(val));
+      handle->gro_segment_size = val;
+      flags |= UV_UDP_GRO;
+    }
+
+    /* The kernel's running drop total for the socket, which wraps around.
+     * uv_udp_set_drop_counter() allocated the state before enabling it.
+     */
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+      ext = uv__handle_ext(handle);
+      assert(ext != NULL);
+      memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+      lfields = uv__get_internal_fields(handle->loop);
+      ext->rx_dropped += (uint32_t) (drops - ext->rxq_ovfl);
+      lfields->mem.udp_dropped += (uint32_t) (drops - ext->rxq_ovfl);
+      ext->rxq_ovfl = drops;
+    }
+#endif
+  }
+
+  return flags;
+}
+
+
+#if defined(__linux__)
+/* Receives up to one datagram per slot of `buf` with a single syscall and
+ * passes them to the recv callback one by one, followed by a last callback
+ * that hands the buffer back unless it is the handle's own slab. Returns the
+ * number of datagrams, 0 when there was nothing to read or an error was
+ * reported, or -ENOSYS.
+ */
+static ssize_t uv__udp_recvmmsg(uv_udp_t* handle,
+                                uv_buf_t* buf,
+                                size_t* nbytes) {
+  struct sockaddr_storage peers[UV__MMSG_MAXWIDTH];
+  struct iovec iov[UV__MMSG_MAXWIDTH];
+  struct uv__mmsghdr msgs[UV__MMSG_MAXWIDTH];
+  union uv__udp_cmsg_buf cmsgs[UV__MMSG_MAXWIDTH];
+  uv_udp_recv_cb recv_cb;
+  uv__udp_ext_t* ext;
+  const struct sockaddr* addr;
+  uv_buf_t chunk;
+  size_t nslots;
+  size_t k;
+  ssize_t nread;
+  int flags;
+
+  nslots = buf->len / UV__UDP_DGRAM_MAXSIZE;
+  if (nslots > ARRAY_SIZE(msgs))
+    nslots = ARRAY_SIZE(msgs);
+
+  memset(msgs, 0, nslots * sizeof(msgs[0]));
+  for (k = 0; k < nslots; k++) {
+    iov[k].iov_base = buf->base + k * UV__UDP_DGRAM_MAXSIZE;
+    iov[k].iov_len = UV__UDP_DGRAM_MAXSIZE;
+    msgs[k].msg_hdr.msg_iov = iov + k;
+    msgs[k].msg_hdr.msg_iovlen = 1;
+    msgs[k].msg_hdr.msg_name = peers + k;
+    msgs[k].msg_hdr.msg_namelen = sizeof(peers[0]);
+    if (handle->flags & UV__UDP_CMSG_FLAGS) {
+      msgs[k].msg_hdr.msg_control = cmsgs[k].buf;
+      msgs[k].msg_hdr.msg_controllen = sizeof(cmsgs[k].buf);
+    }
+  }
+
+  do
+    nread = uv__recvmmsg(handle->io_watcher.fd, msgs, nslots, 0, NULL);
+  while (nread == -1 && errno == EINTR);
+
+  if (nread == -1 && errno == ENOSYS)
+    return -ENOSYS;
+
+  if (nread < 1) {
+    if (nread == 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+      handle->recv_cb(handle, 0, buf, NULL, 0);
+    else
+      handle->recv_cb(handle, -errno, buf, NULL, 0);
+    return 0;
+  }
+
+  /* The callback may stop the handle, the buffer goes back all the same. */
+  recv_cb = handle->recv_cb;
+
+  for (k = 0; k < (size_t) nread && handle->recv_cb != NULL; k++) {
+    flags = UV_UDP_MMSG_CHUNK | uv__udp_parse_cmsg(handle, &msgs[k].msg_hdr);
+    if (msgs[k].msg_hdr.msg_flags & MSG_TRUNC)
+      flags |= UV_UDP_PARTIAL;
+
+    addr = NULL;
+    if (msgs[k].msg_hdr.msg_namelen != 0)
+      addr = (const struct sockaddr*) (peers + k);
+
+    uv__io_budget_charge(handle->loop, msgs[k].msg_len);
+    *nbytes += msgs[k].msg_len;
+
+    if (handle->alloc_cb == NULL)
+      chunk = uv_buf_init(iov[k].iov_base, msgs[k].msg_len);
+    else
+      chunk = uv_buf_init(iov[k].iov_base, iov[k].iov_len);
+    uv__udp_set_recv_msg(handle, &msgs[k].msg_hdr);
+    handle->recv_cb(handle, msgs[k].msg_len, &chunk, addr, flags);
+    uv__udp_set_recv_msg(handle, NULL);
+  }
+
+  ext = uv__handle_ext(handle);
+  if (ext == NULL || buf->base != ext->recv_slab)
+    recv_cb(handle, 0, buf, NULL, UV_UDP_MMSG_FREE);
+
+  return nread;
+}
+#endif /* defined(__linux__) */
+
+
+/* The receive buffer of handles without an alloc callback, allocated on first
+ * use and kept until the handle is closed. It holds a full recvmmsg() batch
+ * on handles that use it, a single datagram otherwise.
+ */
+static uv_buf_t uv__udp_recv_slab(uv_udp_t* handle) {
+  uv__udp_ext_t* ext;
+  size_t size;
+
+  ext = uv__udp_ext(handle);
+  if (ext == NULL)
+    return uv_buf_init(NULL, 0);
+
+  if (ext->recv_slab == NULL) {
+    size = UV__UDP_DGRAM_MAXSIZE;
+#if defined(__linux__)
+    if (handle->flags & UV_HANDLE_UDP_RECVMMSG)
+      size *= UV__MMSG_MAXWIDTH;
+#endif
+    ext->recv_slab = uv__malloc(size);
+    if (ext->recv_slab == NULL)
+      return uv_buf_init(NULL, 0);
+    ext->recv_slab_size = size;
+  }
+
+  return uv_buf_init(ext->recv_slab, ext->recv_slab_size);
+}
+
+
 static void uv__udp_recvmsg(uv_udp_t* handle) {
   struct sockaddr_storage peer;
+  union uv__udp_cmsg_buf cmsg;
   struct msghdr h;
   ssize_t nread;
   uv_buf_t buf;
   int flags;
-  int count;
+  unsigned int count;
+  size_t nbytes;
 
   assert(handle->recv_cb != NULL);
-  assert(handle->alloc_cb != NULL);
 
   /* Prevent loop starvation when the data comes in as fast as (or faster than)
    * we can read it. XXX Need to rearm fd if we switch to edge-triggered I/O.
    */
-  count = 32;
+  count = 0;
+  nbytes = 0;
 
   memset(&h, 0, sizeof(h));
   h.msg_name = &peer;
 
   do {
-    buf = uv_buf_init(NULL, 0);
-    handle->alloc_cb((uv_handle_t*) handle, 64 * 1024, &buf);
+    if (handle->alloc_cb == NULL) {
+      buf = uv__udp_recv_slab(handle);
+    } else {
+      buf = uv_buf_init(NULL, 0);
+      handle->alloc_cb((uv_handle_t*) handle,
+                       uv__read_size_suggest((uv_handle_t*) handle,
+                                             handle->io_watcher.fd,
+                                             UV__UDP_DGRAM_MAXSIZE,
+                                             UV__UDP_DGRAM_MAXSIZE),
+                       &buf);
+    }
     if (buf.base == NULL || buf.len == 0) {
       handle->recv_cb(handle, UV_ENOBUFS, &buf, NULL, 0);
       return;
     }
     assert(buf.base != NULL);
 
+#if defined(__linux__)
+    if ((handle->flags & UV_HANDLE_UDP_RECVMMSG) &&
+        buf.len >= 2 * UV__UDP_DGRAM_MAXSIZE) {
+      nread = uv__udp_recvmmsg(handle, &buf, &nbytes);
+      if (nread != -ENOSYS) {
+        count += nread;
+        /* A short batch means the socket has been drained. */
+        if ((size_t) nread < buf.len / UV__UDP_DGRAM_MAXSIZE &&
+            nread < UV__MMSG_MAXWIDTH)
+          nread = -1;
+        continue;
+      }
+
+      /* Kernel too old, use recvmsg() from now on. */
+      handle->flags &= ~UV_HANDLE_UDP_RECVMMSG;
+    }
+#endif
+
     h.msg_namelen = sizeof(peer);
     h.msg_iov = (void*) &buf;
     h.msg_iovlen = 1;
+    if (handle->flags & UV__UDP_CMSG_FLAGS) {
+      h.msg_control = cmsg.buf;
+      h.msg_controllen = sizeof(cmsg.buf);
+    }
 
     do {
       nread = recvmsg(handle->io_watcher.fd, &h, 0);
@@ -198,27 +509,314 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
       else
         addr = (const struct sockaddr*) &peer;
 
-      flags = 0;
+      flags = uv__udp_parse_cmsg(handle, &h);
       if (h.msg_flags & MSG_TRUNC)
         flags |= UV_UDP_PARTIAL;
 
+      uv__io_budget_charge(handle->loop, nread);
+      nbytes += nread;
+      count++;
+
+      /* Slab slices are cut to the datagram, the slab is reused next. */
+      if (handle->alloc_cb == NULL)
+        buf.len = nread;
+
+      uv__udp_set_recv_msg(handle, &h);
       handle->recv_cb(handle, nread, &buf, addr, flags);
+      uv__udp_set_recv_msg(handle, NULL);
     }
   }
   /* recv_cb callback may decide to pause or close the handle */
   while (nread != -1
-      && count-- > 0
+      && !uv__io_budget_exceeded(handle->loop, count, nbytes)
       && handle->io_watcher.fd != -1
       && handle->recv_cb != NULL);
 }
 
 
+/* Points `iov` at `len` bytes of `bufs`, starting `off` bytes in. Returns
+ * the number of iovecs used, at most `nbufs`.
+ */
+static size_t uv__udp_slice(const uv_buf_t* bufs,
+                            unsigned int nbufs,
+                            size_t off,
+                            size_t len,
+                            struct iovec* iov) {
+  size_t n;
+  size_t k;
+
+  if (len == 0)
+    return 0;
+
+  for (k = 0; off >= bufs[k].len; k++)
+    off -= bufs[k].len;
+
+  for (n = 0; len > 0; k++, n++) {
+    assert(k < nbufs);
+    iov[n].iov_base = bufs[k].base + off;
+    iov[n].iov_len = bufs[k].len - off;
+    if (iov[n].iov_len > len)
+      iov[n].iov_len = len;
+    len -= iov[n].iov_len;
+    off = 0;
+  }
+
+  return n;
+}
+
+
+#if defined(__linux__)
+static int uv__udp_gso_probe(int fd) {
+  socklen_t len;
+  int val;
+
+  if (uv__udp_gso_avail == 0) {
+    len = sizeof(val);
+    if (getsockopt(fd, SOL_UDP, UDP_SEGMENT, &val, &len) == 0)
+      uv__udp_gso_avail = 1;
+    else
+      uv__udp_gso_avail = -1;
+  }
+
+  return uv__udp_gso_avail == 1;
+}
+#endif
+
+
+/* Requests made with uv_udp_send_segmented() keep their state in the reserved
+ * fields of the request: reserved[0] is the segment size, 0 for a plain send,
+ * reserved[1] is the number of bytes sent so far.
+ */
+#define uv__udp_req_segment_size(req)                                         \
+  ((size_t) (uintptr_t) (req)->reserved[0])
+#define uv__udp_req_segment_offset(req)                                       \
+  ((size_t) (uintptr_t) (req)->reserved[1])
+
+
+/* Sends what is left of a request made with uv_udp_send_segmented(). With
+ * UDP_SEGMENT the kernel cuts a large chunk into datagrams of segment_size
+ * bytes, otherwise every datagram is sent on its own. Returns -EAGAIN when the
+ * socket is full, the request stays at the head of the queue and picks up
+ * where it left off. Returns 0 once the request is done.
+ */
+static int uv__udp_send_segments(uv_udp_t* handle, uv_udp_send_t* req) {
+#if defined(__linux__)
+  union {
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+    struct cmsghdr align;
+  } cm;
+  struct cmsghdr* cmsg;
+  size_t maxlen;
+  int gso;
+#endif
+  struct iovec iovsml[8];
+  struct iovec* iov;
+  struct msghdr h;
+  size_t segment_size;
+  size_t offset;
+  size_t total;
+  size_t len;
+  ssize_t size;
+  int err;
+
+  segment_size = uv__udp_req_segment_size(req);
+  offset = uv__udp_req_segment_offset(req);
+
+  iov = iovsml;
+  if (req->nbufs > ARRAY_SIZE(iovsml)) {
+    iov = uv__malloc(req->nbufs * sizeof(iov[0]));
+    if (iov == NULL) {
+      err = -ENOMEM;
+      goto done;
+    }
+  }
+
+#if defined(__linux__)
+  gso = uv__udp_gso_probe(handle->io_watcher.fd);
+  maxlen = (req->addr.ss_family == AF_INET6 ?
+    UV__UDP_PAYLOAD_MAX6 : UV__UDP_PAYLOAD_MAX4);
+  maxlen -= maxlen % segment_size;
+  if (maxlen > UV__UDP_GSO_MAXSEGS * segment_size)
+    maxlen = UV__UDP_GSO_MAXSEGS * segment_size;
+  if (maxlen < 2 * segment_size)
+    gso = 0;
+#endif
+
+  err = 0;
+  total = uv__count_bufs(req->bufs, req->nbufs);
+
+  /* An empty buffer still makes for one (empty) datagram. */
+  do {
+    len = total - offset;
+
+    memset(&h, 0, sizeof(h));
+    h.msg_namelen = uv__udp_addrlen((struct sockaddr*) &req->addr);
+    if (h.msg_namelen != 0)
+      h.msg_name = &req->addr;
+
+#if defined(__linux__)
+    if (gso && len > segment_size) {
+      if (len > maxlen)
+        len = maxlen;
+      memset(&cm, 0, sizeof(cm));
+      h.msg_control = cm.buf;
+      h.msg_controllen = sizeof(cm.buf);
+      cmsg = CMSG_FIRSTHDR(&h);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      *(uint16_t*) CMSG_DATA(cmsg) = segment_size;
+    }
+#endif
+
+    if (h.msg_control == NULL && len > segment_size)
+      len = segment_size;
+
+    h.msg_iov = iov;
+    h.msg_iovlen = uv__udp_slice(req->bufs,
+                                 req->nbufs,
+                                 offset,
+                                 len,
+                                 iov);
+
+    do
+      size = sendmsg(handle->io_watcher.fd, &h, 0);
+    while (size == -1 && errno == EINTR);
+
+    if (size == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        err = -EAGAIN;
+        break;
+      }
+
+#if defined(__linux__)
+      /* The route can't offload, e.g. no checksum offload or a segment that
+       * exceeds the MTU. Send the rest one datagram at a time, which either
+       * works or fails with the real error.
+       */
+      if (h.msg_control != NULL) {
+        gso = 0;
+        continue;
+      }
+#endif
+
+      err = -errno;
+      break;
+    }
+
+    offset += len;
+  } while (offset < total);
+
+  req->reserved[1] = (void*) (uintptr_t) offset;
+
+  if (iov != iovsml)
+    uv__free(iov);
+
+  if (err == -EAGAIN)
+    return err;
+
+done:
+  req->status = (err != 0 ? err : (ssize_t) total);
+  QUEUE_REMOVE(&req->queue);
+  QUEUE_INSERT_TAIL(&handle->write_completed_queue, &req->queue);
+  uv__io_feed(handle->loop, &handle->io_watcher);
+  return 0;
+}
+
+
+#if defined(__linux__)
+/* Flushes the write queue in batches of up to UV__MMSG_MAXWIDTH datagrams.
+ * Returns -ENOSYS when the kernel does not have sendmmsg(), 0 otherwise.
+ */
+static int uv__udp_sendmmsg(uv_udp_t* handle) {
+  uv_udp_send_t* req;
+  struct uv__mmsghdr h[UV__MMSG_MAXWIDTH];
+  struct uv__mmsghdr* p;
+  QUEUE* q;
+  ssize_t npkts;
+  size_t pkts;
+  size_t i;
+  int err;
+
+  if (uv__sendmmsg_unavail)
+    return -ENOSYS;
+
+  while (!QUEUE_EMPTY(&handle->write_queue)) {
+    q = QUEUE_HEAD(&handle->write_queue);
+    req = QUEUE_DATA(q, uv_udp_send_t, queue);
+    if (uv__udp_req_segment_size(req) != 0) {
+      if (uv__udp_send_segments(handle, req))
+        break;
+      continue;
+    }
+
+    /* A batch ends at the next segmented request. */
+    pkts = 0;
+    for (;
+         pkts < UV__MMSG_MAXWIDTH && q != &handle->write_queue;
+         q = QUEUE_NEXT(q), pkts++) {
+      req = QUEUE_DATA(q, uv_udp_send_t, queue);
+      if (uv__udp_req_segment_size(req) != 0)
+        break;
+      p = &h[pkts];
+      memset(p, 0, sizeof(*p));
+      p->msg_hdr.msg_namelen = uv__udp_addrlen((struct sockaddr*) &req->addr);
+      if (p->msg_hdr.msg_namelen != 0)
+        p->msg_hdr.msg_name = &req->addr;
+      p->msg_hdr.msg_iov = (struct iovec*) req->bufs;
+      p->msg_hdr.msg_iovlen = req->nbufs;
+    }
+
+    do
+      npkts = uv__sendmmsg(handle->io_watcher.fd, h, pkts, 0);
+    while (npkts == -1 && errno == EINTR);
+
+    err = 0;
+    if (npkts == -1) {
+      if (errno == ENOSYS) {
+        uv__sendmmsg_unavail = 1;
+        return -ENOSYS;
+      }
+
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+
+      err = -errno;
+    }
+
+    /* Same as with sendmsg(), datagrams go out whole or not at all. An error
+     * belongs to the first datagram of the batch, the others are retried.
+     */
+    if (npkts == -1)
+      npkts = 1;
+
+    for (i = 0; i < (size_t) npkts; i++) {
+      q = QUEUE_HEAD(&handle->write_queue);
+      req = QUEUE_DATA(q, uv_udp_send_t, queue);
+      req->status = (err != 0 ? err : (ssize_t) h[i].msg_len);
+      QUEUE_REMOVE(&req->queue);
+      QUEUE_INSERT_TAIL(&handle->write_completed_queue, &req->queue);
+    }
+
+    uv__io_feed(handle->loop, &handle->io_watcher);
+  }
+
+  return 0;
+}
+#endif /* defined(__linux__) */
+
+
 static void uv__udp_sendmsg(uv_udp_t* handle) {
   uv_udp_send_t* req;
   QUEUE* q;
   struct msghdr h;
   ssize_t size;
 
+#if defined(__linux__)
+  if (uv__udp_sendmmsg(handle) == 0)
+    return;
+#endif
+
   while (!QUEUE_EMPTY(&handle->write_queue)) {
     q = QUEUE_HEAD(&handle->write_queue);
     assert(q != NULL);
@@ -226,10 +824,16 @@ static void uv__udp_sendmsg(uv_udp_t* handle) {
     req = QUEUE_DATA(q, uv_udp_send_t, queue);
     assert(req != NULL);
 
+    if (uv__udp_req_segment_size(req) != 0) {
+      if (uv__udp_send_segments(handle, req))
+        break;
+      continue;
+    }
+
     memset(&h, 0, sizeof h);
-    h.msg_name = &req->addr;
-    h.msg_namelen = (req->addr.ss_family == AF_INET6 ?
-      sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in));
+    h.msg_namelen = uv__udp_addrlen((struct sockaddr*) &req->addr);
+    if (h.msg_namelen != 0)
+      h.msg_name = &req->addr;
     h.msg_iov = (struct iovec*) req->bufs;
     h.msg_iovlen = req->nbufs;
 
@@ -288,8 +892,12 @@ int uv__udp_bind(uv_udp_t* handle,
   int fd;
 
   /* Check for bad flags. */
-  if (flags & ~(UV_UDP_IPV6ONLY | UV_UDP_REUSEADDR))
+  if (flags & ~(UV_UDP_IPV6ONLY |
+                UV_UDP_REUSEADDR |
+                UV_UDP_REUSEPORT |
+                UV_UDP_REUSEPORT_CPU)) {
     return -EINVAL;
+  }
 
   /* Cannot set IPv6-only mode on non-IPv6 socket. */
   if ((flags & UV_UDP_IPV6ONLY) && addr->sa_family != AF_INET6)
@@ -310,6 +918,12 @@ int uv__udp_bind(uv_udp_t* handle,
       goto out;
   }
 
+  if (flags & (UV_UDP_REUSEPORT | UV_UDP_REUSEPORT_CPU)) {
+    err = uv__socket_reuseport(fd);
+    if (err)
+      goto out;
+  }
+
   if (flags & UV_UDP_IPV6ONLY) {
 #ifdef IPV6_V6ONLY
     yes = 1;
@@ -332,6 +946,12 @@ int uv__udp_bind(uv_udp_t* handle,
     goto out;
   }
 
+  if (flags & UV_UDP_REUSEPORT_CPU) {
+    err = uv__socket_steer_cpu(fd);
+    if (err)
+      goto out;
+  }
+
   if (addr->sa_family == AF_INET6)
     handle->flags |= UV_HANDLE_IPV6;
 
@@ -390,14 +1010,37 @@ int uv__udp_send(uv_udp_send_t* req,
                  const struct sockaddr* addr,
                  unsigned int addrlen,
                  uv_udp_send_cb send_cb) {
+  return uv__udp_send_segmented(req,
+                                handle,
+                                bufs,
+                                nbufs,
+                                0,
+                                addr,
+                                addrlen,
+                                send_cb);
+}
+
+
+int uv__udp_send_segmented(uv_udp_send_t* req,
+                           uv_udp_t* handle,
+                           const uv_buf_t bufs[],
+                           unsigned int nbufs,
+                           size_t segment_size,
+                           const struct sockaddr* addr,
+                           unsigned int addrlen,
+                           uv_udp_send_cb send_cb) {
   int err;
   int empty_queue;
+  size_t size;
 
   assert(nbufs > 0);
 
-  err = uv__udp_maybe_deferred_bind(handle, addr->sa_family, 0);
-  if (err)
-    return err;
+  /* A connected socket is bound already. */
+  if (addr != NULL) {
+    err = uv__udp_maybe_deferred_bind(handle, addr->sa_family, 0);
+    if (err)
+      return err;
+  }
 
   /* It's legal for send_queue_count > 0 even when the write_queue is empty;
    * it means there are error-state requests in the write_completed_queue that
@@ -407,10 +1050,15 @@ int uv__udp_send(uv_udp_send_t* req,
 
   uv__req_init(handle->loop, req, UV_UDP_SEND);
   assert(addrlen <= sizeof(req->addr));
-  memcpy(&req->addr, addr, addrlen);
+  if (addr == NULL)
+    req->addr.ss_family = AF_UNSPEC;
+  else
+    memcpy(&req->addr, addr, addrlen);
   req->send_cb = send_cb;
   req->handle = handle;
   req->nbufs = nbufs;
+  req->reserved[0] = (void*) (uintptr_t) segment_size;
+  req->reserved[1] = (void*) (uintptr_t) 0;
 
   req->bufs = req->bufsml;
   if (nbufs > ARRAY_SIZE(req->bufsml))
@@ -422,7 +1070,9 @@ int uv__udp_send(uv_udp_send_t* req,
   }
 
   memcpy(req->bufs, bufs, nbufs * sizeof(bufs[0]));
-  handle->send_queue_size += uv__count_bufs(req->bufs, req->nbufs);
+  size = uv__count_bufs(req->bufs, req->nbufs);
+  handle->send_queue_size += size;
+  uv__get_internal_fields(handle->loop)->mem.send_queued += size;
   handle->send_queue_count++;
   QUEUE_INSERT_TAIL(&handle->write_queue, &req->queue);
   uv__handle_start(handle);
@@ -452,9 +1102,11 @@ int uv__udp_try_send(uv_udp_t* handle,
   if (handle->send_queue_count != 0)
     return -EAGAIN;
 
-  err = uv__udp_maybe_deferred_bind(handle, addr->sa_family, 0);
-  if (err)
-    return err;
+  if (addr != NULL) {
+    err = uv__udp_maybe_deferred_bind(handle, addr->sa_family, 0);
+    if (err)
+      return err;
+  }
 
   memset(&h, 0, sizeof h);
   h.msg_name = (struct sockaddr*) addr;
@@ -477,6 +1129,102 @@ int uv__udp_try_send(uv_udp_t* handle,
 }
 
 
+int uv__udp_try_send_batch(uv_udp_t* handle,
+                           unsigned int count,
+                           uv_buf_t* bufs[],
+                           unsigned int nbufs[],
+                           struct sockaddr* addrs[]) {
+#if defined(__linux__)
+  struct uv__mmsghdr h[UV__MMSG_MAXWIDTH];
+  unsigned int pkts;
+  ssize_t npkts;
+#endif
+  struct msghdr msg;
+  unsigned int sent;
+  unsigned int i;
+  ssize_t size;
+  int err;
+
+  /* Queued messages must go out first. */
+  if (handle->send_queue_count != 0)
+    return -EAGAIN;
+
+  /* Without addresses the socket is connected and bound already. */
+  if (addrs != NULL) {
+    err = uv__udp_maybe_deferred_bind(handle, addrs[0]->sa_family, 0);
+    if (err)
+      return err;
+  }
+
+  sent = 0;
+
+#if defined(__linux__)
+  while (sent < count && !uv__sendmmsg_unavail) {
+    pkts = count - sent;
+    if (pkts > ARRAY_SIZE(h))
+      pkts = ARRAY_SIZE(h);
+
+    memset(h, 0, pkts * sizeof(h[0]));
+    for (i = 0; i < pkts; i++) {
+      if (addrs != NULL) {
+        h[i].msg_hdr.msg_name = addrs[sent + i];
+        h[i].msg_hdr.msg_namelen = uv__udp_addrlen(addrs[sent + i]);
+      }
+      h[i].msg_hdr.msg_iov = (struct iovec*) bufs[sent + i];
+      h[i].msg_hdr.msg_iovlen = nbufs[sent + i];
+    }
+
+    do
+      npkts = uv__sendmmsg(handle->io_watcher.fd, h, pkts, 0);
+    while (npkts == -1 && errno == EINTR);
+
+    if (npkts == -1) {
+      if (errno == ENOSYS) {
+        uv__sendmmsg_unavail = 1;
+        break;
+      }
+      goto error;
+    }
+
+    sent += npkts;
+
+    /* Socket buffer full or a datagram that fails, leave it to the caller. */
+    if ((unsigned int) npkts < pkts)
+      return sent;
+  }
+#endif
+
+  for (; sent < count; sent++) {
+    memset(&msg, 0, sizeof(msg));
+    if (addrs != NULL) {
+      msg.msg_name = addrs[sent];
+      msg.msg_namelen = uv__udp_addrlen(addrs[sent]);
+    }
+    msg.msg_iov = (struct iovec*) bufs[sent];
+    msg.msg_iovlen = nbufs[sent];
+
+    do
+      size = sendmsg(handle->io_watcher.fd, &msg, 0);
+    while (size == -1 && errno == EINTR);
+
+    if (size == -1)
+      goto error;
+  }
+
+  return sent;
+
+error:
+  /* Report what went out, the error comes back on the next call. */
+  if (sent > 0)
+    return sent;
+
+  if (errno == EAGAIN || errno == EWOULDBLOCK)
+    return -EAGAIN;
+
+  return -errno;
+}
+
+
 static int uv__udp_set_membership4(uv_udp_t* handle,
                                    const struct sockaddr_in* multicast_addr,
                                    const char* interface_addr,
@@ -581,7 +1329,7 @@ int uv_udp_init_ex(uv_loop_t* loop, uv_udp_t* handle, unsigned int flags) {
   if (domain != AF_INET && domain != AF_INET6 && domain != AF_UNSPEC)
     return -EINVAL;
 
-  if (flags & ~0xFF)
+  if (flags & ~(0xFF | UV_UDP_RECVMMSG))
     return -EINVAL;
 
   if (domain != AF_UNSPEC) {
@@ -598,7 +1346,14 @@ int uv_udp_init_ex(uv_loop_t* loop, uv_udp_t* handle, unsigned int flags) {
   handle->recv_cb = NULL;
   handle->send_queue_size = 0;
   handle->send_queue_count = 0;
+  handle->gro_segment_size = 0;
+  uv__handle_ext(handle) = NULL;
   uv__io_init(&handle->io_watcher, uv__udp_io, fd);
+
+  /* Accepted everywhere, only used on Linux. */
+  if (flags & UV_UDP_RECVMMSG)
+    handle->flags |= UV_HANDLE_UDP_RECVMMSG;
+
   QUEUE_INIT(&handle->write_queue);
   QUEUE_INIT(&handle->write_completed_queue);
   return 0;
@@ -611,6 +1366,8 @@ int uv_udp_init(uv_loop_t* loop, uv_udp_t* handle) {
 
 
 int uv_udp_open(uv_udp_t* handle, uv_os_sock_t sock) {
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
   int err;
 
   /* Check for already active socket. */
@@ -626,10 +1383,66 @@ int uv_udp_open(uv_udp_t* handle, uv_os_sock_t sock) {
     return err;
 
   handle->io_watcher.fd = sock;
+
+  /* The socket may have been connected before it was handed over. */
+  addrlen = sizeof(addr);
+  if (getpeername(sock, (struct sockaddr*) &addr, &addrlen) == 0)
+    handle->flags |= UV_HANDLE_UDP_CONNECTED;
+
+  return 0;
+}
+
+
+int uv__udp_connect(uv_udp_t* handle,
+                    const struct sockaddr* addr,
+                    unsigned int addrlen) {
+  int err;
+
+  err = uv__udp_maybe_deferred_bind(handle, addr->sa_family, 0);
+  if (err)
+    return err;
+
+  do {
+    errno = 0;
+    err = connect(handle->io_watcher.fd, addr, addrlen);
+  } while (err == -1 && errno == EINTR);
+
+  if (err)
+    return -errno;
+
+  handle->flags |= UV_HANDLE_UDP_CONNECTED;
+
+  return 0;
+}
+
+
+int uv__udp_disconnect(uv_udp_t* handle) {
+  struct sockaddr addr;
+  int r;
+
+  /* Connecting to AF_UNSPEC dissolves the association. */
+  memset(&addr, 0, sizeof(addr));
+  addr.sa_family = AF_UNSPEC;
+
+  do {
+    errno = 0;
+    r = connect(handle->io_watcher.fd, &addr, sizeof(addr));
+  } while (r == -1 && errno == EINTR);
+
+  /* The BSDs and OS X disconnect but still report EAFNOSUPPORT. */
+  if (r == -1 && errno != EAFNOSUPPORT)
+    return -errno;
+
+  handle->flags &= ~UV_HANDLE_UDP_CONNECTED;
   return 0;
 }
 
 
+int uv__udp_is_connected(const uv_udp_t* handle) {
+  return !!(handle->flags & UV_HANDLE_UDP_CONNECTED);
+}
+
+
 int uv_udp_set_membership(uv_udp_t* handle,
                           const char* multicast_addr,
                           const char* interface_addr,
@@ -710,6 +1523,242 @@ int uv_udp_set_broadcast(uv_udp_t* handle, int on) {
 }
 
 
+int uv_udp_set_gro(uv_udp_t* handle, int on) {
+#if defined(__linux__)
+  on = !!on;
+  if (setsockopt(handle->io_watcher.fd, SOL_UDP, UDP_GRO, &on, sizeof(on)))
+    return -errno;
+
+  if (on)
+    handle->flags |= UV_HANDLE_UDP_GRO;
+  else
+    handle->flags &= ~UV_HANDLE_UDP_GRO;
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+size_t uv_udp_get_gro_segment_size(const uv_udp_t* handle) {
+  return handle->gro_segment_size;
+}
+
+
+int uv_udp_set_drop_counter(uv_udp_t* handle, int on) {
+#if defined(__linux__)
+  uint32_t meminfo[UV__SK_MEMINFO_DROPS + 1];
+  uv__udp_ext_t* ext;
+  socklen_t len;
+
+  on = !!on;
+  ext = uv__udp_ext(handle);
+  if (ext == NULL)
+    return -ENOMEM;
+
+  if (setsockopt(handle->io_watcher.fd,
+                 SOL_SOCKET,
+                 SO_RXQ_OVFL,
+                 &on,
+                 sizeof(on))) {
+    return -errno;
+  }
+
+  /* Start from the kernel's current drop total so that the first datagram
+   * does not report the drops from before the counter was enabled. Kernels
+   * before 4.12 lack SO_MEMINFO and the first reading includes them.
+   */
+  if (on && !(handle->flags & UV_HANDLE_UDP_RXQ_OVFL)) {
+    len = sizeof(meminfo);
+    if (getsockopt(handle->io_watcher.fd,
+                   SOL_SOCKET,
+                   SO_MEMINFO,
+                   meminfo,
+                   &len) == 0 && len == sizeof(meminfo)) {
+      ext->rxq_ovfl = meminfo[UV__SK_MEMINFO_DROPS];
+    }
+  }
+
+  if (on)
+    handle->flags |= UV_HANDLE_UDP_RXQ_OVFL;
+  else
+    handle->flags &= ~UV_HANDLE_UDP_RXQ_OVFL;
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+uint64_t uv_udp_get_drop_counter(const uv_udp_t* handle) {
+  const uv__udp_ext_t* ext;
+
+  ext = uv__handle_ext(handle);
+  if (ext == NULL)
+    return 0;
+
+  return ext->rx_dropped;
+}
+
+
+int uv_udp_set_recv_info(uv_udp_t* handle, unsigned int flags) {
+  struct sockaddr_storage ss;
+  socklen_t sslen;
+  int on;
+
+  if (flags & ~(UV_UDP_RECV_TIMESTAMP | UV_UDP_RECV_PKTINFO))
+    return -EINVAL;
+
+  if (uv__udp_ext(handle) == NULL)
+    return -ENOMEM;
+
+#if !defined(UV__SO_TIMESTAMP)
+  if (flags & UV_UDP_RECV_TIMESTAMP)
+    return -ENOTSUP;
+#else
+  on = !!(flags & UV_UDP_RECV_TIMESTAMP);
+  if (setsockopt(handle->io_watcher.fd,
+                 SOL_SOCKET,
+                 UV__SO_TIMESTAMP,
+                 &on,
+                 sizeof(on))) {
+    return -errno;
+  }
+#endif
+
+  sslen = sizeof(ss);
+  if (getsockname(handle->io_watcher.fd, (struct sockaddr*) &ss, &sslen))
+    return -errno;
+
+  /* IPv6 sockets report IPv4 datagrams as IPv4-mapped addresses. */
+  on = !!(flags & UV_UDP_RECV_PKTINFO);
+  if (ss.ss_family == AF_INET6) {
+#if defined(IPV6_RECVPKTINFO)
+    if (setsockopt(handle->io_watcher.fd,
+                   IPPROTO_IPV6,
+                   IPV6_RECVPKTINFO,
+                   &on,
+                   sizeof(on))) {
+      return -errno;
+    }
+#else
+    if (on)
+      return -ENOTSUP;
+#endif
+  } else {
+#if defined(IP_PKTINFO)
+    if (setsockopt(handle->io_watcher.fd,
+                   IPPROTO_IP,
+                   IP_PKTINFO,
+                   &on,
+                   sizeof(on))) {
+      return -errno;
+    }
+#elif defined(IP_RECVDSTADDR)
+    if (setsockopt(handle->io_watcher.fd,
+                   IPPROTO_IP,
+                   IP_RECVDSTADDR,
+                   &on,
+                   sizeof(on))) {
+      return -errno;
+    }
+#else
+    if (on)
+      return -ENOTSUP;
+#endif
+  }
+
+  if (flags != 0)
+    handle->flags |= UV_HANDLE_UDP_RECVINFO;
+  else
+    handle->flags &= ~UV_HANDLE_UDP_RECVINFO;
+
+  return 0;
+}
+
+
+/* Parses the control messages of the datagram that is being passed to the
+ * receive callback, they are still in the stack frame that received it.
+ */
+int uv_udp_get_recv_info(const uv_udp_t* handle, uv_udp_recv_info_t* info) {
+  const uv__udp_ext_t* ext;
+  struct sockaddr_in6* addr6;
+  struct sockaddr_in* addr4;
+  struct cmsghdr* cmsg;
+  struct msghdr* h;
+
+  memset(info, 0, sizeof(*info));
+
+  ext = uv__handle_ext(handle);
+  if (ext == NULL || ext->recv_msg == NULL)
+    return -EINVAL;
+
+  h = ext->recv_msg;
+
+  if (h->msg_control == NULL)
+    return 0;
+
+  addr4 = (struct sockaddr_in*) &info->local_addr;
+  addr6 = (struct sockaddr_in6*) &info->local_addr;
+
+  for (cmsg = CMSG_FIRSTHDR(h); cmsg != NULL; cmsg = CMSG_NXTHDR(h, cmsg)) {
+#if defined(UV__SO_TIMESTAMP)
+    if (cmsg->cmsg_level == SOL_SOCKET &&
+        cmsg->cmsg_type == UV__SCM_TIMESTAMP) {
+# if defined(SO_TIMESTAMPNS)
+      struct timespec ts;
+      memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+      info->timestamp.tv_sec = ts.tv_sec;
+      info->timestamp.tv_nsec = ts.tv_nsec;
+# else
+      struct timeval tv;
+      memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+      info->timestamp.tv_sec = tv.tv_sec;
+      info->timestamp.tv_nsec = tv.tv_usec * 1000;
+# endif
+      info->flags |= UV_UDP_RECV_TIMESTAMP;
+      continue;
+    }
+#endif
+
+#if defined(IP_PKTINFO)
+    if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+      struct in_pktinfo pi;
+      memcpy(&pi, CMSG_DATA(cmsg), sizeof(pi));
+      addr4->sin_family = AF_INET;
+      addr4->sin_addr = pi.ipi_addr;
+      info->ifindex = pi.ipi_ifindex;
+      info->flags |= UV_UDP_RECV_PKTINFO;
+      continue;
+    }
+#elif defined(IP_RECVDSTADDR)
+    if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVDSTADDR) {
+      addr4->sin_family = AF_INET;
+      memcpy(&addr4->sin_addr, CMSG_DATA(cmsg), sizeof(addr4->sin_addr));
+      info->flags |= UV_UDP_RECV_PKTINFO;
+      continue;
+    }
+#endif
+
+#if defined(IPV6_RECVPKTINFO)
+    if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO) {
+      struct in6_pktinfo pi6;
+      memcpy(&pi6, CMSG_DATA(cmsg), sizeof(pi6));
+      addr6->sin6_family = AF_INET6;
+      addr6->sin6_addr = pi6.ipi6_addr;
+      info->ifindex = pi6.ipi6_ifindex;
+      info->flags |= UV_UDP_RECV_PKTINFO;
+      continue;
+    }
+#endif
+  }
+
+  return 0;
+}
+
+
 int uv_udp_set_ttl(uv_udp_t* handle, int ttl) {
   if (ttl < 1 || ttl > 255)
     return -EINVAL;
@@ -857,12 +1906,31 @@ int uv_udp_getsockname(const uv_udp_t* handle,
 }
 
 
+int uv_udp_getpeername(const uv_udp_t* handle,
+                       struct sockaddr* name,
+                       int* namelen) {
+  socklen_t socklen;
+
+  if (handle->io_watcher.fd == -1)
+    return -EBADF;
+
+  /* sizeof(socklen_t) != sizeof(int) on some systems. */
+  socklen = (socklen_t) *namelen;
+
+  if (getpeername(handle->io_watcher.fd, name, &socklen))
+    return -errno;
+
+  *namelen = (int) socklen;
+  return 0;
+}
+
+
 int uv__udp_recv_start(uv_udp_t* handle,
                        uv_alloc_cb alloc_cb,
                        uv_udp_recv_cb recv_cb) {
   int err;
 
-  if (alloc_cb == NULL || recv_cb == NULL)
+  if (recv_cb == NULL)
     return -EINVAL;
 
   if (uv__io_active(&handle->io_watcher, POLLIN))
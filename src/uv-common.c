@@ -264,6 +264,63 @@ int uv_udp_bind(uv_udp_t* handle,
 }
 
 
+int uv_udp_bind_group(uv_loop_t* loops[],
+                      uv_udp_t* handles[],
+                      unsigned int count,
+                      const struct sockaddr* addr,
+                      unsigned int flags) {
+  struct sockaddr_storage bound;
+  unsigned int bind_flags;
+  unsigned int i;
+  int namelen;
+  int err;
+
+  if (count == 0)
+    return UV_EINVAL;
+
+  if (addr->sa_family != AF_INET && addr->sa_family != AF_INET6)
+    return UV_EINVAL;
+
+  if (flags & ~(UV_UDP_IPV6ONLY | UV_UDP_REUSEPORT_CPU | UV_UDP_RECVMMSG))
+    return UV_EINVAL;
+
+  bind_flags = UV_UDP_REUSEPORT | (flags & ~UV_UDP_RECVMMSG);
+
+  for (i = 0; i < count; i++) {
+    err = uv_udp_init_ex(loops[i],
+                         handles[i],
+                         addr->sa_family | (flags & UV_UDP_RECVMMSG));
+    if (err)
+      goto fail;
+
+    err = uv_udp_bind(handles[i], addr, bind_flags);
+    if (err) {
+      i++;
+      goto fail;
+    }
+
+    /* The rest of the group joins the port that the first one got. */
+    if (i == 0) {
+      namelen = sizeof(bound);
+      err = uv_udp_getsockname(handles[0], (struct sockaddr*) &bound, &namelen);
+      if (err) {
+        i++;
+        goto fail;
+      }
+      addr = (const struct sockaddr*) &bound;
+    }
+  }
+
+  return 0;
+
+fail:
+  while (i > 0)
+    uv_close((uv_handle_t*) handles[--i], NULL);
+
+  return err;
+}
+
+
 int uv_tcp_connect(uv_connect_t* req,
                    uv_tcp_t* handle,
                    const struct sockaddr* addr,
@@ -284,17 +341,20 @@ int uv_tcp_connect(uv_connect_t* req,
 }
 
 
-int uv_udp_send(uv_udp_send_t* req,
-                uv_udp_t* handle,
-                const uv_buf_t bufs[],
-                unsigned int nbufs,
-                const struct sockaddr* addr,
-                uv_udp_send_cb send_cb) {
+int uv_udp_connect(uv_udp_t* handle, const struct sockaddr* addr) {
   unsigned int addrlen;
 
   if (handle->type != UV_UDP)
     return UV_EINVAL;
 
+  /* Disconnect the handle */
+  if (addr == NULL) {
+    if (!uv__udp_is_connected(handle))
+      return UV_ENOTCONN;
+
+    return uv__udp_disconnect(handle);
+  }
+
   if (addr->sa_family == AF_INET)
     addrlen = sizeof(struct sockaddr_in);
   else if (addr->sa_family == AF_INET6)
@@ -302,34 +362,124 @@ int uv_udp_send(uv_udp_send_t* req,
   else
     return UV_EINVAL;
 
-  return uv__udp_send(req, handle, bufs, nbufs, addr, addrlen, send_cb);
-}
+  if (uv__udp_is_connected(handle))
+    return UV_EISCONN;
 
+  return uv__udp_connect(handle, addr, addrlen);
+}
 
-int uv_udp_try_send(uv_udp_t* handle,
-                    const uv_buf_t bufs[],
-                    unsigned int nbufs,
-                    const struct sockaddr* addr) {
-  unsigned int addrlen;
 
+/* Returns the length of `addr`, 0 for a connected handle that sends without
+ * an address, or an error code < 0.
+ */
+static int uv__udp_check_before_send(uv_udp_t* handle,
+                                     const struct sockaddr* addr) {
   if (handle->type != UV_UDP)
     return UV_EINVAL;
 
+  if (addr != NULL && uv__udp_is_connected(handle))
+    return UV_EISCONN;
+
+  if (addr == NULL && !uv__udp_is_connected(handle))
+    return UV_EDESTADDRREQ;
+
+  if (addr == NULL)
+    return 0;
+
   if (addr->sa_family == AF_INET)
-    addrlen = sizeof(struct sockaddr_in);
+    return sizeof(struct sockaddr_in);
   else if (addr->sa_family == AF_INET6)
-    addrlen = sizeof(struct sockaddr_in6);
+    return sizeof(struct sockaddr_in6);
   else
     return UV_EINVAL;
+}
+
+
+int uv_udp_send(uv_udp_send_t* req,
+                uv_udp_t* handle,
+                const uv_buf_t bufs[],
+                unsigned int nbufs,
+                const struct sockaddr* addr,
+                uv_udp_send_cb send_cb) {
+  int addrlen;
+
+  addrlen = uv__udp_check_before_send(handle, addr);
+  if (addrlen < 0)
+    return addrlen;
+
+  return uv__udp_send(req, handle, bufs, nbufs, addr, addrlen, send_cb);
+}
+
+
+int uv_udp_send_segmented(uv_udp_send_t* req,
+                          uv_udp_t* handle,
+                          const uv_buf_t bufs[],
+                          unsigned int nbufs,
+                          size_t segment_size,
+                          const struct sockaddr* addr,
+                          uv_udp_send_cb send_cb) {
+  int addrlen;
+
+  if (segment_size == 0 || segment_size > 65535)
+    return UV_EINVAL;
+
+  addrlen = uv__udp_check_before_send(handle, addr);
+  if (addrlen < 0)
+    return addrlen;
+
+  return uv__udp_send_segmented(req,
+                                handle,
+                                bufs,
+                                nbufs,
+                                segment_size,
+                                addr,
+                                addrlen,
+                                send_cb);
+}
+
+
+int uv_udp_try_send(uv_udp_t* handle,
+                    const uv_buf_t bufs[],
+                    unsigned int nbufs,
+                    const struct sockaddr* addr) {
+  int addrlen;
+
+  addrlen = uv__udp_check_before_send(handle, addr);
+  if (addrlen < 0)
+    return addrlen;
 
   return uv__udp_try_send(handle, bufs, nbufs, addr, addrlen);
 }
 
 
+int uv_udp_try_send_batch(uv_udp_t* handle,
+                          unsigned int count,
+                          uv_buf_t* bufs[],
+                          unsigned int nbufs[],
+                          struct sockaddr* addrs[]) {
+  unsigned int i;
+  int err;
+
+  if (count == 0)
+    return UV_EINVAL;
+
+  /* No addresses means the handle is connected. */
+  for (i = 0; i < count; i++) {
+    err = uv__udp_check_before_send(handle, addrs ? addrs[i] : NULL);
+    if (err < 0)
+      return err;
+    if (addrs == NULL)
+      break;
+  }
+
+  return uv__udp_try_send_batch(handle, count, bufs, nbufs, addrs);
+}
+
+
 int uv_udp_recv_start(uv_udp_t* handle,
                       uv_alloc_cb alloc_cb,
                       uv_udp_recv_cb recv_cb) {
-  if (handle->type != UV_UDP || alloc_cb == NULL || recv_cb == NULL)
+  if (handle->type != UV_UDP || recv_cb == NULL)
     return UV_EINVAL;
   else
     return uv__udp_recv_start(handle, alloc_cb, recv_cb);
@@ -617,7 +767,7 @@ int uv_loop_close(uv_loop_t* loop) {
   void* saved_data;
 #endif
 
-  if (!QUEUE_EMPTY(&(loop)->active_reqs))
+  if (uv__has_active_reqs(loop))
     return UV_EBUSY;
 
   QUEUE_FOREACH(q, &loop->handle_queue) {
@@ -237,8 +237,9 @@ int uv_loop_init(uv_loop_t* loop) {
 
   QUEUE_INIT(&loop->wq);
   QUEUE_INIT(&loop->handle_queue);
-  QUEUE_INIT(&loop->active_reqs);
+  loop->active_reqs.count = 0;
   loop->active_handles = 0;
+  loop->internal_fields = NULL;
 
   loop->pending_reqs_tail = NULL;
 
@@ -327,6 +328,12 @@ int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap) {
 }
 
 
+int uv_loop_memory_stats(const uv_loop_t* loop,
+                         uv_loop_memory_stats_t* stats) {
+  return UV_ENOTSUP;
+}
+
+
 int uv_backend_fd(const uv_loop_t* loop) {
   return -1;
 }
@@ -464,7 +471,7 @@ static void uv_poll_ex(uv_loop_t* loop, DWORD timeout) {
 
 static int uv__loop_alive(const uv_loop_t* loop) {
   return loop->active_handles > 0 ||
-         !QUEUE_EMPTY(&loop->active_reqs) ||
+         uv__has_active_reqs(loop) ||
          loop->endgame_handles != NULL;
 }
 
@@ -569,6 +576,29 @@ int uv_fileno(const uv_handle_t* handle, uv_os_fd_t* fd) {
 }
 
 
+int uv_read_size_mode(uv_handle_t* handle, unsigned int flags) {
+  if (flags & ~(UV_READ_SIZE_ADAPTIVE | UV_READ_SIZE_FIONREAD))
+    return UV_EINVAL;
+
+  switch (handle->type) {
+  case UV_TCP:
+  case UV_NAMED_PIPE:
+  case UV_TTY:
+  case UV_UDP:
+    break;
+
+  default:
+    return UV_EINVAL;
+  }
+
+  /* Reads are completed by the IOCP machinery with a fixed size buffer. */
+  if (flags != 0)
+    return UV_ENOTSUP;
+
+  return 0;
+}
+
+
 int uv__socket_sockopt(uv_handle_t* handle, int optname, int* value) {
   int r;
   int len;
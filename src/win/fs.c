@@ -1259,6 +1259,19 @@ static void fs__rename(uv_fs_t* req) {
 }
 
 
+static void fs__copyfile(uv_fs_t* req) {
+  BOOL fail_if_exists;
+
+  fail_if_exists = (req->fs.info.file_flags & UV_FS_COPYFILE_EXCL) != 0;
+  if (!CopyFileW(req->file.pathw, req->fs.info.new_pathw, fail_if_exists)) {
+    SET_REQ_WIN32_ERROR(req, GetLastError());
+    return;
+  }
+
+  SET_REQ_RESULT(req, 0);
+}
+
+
 INLINE static void fs__sync_impl(uv_fs_t* req) {
   int fd = req->file.fd;
   int result;
@@ -1850,6 +1863,7 @@ static void uv__fs_work(struct uv__work* w) {
     XX(MKDIR, mkdir)
     XX(MKDTEMP, mkdtemp)
     XX(RENAME, rename)
+    XX(COPYFILE, copyfile)
     XX(SCANDIR, scandir)
     XX(LINK, link)
     XX(SYMLINK, symlink)
@@ -2301,6 +2315,32 @@ int uv_fs_fstat(uv_loop_t* loop, uv_fs_t* req, uv_file fd, uv_fs_cb cb) {
 }
 
 
+int uv_fs_copyfile(uv_loop_t* loop, uv_fs_t* req, const char* path,
+    const char* new_path, int flags, uv_fs_cb cb) {
+  int err;
+
+  if (flags & ~UV_FS_COPYFILE_EXCL)
+    return UV_EINVAL;
+
+  uv_fs_req_init(loop, req, UV_FS_COPYFILE, cb);
+
+  err = fs__capture_path(req, path, new_path, cb != NULL);
+  if (err) {
+    return uv_translate_sys_error(err);
+  }
+
+  req->fs.info.file_flags = flags;
+
+  if (cb) {
+    QUEUE_FS_TP_JOB(loop, req);
+    return 0;
+  } else {
+    fs__copyfile(req);
+    return req->result;
+  }
+}
+
+
 int uv_fs_rename(uv_loop_t* loop, uv_fs_t* req, const char* path,
     const char* new_path, uv_fs_cb cb) {
   int err;
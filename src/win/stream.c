@@ -203,6 +203,14 @@ int uv_try_write(uv_stream_t* stream,
 }
 
 
+int uv_write_copy(uv_stream_t* stream,
+                  const uv_buf_t bufs[],
+                  unsigned int nbufs,
+                  uv_write_copy_cb cb) {
+  return UV_ENOTSUP;
+}
+
+
 int uv_shutdown(uv_shutdown_t* req, uv_stream_t* handle, uv_shutdown_cb cb) {
   uv_loop_t* loop = handle->loop;
 
@@ -247,3 +255,35 @@ int uv_stream_set_blocking(uv_stream_t* handle, int blocking) {
 
   return 0;
 }
+
+
+int uv_stream_set_watermarks(uv_stream_t* handle,
+                             size_t high,
+                             size_t low,
+                             uv_drain_cb drain_cb) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_stream_is_above_watermark(const uv_stream_t* handle) {
+  return 0;
+}
+
+
+int uv_stream_set_peer(uv_stream_t* handle, uv_stream_t* peer) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_stream_set_rate_limit(uv_stream_t* handle,
+                             uint64_t rate,
+                             size_t burst) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_stream_set_idle_timeout(uv_stream_t* handle,
+                               uint64_t timeout,
+                               uv_timeout_cb cb) {
+  return UV_ENOTSUP;
+}
@@ -1337,6 +1337,57 @@ int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable) {
 }
 
 
+int uv_tcp_fastopen(uv_tcp_t* handle, int enable, unsigned int qlen) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_tcp_notsent_lowat(uv_tcp_t* handle, unsigned int bytes) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_tcp_get_info(const uv_tcp_t* handle, uv_tcp_info_t* info) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_tcp_get_info_all(uv_loop_t* loop, uv_tcp_info_cb cb, void* arg) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_tcp_connect_multi(uv_connect_t* req,
+                         uv_tcp_t* handle,
+                         const struct addrinfo* ai,
+                         uv_connect_cb cb) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_accept_group_init(uv_accept_group_t* group, unsigned int flags) {
+  return UV_ENOTSUP;
+}
+
+
+void uv_accept_group_destroy(uv_accept_group_t* group) {
+}
+
+
+int uv_accept_group_listen(uv_accept_group_t* group,
+                           uv_tcp_t* server,
+                           int backlog) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_accept_group_join(uv_accept_group_t* group,
+                         uv_tcp_t* worker,
+                         uv_connection_cb cb) {
+  return UV_ENOTSUP;
+}
+
+
 static int uv_tcp_try_cancel_io(uv_tcp_t* tcp) {
   SOCKET socket = tcp->socket;
   int non_ifs_lsp;
@@ -1484,6 +1535,9 @@ int uv__tcp_bind(uv_tcp_t* handle,
                  unsigned int flags) {
   int err;
 
+  if (flags & (UV_TCP_REUSEPORT | UV_TCP_REUSEPORT_CPU))
+    return UV_ENOTSUP;
+
   err = uv_tcp_try_bind(handle, addr, addrlen, flags);
   if (err)
     return uv_translate_sys_error(err);
@@ -131,7 +131,8 @@ int uv_udp_init_ex(uv_loop_t* loop, uv_udp_t* handle, unsigned int flags) {
   if (domain != AF_INET && domain != AF_INET6 && domain != AF_UNSPEC)
     return UV_EINVAL;
 
-  if (flags & ~0xFF)
+  /* UV_UDP_RECVMMSG is accepted but has no effect on Windows. */
+  if (flags & ~(0xFF | UV_UDP_RECVMMSG))
     return UV_EINVAL;
 
   uv__handle_init(loop, (uv_handle_t*) handle, UV_UDP);
@@ -369,6 +370,10 @@ int uv__udp_recv_start(uv_udp_t* handle, uv_alloc_cb alloc_cb,
   uv_loop_t* loop = handle->loop;
   int err;
 
+  /* No library-managed receive slab yet. */
+  if (alloc_cb == NULL)
+    return UV_ENOTSUP;
+
   if (handle->flags & UV_HANDLE_READING) {
     return WSAEALREADY;
   }
@@ -868,6 +873,37 @@ SOCKOPT_SETTER(multicast_loop,
 #undef VALIDATE_MULTICAST_LOOP
 
 
+int uv_udp_set_gro(uv_udp_t* handle, int on) {
+  return UV_ENOTSUP;
+}
+
+
+size_t uv_udp_get_gro_segment_size(const uv_udp_t* handle) {
+  return 0;
+}
+
+
+int uv_udp_set_drop_counter(uv_udp_t* handle, int on) {
+  return UV_ENOTSUP;
+}
+
+
+uint64_t uv_udp_get_drop_counter(const uv_udp_t* handle) {
+  return 0;
+}
+
+
+int uv_udp_set_recv_info(uv_udp_t* handle, unsigned int flags) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_udp_get_recv_info(const uv_udp_t* handle, uv_udp_recv_info_t* info) {
+  memset(info, 0, sizeof(*info));
+  return UV_ENOTSUP;
+}
+
+
 /* This function is an egress point, i.e. it returns libuv errors rather than
  * system errors.
  */
@@ -877,6 +913,9 @@ int uv__udp_bind(uv_udp_t* handle,
                  unsigned int flags) {
   int err;
 
+  if (flags & (UV_UDP_REUSEPORT | UV_UDP_REUSEPORT_CPU))
+    return UV_ENOTSUP;
+
   err = uv_udp_maybe_bind(handle, addr, addrlen, flags);
   if (err)
     return uv_translate_sys_error(err);
@@ -919,6 +958,42 @@ int uv__udp_send(uv_udp_send_t* req,
 }
 
 
+int uv__udp_connect(uv_udp_t* handle,
+                    const struct sockaddr* addr,
+                    unsigned int addrlen) {
+  return UV_ENOTSUP;
+}
+
+
+int uv__udp_disconnect(uv_udp_t* handle) {
+  return UV_ENOTSUP;
+}
+
+
+int uv__udp_is_connected(const uv_udp_t* handle) {
+  return 0;
+}
+
+
+int uv_udp_getpeername(const uv_udp_t* handle,
+                       struct sockaddr* name,
+                       int* namelen) {
+  return UV_ENOTSUP;
+}
+
+
+int uv__udp_send_segmented(uv_udp_send_t* req,
+                           uv_udp_t* handle,
+                           const uv_buf_t bufs[],
+                           unsigned int nbufs,
+                           size_t segment_size,
+                           const struct sockaddr* addr,
+                           unsigned int addrlen,
+                           uv_udp_send_cb send_cb) {
+  return UV_ENOSYS;
+}
+
+
 int uv__udp_try_send(uv_udp_t* handle,
                      const uv_buf_t bufs[],
                      unsigned int nbufs,
@@ -926,3 +1001,12 @@ int uv__udp_try_send(uv_udp_t* handle,
                      unsigned int addrlen) {
   return UV_ENOSYS;
 }
+
+
+int uv__udp_try_send_batch(uv_udp_t* handle,
+                           unsigned int count,
+                           uv_buf_t* bufs[],
+                           unsigned int nbufs[],
+                           struct sockaddr* addrs[]) {
+  return UV_ENOSYS;
+}
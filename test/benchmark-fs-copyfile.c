@@ -0,0 +1,207 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "task.h"
+#include "uv.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define SRC_PATH "benchmark_copyfile_src"
+#define DST_PATH "benchmark_copyfile_dst"
+#define FILE_SIZE (64 * 1024 * 1024)
+#define CHUNK_SIZE (64 * 1024)
+#define NUM_COPIES 8
+
+/* State of the read/write copy, one chunk per threadpool round trip. */
+static uv_fs_t rw_req;
+static uv_file rw_src;
+static uv_file rw_dst;
+static int64_t rw_off;
+static char rw_buf[CHUNK_SIZE];
+static unsigned int roundtrips;
+
+static void rw_read_cb(uv_fs_t* req);
+
+
+static void make_source(void) {
+  static char chunk[CHUNK_SIZE];
+  uv_fs_t req;
+  uv_buf_t buf;
+  int64_t off;
+  int fd;
+
+  memset(chunk, 'x', sizeof(chunk));
+  fd = uv_fs_open(NULL, &req, SRC_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644,
+                  NULL);
+  ASSERT(fd >= 0);
+  uv_fs_req_cleanup(&req);
+
+  buf = uv_buf_init(chunk, sizeof(chunk));
+  for (off = 0; off < FILE_SIZE; off += sizeof(chunk)) {
+    ASSERT(sizeof(chunk) == uv_fs_write(NULL, &req, fd, &buf, 1, off, NULL));
+    uv_fs_req_cleanup(&req);
+  }
+
+  ASSERT(0 == uv_fs_close(NULL, &req, fd, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void remove_file(const char* path) {
+  uv_fs_t req;
+
+  uv_fs_unlink(NULL, &req, path, NULL);
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void copyfile_cb(uv_fs_t* req) {
+  ASSERT(req->result == 0);
+  roundtrips++;
+  uv_fs_req_cleanup(req);
+}
+
+
+static void rw_write_cb(uv_fs_t* req) {
+  uv_buf_t buf;
+
+  ASSERT(req->result > 0);
+  rw_off += req->result;
+  roundtrips++;
+  uv_fs_req_cleanup(req);
+
+  buf = uv_buf_init(rw_buf, sizeof(rw_buf));
+  ASSERT(0 == uv_fs_read(uv_default_loop(),
+                         &rw_req,
+                         rw_src,
+                         &buf,
+                         1,
+                         rw_off,
+                         rw_read_cb));
+}
+
+
+static void rw_read_cb(uv_fs_t* req) {
+  uv_buf_t buf;
+
+  ASSERT(req->result >= 0);
+  roundtrips++;
+  if (req->result == 0) {
+    uv_fs_req_cleanup(req);
+    return;
+  }
+
+  buf = uv_buf_init(rw_buf, req->result);
+  uv_fs_req_cleanup(req);
+  ASSERT(0 == uv_fs_write(uv_default_loop(),
+                          &rw_req,
+                          rw_dst,
+                          &buf,
+                          1,
+                          rw_off,
+                          rw_write_cb));
+}
+
+
+static void copy_read_write(void) {
+  uv_fs_t req;
+  uv_buf_t buf;
+
+  rw_src = uv_fs_open(NULL, &req, SRC_PATH, O_RDONLY, 0, NULL);
+  ASSERT(rw_src >= 0);
+  uv_fs_req_cleanup(&req);
+  rw_dst = uv_fs_open(NULL, &req, DST_PATH, O_WRONLY | O_CREAT | O_TRUNC,
+                      0644, NULL);
+  ASSERT(rw_dst >= 0);
+  uv_fs_req_cleanup(&req);
+
+  rw_off = 0;
+  buf = uv_buf_init(rw_buf, sizeof(rw_buf));
+  ASSERT(0 == uv_fs_read(uv_default_loop(),
+                         &rw_req,
+                         rw_src,
+                         &buf,
+                         1,
+                         0,
+                         rw_read_cb));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(rw_off == FILE_SIZE);
+
+  ASSERT(0 == uv_fs_close(NULL, &req, rw_src, NULL));
+  uv_fs_req_cleanup(&req);
+  ASSERT(0 == uv_fs_close(NULL, &req, rw_dst, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void copy_copyfile(void) {
+  uv_fs_t req;
+
+  ASSERT(0 == uv_fs_copyfile(uv_default_loop(),
+                             &req,
+                             SRC_PATH,
+                             DST_PATH,
+                             0,
+                             copyfile_cb));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+}
+
+
+static void run(const char* name, void (*copy)(void)) {
+  uint64_t before;
+  uint64_t after;
+  double seconds;
+  int i;
+
+  roundtrips = 0;
+  before = uv_hrtime();
+  for (i = 0; i < NUM_COPIES; i++) {
+    remove_file(DST_PATH);
+    copy();
+  }
+  after = uv_hrtime();
+
+  seconds = (after - before) / 1e9;
+  printf("fs_copyfile (%s): %d x %d MB in %.2fs, %.0f MB/s, "
+         "%u threadpool round trips\n",
+         name,
+         NUM_COPIES,
+         FILE_SIZE / (1024 * 1024),
+         seconds,
+         (double) NUM_COPIES * FILE_SIZE / (1024 * 1024) / seconds,
+         roundtrips);
+  fflush(stdout);
+}
+
+
+/* Copies a file that is hot in the page cache, so the numbers show the cost
+ * of moving the data rather than the speed of the disk.
+ */
+BENCHMARK_IMPL(fs_copyfile) {
+  make_source();
+  run("read/write", copy_read_write);
+  run("uv_fs_copyfile", copy_copyfile);
+  remove_file(SRC_PATH);
+  remove_file(DST_PATH);
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
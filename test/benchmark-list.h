@@ -23,19 +23,43 @@ BENCHMARK_DECLARE (sizes)
 BENCHMARK_DECLARE (loop_count)
 BENCHMARK_DECLARE (loop_count_timed)
 BENCHMARK_DECLARE (ping_pongs)
+BENCHMARK_DECLARE (ping_pongs_adaptive)
 BENCHMARK_DECLARE (tcp_write_batch)
+BENCHMARK_DECLARE (tcp_write_batch_queued)
+BENCHMARK_DECLARE (tcp_write_copy)
+BENCHMARK_DECLARE (loop_fairness)
+BENCHMARK_DECLARE (loop_fairness_budget)
+BENCHMARK_DECLARE (tcp_connect_first_byte)
+BENCHMARK_DECLARE (tcp_connect_first_byte_fastopen)
+BENCHMARK_DECLARE (tcp_notsent_lowat_off)
+BENCHMARK_DECLARE (tcp_notsent_lowat)
+BENCHMARK_DECLARE (stream_rate_limit_pipe)
+BENCHMARK_DECLARE (stream_rate_limit_tcp)
+BENCHMARK_DECLARE (stream_idle_timeout_timers)
+BENCHMARK_DECLARE (stream_idle_timeout)
 BENCHMARK_DECLARE (tcp4_pound_100)
 BENCHMARK_DECLARE (tcp4_pound_1000)
 BENCHMARK_DECLARE (pipe_pound_100)
 BENCHMARK_DECLARE (pipe_pound_1000)
 BENCHMARK_DECLARE (tcp_pump100_client)
 BENCHMARK_DECLARE (tcp_pump1_client)
+BENCHMARK_DECLARE (tcp_pump100_adaptive_client)
+BENCHMARK_DECLARE (tcp_pump1_adaptive_client)
 BENCHMARK_DECLARE (pipe_pump100_client)
 BENCHMARK_DECLARE (pipe_pump1_client)
 
 BENCHMARK_DECLARE (tcp_multi_accept2)
 BENCHMARK_DECLARE (tcp_multi_accept4)
 BENCHMARK_DECLARE (tcp_multi_accept8)
+BENCHMARK_DECLARE (tcp_multi_accept2_exclusive)
+BENCHMARK_DECLARE (tcp_multi_accept4_exclusive)
+BENCHMARK_DECLARE (tcp_multi_accept8_exclusive)
+BENCHMARK_DECLARE (tcp_multi_accept2_group)
+BENCHMARK_DECLARE (tcp_multi_accept4_group)
+BENCHMARK_DECLARE (tcp_multi_accept8_group)
+BENCHMARK_DECLARE (tcp_multi_accept2_reuseport)
+BENCHMARK_DECLARE (tcp_multi_accept4_reuseport)
+BENCHMARK_DECLARE (tcp_multi_accept8_reuseport)
 
 /* Run until X packets have been sent/received. */
 BENCHMARK_DECLARE (udp_pummel_1v1)
@@ -48,6 +72,14 @@ BENCHMARK_DECLARE (udp_pummel_10v1000)
 BENCHMARK_DECLARE (udp_pummel_100v100)
 BENCHMARK_DECLARE (udp_pummel_100v1000)
 BENCHMARK_DECLARE (udp_pummel_1000v1000)
+BENCHMARK_DECLARE (udp_pummel_mmsg_1v1)
+BENCHMARK_DECLARE (udp_pummel_mmsg_10v10)
+BENCHMARK_DECLARE (udp_pummel_mmsg_100v100)
+BENCHMARK_DECLARE (udp_pummel_mmsg_1000v1000)
+BENCHMARK_DECLARE (udp_pummel_connected_1v1)
+BENCHMARK_DECLARE (udp_pummel_connected_10v10)
+BENCHMARK_DECLARE (udp_pummel_connected_100v100)
+BENCHMARK_DECLARE (udp_pummel_connected_1000v1000)
 
 /* Run until X seconds have elapsed. */
 BENCHMARK_DECLARE (udp_timed_pummel_1v1)
@@ -60,9 +92,24 @@ BENCHMARK_DECLARE (udp_timed_pummel_10v1000)
 BENCHMARK_DECLARE (udp_timed_pummel_100v100)
 BENCHMARK_DECLARE (udp_timed_pummel_100v1000)
 BENCHMARK_DECLARE (udp_timed_pummel_1000v1000)
+BENCHMARK_DECLARE (udp_timed_pummel_mmsg_1v1)
+BENCHMARK_DECLARE (udp_timed_pummel_mmsg_10v10)
+BENCHMARK_DECLARE (udp_timed_pummel_mmsg_100v100)
+BENCHMARK_DECLARE (udp_timed_pummel_mmsg_1000v1000)
+BENCHMARK_DECLARE (udp_timed_pummel_connected_1v1)
+BENCHMARK_DECLARE (udp_timed_pummel_connected_10v10)
+BENCHMARK_DECLARE (udp_timed_pummel_connected_100v100)
+BENCHMARK_DECLARE (udp_timed_pummel_connected_1000v1000)
+BENCHMARK_DECLARE (udp_pummel_reuseport_1)
+BENCHMARK_DECLARE (udp_pummel_reuseport_2)
+BENCHMARK_DECLARE (udp_pummel_reuseport_4)
+BENCHMARK_DECLARE (udp_send_unsegmented)
+BENCHMARK_DECLARE (udp_send_segmented)
+BENCHMARK_DECLARE (udp_send_segmented_gro)
 
 BENCHMARK_DECLARE (getaddrinfo)
 BENCHMARK_DECLARE (fs_stat)
+BENCHMARK_DECLARE (fs_copyfile)
 BENCHMARK_DECLARE (async1)
 BENCHMARK_DECLARE (async2)
 BENCHMARK_DECLARE (async4)
@@ -77,6 +124,7 @@ BENCHMARK_DECLARE (million_async)
 BENCHMARK_DECLARE (million_timers)
 HELPER_DECLARE    (tcp4_blackhole_server)
 HELPER_DECLARE    (tcp_pump_server)
+HELPER_DECLARE    (tcp_pump_adaptive_server)
 HELPER_DECLARE    (pipe_pump_server)
 HELPER_DECLARE    (tcp4_echo_server)
 HELPER_DECLARE    (pipe_echo_server)
@@ -90,15 +138,43 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (ping_pongs)
   BENCHMARK_HELPER (ping_pongs, tcp4_echo_server)
 
+  BENCHMARK_ENTRY  (ping_pongs_adaptive)
+  BENCHMARK_HELPER (ping_pongs_adaptive, tcp4_echo_server)
+
   BENCHMARK_ENTRY  (tcp_write_batch)
   BENCHMARK_HELPER (tcp_write_batch, tcp4_blackhole_server)
 
+  BENCHMARK_ENTRY  (tcp_write_batch_queued)
+  BENCHMARK_HELPER (tcp_write_batch_queued, tcp4_blackhole_server)
+
+  BENCHMARK_ENTRY  (tcp_write_copy)
+  BENCHMARK_HELPER (tcp_write_copy, tcp4_blackhole_server)
+
+  BENCHMARK_ENTRY  (loop_fairness)
+  BENCHMARK_ENTRY  (loop_fairness_budget)
+
+  BENCHMARK_ENTRY  (tcp_connect_first_byte)
+  BENCHMARK_ENTRY  (tcp_connect_first_byte_fastopen)
+
+  BENCHMARK_ENTRY  (tcp_notsent_lowat_off)
+  BENCHMARK_ENTRY  (tcp_notsent_lowat)
+  BENCHMARK_ENTRY  (stream_rate_limit_pipe)
+  BENCHMARK_ENTRY  (stream_rate_limit_tcp)
+  BENCHMARK_ENTRY  (stream_idle_timeout_timers)
+  BENCHMARK_ENTRY  (stream_idle_timeout)
+
   BENCHMARK_ENTRY  (tcp_pump100_client)
   BENCHMARK_HELPER (tcp_pump100_client, tcp_pump_server)
 
   BENCHMARK_ENTRY  (tcp_pump1_client)
   BENCHMARK_HELPER (tcp_pump1_client, tcp_pump_server)
 
+  BENCHMARK_ENTRY  (tcp_pump100_adaptive_client)
+  BENCHMARK_HELPER (tcp_pump100_adaptive_client, tcp_pump_adaptive_server)
+
+  BENCHMARK_ENTRY  (tcp_pump1_adaptive_client)
+  BENCHMARK_HELPER (tcp_pump1_adaptive_client, tcp_pump_adaptive_server)
+
   BENCHMARK_ENTRY  (tcp4_pound_100)
   BENCHMARK_HELPER (tcp4_pound_100, tcp4_echo_server)
 
@@ -120,6 +196,15 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (tcp_multi_accept2)
   BENCHMARK_ENTRY  (tcp_multi_accept4)
   BENCHMARK_ENTRY  (tcp_multi_accept8)
+  BENCHMARK_ENTRY  (tcp_multi_accept2_exclusive)
+  BENCHMARK_ENTRY  (tcp_multi_accept4_exclusive)
+  BENCHMARK_ENTRY  (tcp_multi_accept8_exclusive)
+  BENCHMARK_ENTRY  (tcp_multi_accept2_group)
+  BENCHMARK_ENTRY  (tcp_multi_accept4_group)
+  BENCHMARK_ENTRY  (tcp_multi_accept8_group)
+  BENCHMARK_ENTRY  (tcp_multi_accept2_reuseport)
+  BENCHMARK_ENTRY  (tcp_multi_accept4_reuseport)
+  BENCHMARK_ENTRY  (tcp_multi_accept8_reuseport)
 
   BENCHMARK_ENTRY  (udp_pummel_1v1)
   BENCHMARK_ENTRY  (udp_pummel_1v10)
@@ -131,6 +216,14 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (udp_pummel_100v100)
   BENCHMARK_ENTRY  (udp_pummel_100v1000)
   BENCHMARK_ENTRY  (udp_pummel_1000v1000)
+  BENCHMARK_ENTRY  (udp_pummel_mmsg_1v1)
+  BENCHMARK_ENTRY  (udp_pummel_mmsg_10v10)
+  BENCHMARK_ENTRY  (udp_pummel_mmsg_100v100)
+  BENCHMARK_ENTRY  (udp_pummel_mmsg_1000v1000)
+  BENCHMARK_ENTRY  (udp_pummel_connected_1v1)
+  BENCHMARK_ENTRY  (udp_pummel_connected_10v10)
+  BENCHMARK_ENTRY  (udp_pummel_connected_100v100)
+  BENCHMARK_ENTRY  (udp_pummel_connected_1000v1000)
 
   BENCHMARK_ENTRY  (udp_timed_pummel_1v1)
   BENCHMARK_ENTRY  (udp_timed_pummel_1v10)
@@ -142,10 +235,25 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (udp_timed_pummel_100v100)
   BENCHMARK_ENTRY  (udp_timed_pummel_100v1000)
   BENCHMARK_ENTRY  (udp_timed_pummel_1000v1000)
+  BENCHMARK_ENTRY  (udp_timed_pummel_mmsg_1v1)
+  BENCHMARK_ENTRY  (udp_timed_pummel_mmsg_10v10)
+  BENCHMARK_ENTRY  (udp_timed_pummel_mmsg_100v100)
+  BENCHMARK_ENTRY  (udp_timed_pummel_mmsg_1000v1000)
+  BENCHMARK_ENTRY  (udp_timed_pummel_connected_1v1)
+  BENCHMARK_ENTRY  (udp_timed_pummel_connected_10v10)
+  BENCHMARK_ENTRY  (udp_timed_pummel_connected_100v100)
+  BENCHMARK_ENTRY  (udp_timed_pummel_connected_1000v1000)
+  BENCHMARK_ENTRY  (udp_pummel_reuseport_1)
+  BENCHMARK_ENTRY  (udp_pummel_reuseport_2)
+  BENCHMARK_ENTRY  (udp_pummel_reuseport_4)
+  BENCHMARK_ENTRY  (udp_send_unsegmented)
+  BENCHMARK_ENTRY  (udp_send_segmented)
+  BENCHMARK_ENTRY  (udp_send_segmented_gro)
 
   BENCHMARK_ENTRY  (getaddrinfo)
 
   BENCHMARK_ENTRY  (fs_stat)
+  BENCHMARK_ENTRY  (fs_copyfile)
 
   BENCHMARK_ENTRY  (async1)
   BENCHMARK_ENTRY  (async2)
@@ -0,0 +1,320 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* One loop serves a connection that floods it with data and a connection
+ * that plays ping-pong. Reports the round trip latencies of the latter.
+ */
+
+#define NUM_PINGS     2000
+#define FLOOD_SIZE    (64 * 1024)
+#define FLOOD_WRITES  8
+#define PING          "PING"
+
+typedef struct {
+  uv_tcp_t handle;
+  int echo;
+} server_conn;
+
+static uv_thread_t server_tid;
+static uv_sem_t server_ready;
+static uv_async_t server_done;
+static uv_tcp_t server;
+static int server_budget;
+
+static uv_tcp_t flood_client;
+static uv_tcp_t ping_client;
+static uv_connect_t flood_connect_req;
+static uv_connect_t ping_connect_req;
+static uv_write_t flood_write_reqs[FLOOD_WRITES];
+static uv_write_t ping_write_req;
+static char flood_data[FLOOD_SIZE];
+static char server_buf[FLOOD_SIZE];
+static char ping_buf[sizeof(PING)];
+static int stopping;
+
+static uint64_t latencies[NUM_PINGS];
+static uint64_t ping_start;
+static size_t ping_nread;
+static int pings;
+
+
+static void server_alloc_cb(uv_handle_t* handle,
+                            size_t suggested_size,
+                            uv_buf_t* buf) {
+  /* Only the loop thread touches it and the contents are thrown away. */
+  buf->base = server_buf;
+  buf->len = sizeof(server_buf);
+}
+
+
+static void server_close_cb(uv_handle_t* handle) {
+  free(handle);
+}
+
+
+static void server_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  server_conn* conn;
+  uv_buf_t reply;
+
+  conn = (server_conn*) stream;
+
+  if (nread < 0) {
+    uv_close((uv_handle_t*) stream, server_close_cb);
+    return;
+  }
+
+  if (nread == 0)
+    return;
+
+  if (buf->base[0] == PING[0])
+    conn->echo = 1;
+
+  if (conn->echo) {
+    reply = uv_buf_init(buf->base, nread);
+    ASSERT(nread == uv_try_write(stream, &reply, 1));
+  }
+}
+
+
+static void server_connection_cb(uv_stream_t* stream, int status) {
+  server_conn* conn;
+
+  ASSERT(status == 0);
+
+  conn = calloc(1, sizeof(*conn));
+  ASSERT(conn != NULL);
+  ASSERT(0 == uv_tcp_init(stream->loop, &conn->handle));
+  ASSERT(0 == uv_accept(stream, (uv_stream_t*) &conn->handle));
+  ASSERT(0 == uv_tcp_nodelay(&conn->handle, 1));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &conn->handle,
+                            server_alloc_cb,
+                            server_read_cb));
+}
+
+
+static void server_close_walk_cb(uv_handle_t* handle, void* arg) {
+  if (uv_is_closing(handle))
+    return;
+
+  if (handle == (uv_handle_t*) &server || handle == (uv_handle_t*) &server_done)
+    uv_close(handle, NULL);
+  else
+    uv_close(handle, server_close_cb);
+}
+
+
+static void server_done_cb(uv_async_t* handle) {
+  uv_walk(handle->loop, server_close_walk_cb, NULL);
+}
+
+
+static void server_thread(void* arg) {
+  struct sockaddr_in addr;
+  uv_loop_t loop;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  /* Read at most 64 kB per connection and tick. */
+  if (server_budget)
+    ASSERT(0 == uv_loop_configure(&loop,
+                                  UV_LOOP_HANDLE_IO_BUDGET,
+                                  1,
+                                  (size_t) FLOOD_SIZE));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(&loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, server_connection_cb));
+  ASSERT(0 == uv_async_init(&loop, &server_done, server_done_cb));
+
+  uv_sem_post(&server_ready);
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+}
+
+
+static void flood_write(uv_write_t* req);
+
+
+static void flood_write_cb(uv_write_t* req, int status) {
+  if (stopping)
+    return;
+
+  ASSERT(status == 0);
+  flood_write(req);
+}
+
+
+static void flood_write(uv_write_t* req) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init(flood_data, sizeof(flood_data));
+  ASSERT(0 == uv_write(req,
+                       (uv_stream_t*) &flood_client,
+                       &buf,
+                       1,
+                       flood_write_cb));
+}
+
+
+static void ping_send(void) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init(PING, sizeof(PING) - 1);
+  ping_nread = 0;
+  ping_start = uv_hrtime();
+  ASSERT(0 == uv_write(&ping_write_req,
+                       (uv_stream_t*) &ping_client,
+                       &buf,
+                       1,
+                       NULL));
+}
+
+
+static void ping_alloc_cb(uv_handle_t* handle,
+                          size_t suggested_size,
+                          uv_buf_t* buf) {
+  buf->base = ping_buf + ping_nread;
+  buf->len = sizeof(PING) - 1 - ping_nread;
+}
+
+
+static void ping_read_cb(uv_stream_t* stream,
+                         ssize_t nread,
+                         const uv_buf_t* buf) {
+  ASSERT(nread >= 0);
+
+  ping_nread += nread;
+  if (ping_nread < sizeof(PING) - 1)
+    return;
+
+  ASSERT(0 == memcmp(ping_buf, PING, sizeof(PING) - 1));
+  latencies[pings++] = uv_hrtime() - ping_start;
+
+  if (pings < NUM_PINGS) {
+    ping_send();
+    return;
+  }
+
+  stopping = 1;
+  uv_close((uv_handle_t*) &ping_client, NULL);
+  uv_close((uv_handle_t*) &flood_client, NULL);
+  ASSERT(0 == uv_async_send(&server_done));
+}
+
+
+static void ping_connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_nodelay(&ping_client, 1));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &ping_client,
+                            ping_alloc_cb,
+                            ping_read_cb));
+  ping_send();
+}
+
+
+static void flood_connect_cb(uv_connect_t* req, int status) {
+  struct sockaddr_in addr;
+  int i;
+
+  ASSERT(status == 0);
+
+  for (i = 0; i < FLOOD_WRITES; i++)
+    flood_write(&flood_write_reqs[i]);
+
+  /* Start the ping-pong once the server is busy. */
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(req->handle->loop, &ping_client));
+  ASSERT(0 == uv_tcp_connect(&ping_connect_req,
+                             &ping_client,
+                             (const struct sockaddr*) &addr,
+                             ping_connect_cb));
+}
+
+
+static int compare_latencies(const void* a, const void* b) {
+  uint64_t x;
+  uint64_t y;
+
+  x = *(const uint64_t*) a;
+  y = *(const uint64_t*) b;
+
+  return x < y ? -1 : x > y;
+}
+
+
+static int loop_fairness(const char* name, int budget) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+
+  server_budget = budget;
+  memset(flood_data, 'x', sizeof(flood_data));
+
+  ASSERT(0 == uv_sem_init(&server_ready, 0));
+  ASSERT(0 == uv_thread_create(&server_tid, server_thread, NULL));
+  uv_sem_wait(&server_ready);
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &flood_client));
+  ASSERT(0 == uv_tcp_connect(&flood_connect_req,
+                             &flood_client,
+                             (const struct sockaddr*) &addr,
+                             flood_connect_cb));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_thread_join(&server_tid));
+  uv_sem_destroy(&server_ready);
+
+  ASSERT(pings == NUM_PINGS);
+  qsort(latencies, NUM_PINGS, sizeof(latencies[0]), compare_latencies);
+
+  fprintf(stderr,
+          "%s: ping-pong p50 %.1f us, p99 %.1f us, max %.1f us\n",
+          name,
+          latencies[NUM_PINGS / 2] / 1e3,
+          latencies[NUM_PINGS * 99 / 100] / 1e3,
+          latencies[NUM_PINGS - 1] / 1e3);
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(loop_fairness) {
+  return loop_fairness("loop_fairness", 0);
+}
+
+
+BENCHMARK_IMPL(loop_fairness_budget) {
+  return loop_fairness("loop_fairness_budget", 1);
+}
@@ -67,6 +67,8 @@ struct ipc_client_ctx {
 struct server_ctx {
   handle_storage_t server_handle;
   unsigned int num_connects;
+  unsigned int num_wakeups;
+  uv_check_t check_handle;
   uv_async_t async_handle;
   uv_thread_t thread_id;
   uv_sem_t semaphore;
@@ -79,6 +81,16 @@ struct client_ctx {
   uv_idle_t idle_handle;
 };
 
+/* With an accept group, one thread accepts and hands the connections to the
+ * worker threads in-process instead of them sharing the listen socket.
+ */
+struct acceptor_ctx {
+  uv_tcp_t server_handle;
+  uv_async_t async_handle;
+  uv_thread_t thread_id;
+  uv_sem_t semaphore;
+};
+
 static void ipc_connection_cb(uv_stream_t* ipc_pipe, int status);
 static void ipc_write_cb(uv_write_t* req, int status);
 static void ipc_close_cb(uv_handle_t* handle);
@@ -91,6 +103,7 @@ static void ipc_alloc_cb(uv_handle_t* handle,
                          uv_buf_t* buf);
 
 static void sv_async_cb(uv_async_t* handle);
+static void sv_check_cb(uv_check_t* handle);
 static void sv_connection_cb(uv_stream_t* server_handle, int status);
 static void sv_read_cb(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf);
 static void sv_alloc_cb(uv_handle_t* handle,
@@ -102,6 +115,13 @@ static void cl_idle_cb(uv_idle_t* handle);
 static void cl_close_cb(uv_handle_t* handle);
 
 static struct sockaddr_in listen_addr;
+static uv_accept_group_t accept_group;
+static enum {
+  ACCEPT_SHARED,     /* The workers share one listen socket. */
+  ACCEPT_EXCLUSIVE,  /* Same but only one worker wakes up per connection. */
+  ACCEPT_GROUP,      /* One acceptor hands the connections to the workers. */
+  ACCEPT_REUSEPORT   /* Each worker listens on its own SO_REUSEPORT socket. */
+} accept_mode;
 
 
 static void ipc_connection_cb(uv_stream_t* ipc_pipe, int status) {
@@ -260,29 +280,93 @@ static void server_cb(void *arg) {
   ASSERT(0 == uv_async_init(&loop, &ctx->async_handle, sv_async_cb));
   uv_unref((uv_handle_t*) &ctx->async_handle);
 
+  /* Every loop iteration past the first is a wakeup. */
+  ASSERT(0 == uv_check_init(&loop, &ctx->check_handle));
+  uv_unref((uv_handle_t*) &ctx->check_handle);
+
+  if (accept_mode == ACCEPT_GROUP || accept_mode == ACCEPT_REUSEPORT) {
+    ASSERT(0 == uv_tcp_init(&loop, (uv_tcp_t*) &ctx->server_handle));
+    if (accept_mode == ACCEPT_GROUP) {
+      ASSERT(0 == uv_accept_group_join(&accept_group,
+                                       (uv_tcp_t*) &ctx->server_handle,
+                                       sv_connection_cb));
+    } else {
+      ASSERT(0 == uv_tcp_bind((uv_tcp_t*) &ctx->server_handle,
+                              (const struct sockaddr*) &listen_addr,
+                              UV_TCP_REUSEPORT));
+      ASSERT(0 == uv_listen((uv_stream_t*) &ctx->server_handle,
+                            128,
+                            sv_connection_cb));
+    }
+    uv_sem_post(&ctx->semaphore);
+    ASSERT(0 == uv_check_start(&ctx->check_handle, sv_check_cb));
+    ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+    uv_loop_close(&loop);
+    return;
+  }
+
   /* Wait until the main thread is ready. */
   uv_sem_wait(&ctx->semaphore);
   get_listen_handle(&loop, (uv_stream_t*) &ctx->server_handle);
   uv_sem_post(&ctx->semaphore);
 
   /* Now start the actual benchmark. */
+  if (accept_mode == ACCEPT_EXCLUSIVE)
+    ASSERT(0 == uv_tcp_simultaneous_accepts((uv_tcp_t*) &ctx->server_handle,
+                                            0));
   ASSERT(0 == uv_listen((uv_stream_t*) &ctx->server_handle,
                         128,
                         sv_connection_cb));
+  ASSERT(0 == uv_check_start(&ctx->check_handle, sv_check_cb));
   ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
 
   uv_loop_close(&loop);
 }
 
 
+static void acceptor_async_cb(uv_async_t* handle) {
+  struct acceptor_ctx* ctx;
+  ctx = container_of(handle, struct acceptor_ctx, async_handle);
+  uv_close((uv_handle_t*) &ctx->server_handle, NULL);
+  uv_close((uv_handle_t*) &ctx->async_handle, NULL);
+}
+
+
+static void acceptor_cb(void* arg) {
+  struct acceptor_ctx* ctx;
+  uv_loop_t loop;
+
+  ctx = arg;
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_async_init(&loop, &ctx->async_handle, acceptor_async_cb));
+  ASSERT(0 == uv_tcp_init(&loop, &ctx->server_handle));
+  ASSERT(0 == uv_tcp_bind(&ctx->server_handle,
+                          (const struct sockaddr*) &listen_addr,
+                          0));
+  ASSERT(0 == uv_accept_group_listen(&accept_group, &ctx->server_handle, 128));
+  uv_sem_post(&ctx->semaphore);
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  uv_loop_close(&loop);
+}
+
+
 static void sv_async_cb(uv_async_t* handle) {
   struct server_ctx* ctx;
   ctx = container_of(handle, struct server_ctx, async_handle);
   uv_close((uv_handle_t*) &ctx->server_handle, NULL);
+  uv_close((uv_handle_t*) &ctx->check_handle, NULL);
   uv_close((uv_handle_t*) &ctx->async_handle, NULL);
 }
 
 
+static void sv_check_cb(uv_check_t* handle) {
+  struct server_ctx* ctx;
+  ctx = container_of(handle, struct server_ctx, check_handle);
+  ctx->num_wakeups++;
+}
+
+
 static void sv_connection_cb(uv_stream_t* server_handle, int status) {
   handle_storage_t* storage;
   struct server_ctx* ctx;
@@ -355,7 +439,10 @@ static void cl_close_cb(uv_handle_t* handle) {
 }
 
 
-static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
+static int test_tcp(unsigned int num_servers,
+                    unsigned int num_clients,
+                    int mode) {
+  struct acceptor_ctx acceptor;
   struct server_ctx* servers;
   struct client_ctx* clients;
   uv_loop_t* loop;
@@ -365,6 +452,9 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
 
   ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &listen_addr));
   loop = uv_default_loop();
+  accept_mode = mode;
+  if (accept_mode == ACCEPT_GROUP)
+    ASSERT(0 == uv_accept_group_init(&accept_group, 0));
 
   servers = calloc(num_servers, sizeof(servers[0]));
   clients = calloc(num_clients, sizeof(clients[0]));
@@ -381,7 +471,18 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
     ASSERT(0 == uv_thread_create(&ctx->thread_id, server_cb, ctx));
   }
 
-  send_listen_handles(UV_TCP, num_servers, servers);
+  if (accept_mode == ACCEPT_SHARED || accept_mode == ACCEPT_EXCLUSIVE) {
+    send_listen_handles(UV_TCP, num_servers, servers);
+  } else {
+    for (i = 0; i < num_servers; i++)
+      uv_sem_wait(&servers[i].semaphore);
+  }
+
+  if (accept_mode == ACCEPT_GROUP) {
+    ASSERT(0 == uv_sem_init(&acceptor.semaphore, 0));
+    ASSERT(0 == uv_thread_create(&acceptor.thread_id, acceptor_cb, &acceptor));
+    uv_sem_wait(&acceptor.semaphore);
+  }
 
   for (i = 0; i < num_clients; i++) {
     struct client_ctx* ctx = clients + i;
@@ -403,6 +504,12 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
     time = t / 1e9;
   }
 
+  if (accept_mode == ACCEPT_GROUP) {
+    uv_async_send(&acceptor.async_handle);
+    ASSERT(0 == uv_thread_join(&acceptor.thread_id));
+    uv_sem_destroy(&acceptor.semaphore);
+  }
+
   for (i = 0; i < num_servers; i++) {
     struct server_ctx* ctx = servers + i;
     uv_async_send(&ctx->async_handle);
@@ -410,18 +517,27 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
     uv_sem_destroy(&ctx->semaphore);
   }
 
-  printf("accept%u: %.0f accepts/sec (%u total)\n",
+  if (accept_mode == ACCEPT_GROUP)
+    uv_accept_group_destroy(&accept_group);
+
+  printf("accept%u%s: %.0f accepts/sec (%u total)\n",
          num_servers,
+         accept_mode == ACCEPT_EXCLUSIVE ? "_exclusive" :
+         accept_mode == ACCEPT_GROUP ? "_group" :
+         accept_mode == ACCEPT_REUSEPORT ? "_reuseport" : "",
          NUM_CONNECTS / time,
          NUM_CONNECTS);
 
   for (i = 0; i < num_servers; i++) {
     struct server_ctx* ctx = servers + i;
-    printf("  thread #%u: %.0f accepts/sec (%u total, %.1f%%)\n",
+    printf("  thread #%u: %.0f accepts/sec (%u total, %.1f%%, "
+           "%.2f wakeups/accept)\n",
            i,
            ctx->num_connects / time,
            ctx->num_connects,
-           ctx->num_connects * 100.0 / NUM_CONNECTS);
+           ctx->num_connects * 100.0 / NUM_CONNECTS,
+           ctx->num_connects ? (double) ctx->num_wakeups / ctx->num_connects
+                             : 0.0);
   }
 
   free(clients);
@@ -433,15 +549,60 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
 
 
 BENCHMARK_IMPL(tcp_multi_accept2) {
-  return test_tcp(2, 40);
+  return test_tcp(2, 40, ACCEPT_SHARED);
 }
 
 
 BENCHMARK_IMPL(tcp_multi_accept4) {
-  return test_tcp(4, 40);
+  return test_tcp(4, 40, ACCEPT_SHARED);
 }
 
 
 BENCHMARK_IMPL(tcp_multi_accept8) {
-  return test_tcp(8, 40);
+  return test_tcp(8, 40, ACCEPT_SHARED);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept2_exclusive) {
+  return test_tcp(2, 40, ACCEPT_EXCLUSIVE);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept4_exclusive) {
+  return test_tcp(4, 40, ACCEPT_EXCLUSIVE);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept8_exclusive) {
+  return test_tcp(8, 40, ACCEPT_EXCLUSIVE);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept2_group) {
+  return test_tcp(2, 40, ACCEPT_GROUP);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept4_group) {
+  return test_tcp(4, 40, ACCEPT_GROUP);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept8_group) {
+  return test_tcp(8, 40, ACCEPT_GROUP);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept2_reuseport) {
+  return test_tcp(2, 40, ACCEPT_REUSEPORT);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept4_reuseport) {
+  return test_tcp(4, 40, ACCEPT_REUSEPORT);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept8_reuseport) {
+  return test_tcp(8, 40, ACCEPT_REUSEPORT);
 }
@@ -51,20 +51,32 @@ static buf_t* buf_freelist = NULL;
 static int pinger_shutdown_cb_called;
 static int completed_pingers = 0;
 static int64_t start_time;
+static unsigned int read_size_flags;
+static int64_t nreads;
+static int64_t nread_total;
+static int64_t nalloc_total;
 
 
 static void buf_alloc(uv_handle_t* tcp, size_t size, uv_buf_t* buf) {
   buf_t* ab;
 
   ab = buf_freelist;
-  if (ab != NULL)
+  if (ab != NULL) {
     buf_freelist = ab->next;
-  else {
+    /* The suggested size changes in adaptive mode, don't hand out stale sizes. */
+    if (ab->uv_buf_t.len != size) {
+      free(ab);
+      ab = NULL;
+    }
+  }
+
+  if (ab == NULL) {
     ab = malloc(size + sizeof(*ab));
     ab->uv_buf_t.len = size;
     ab->uv_buf_t.base = (char*) (ab + 1);
   }
 
+  nalloc_total += size;
   *buf = ab->uv_buf_t;
 }
 
@@ -80,7 +92,13 @@ static void pinger_close_cb(uv_handle_t* handle) {
   pinger_t* pinger;
 
   pinger = (pinger_t*)handle->data;
-  fprintf(stderr, "ping_pongs: %d roundtrips/s\n", (1000 * pinger->pongs) / TIME);
+  fprintf(stderr, "ping_pongs%s: %d roundtrips/s\n",
+          read_size_flags ? "_adaptive" : "",
+          (1000 * pinger->pongs) / TIME);
+  fprintf(stderr, "ping_pongs%s: %.1f reads/MB, %.1f kB buffer/read\n",
+          read_size_flags ? "_adaptive" : "",
+          nreads / ((double) nread_total / (1024 * 1024)),
+          (double) nalloc_total / 1024 / (nreads ? nreads : 1));
   fflush(stderr);
 
   free(pinger);
@@ -142,6 +160,9 @@ static void pinger_read_cb(uv_stream_t* tcp,
     return;
   }
 
+  nreads++;
+  nread_total += nread;
+
   /* Now we count the pings */
   for (i = 0; i < nread; i++) {
     ASSERT(buf->base[i] == PING[pinger->state]);
@@ -170,6 +191,10 @@ static void pinger_connect_cb(uv_connect_t* req, int status) {
 
   pinger_write_ping(pinger);
 
+  if (uv_read_size_mode((uv_handle_t*) req->handle, read_size_flags)) {
+    FATAL("uv_read_size_mode failed");
+  }
+
   if (uv_read_start(req->handle, buf_alloc, pinger_read_cb)) {
     FATAL("uv_read_start failed");
   }
@@ -206,8 +231,9 @@ static void pinger_new(void) {
 }
 
 
-BENCHMARK_IMPL(ping_pongs) {
+static int ping_pongs(unsigned int flags) {
   loop = uv_default_loop();
+  read_size_flags = flags;
 
   start_time = uv_now(loop);
 
@@ -219,3 +245,13 @@ BENCHMARK_IMPL(ping_pongs) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+BENCHMARK_IMPL(ping_pongs) {
+  return ping_pongs(0);
+}
+
+
+BENCHMARK_IMPL(ping_pongs_adaptive) {
+  return ping_pongs(UV_READ_SIZE_ADAPTIVE | UV_READ_SIZE_FIONREAD);
+}
@@ -64,6 +64,11 @@ static int64_t nrecv_total = 0;
 static int64_t nsent = 0;
 static int64_t nsent_total = 0;
 
+/* Server side read accounting, see uv_read_size_mode(). */
+static unsigned int read_size_flags = 0;
+static int64_t nreads = 0;
+static int64_t nalloc_total = 0;
+
 static int stats_left = 0;
 
 static char write_buffer[WRITE_BUFFER_SIZE];
@@ -130,10 +135,17 @@ static void read_show_stats(void) {
   uv_update_time(loop);
   diff = uv_now(loop) - start_time;
 
-  fprintf(stderr, "%s_pump%d_server: %.1f gbit/s\n",
+  fprintf(stderr, "%s_pump%d_server%s: %.1f gbit/s\n",
           type == TCP ? "tcp" : "pipe",
           max_read_sockets,
+          read_size_flags ? "_adaptive" : "",
           gbit(nrecv_total, diff));
+  fprintf(stderr, "%s_pump%d_server%s: %.1f reads/MB, %.1f kB buffer/read\n",
+          type == TCP ? "tcp" : "pipe",
+          max_read_sockets,
+          read_size_flags ? "_adaptive" : "",
+          nreads / ((double) nrecv_total / (1024 * 1024)),
+          (double) nalloc_total / 1024 / (nreads ? nreads : 1));
   fflush(stderr);
 }
 
@@ -182,6 +194,9 @@ static void read_cb(uv_stream_t* stream, ssize_t bytes, const uv_buf_t* buf) {
 
   buf_free(buf);
 
+  if (bytes > 0)
+    nreads++;
+
   nrecv += bytes;
   nrecv_total += bytes;
 }
@@ -294,6 +309,9 @@ static void connection_cb(uv_stream_t* s, int status) {
   r = uv_accept(s, stream);
   ASSERT(r == 0);
 
+  r = uv_read_size_mode((uv_handle_t*) stream, read_size_flags);
+  ASSERT(r == 0);
+
   r = uv_read_start(stream, buf_alloc, read_cb);
   ASSERT(r == 0);
 
@@ -354,14 +372,22 @@ static void buf_alloc(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
   buf_list_t* ab;
 
   ab = buf_freelist;
-  if (ab != NULL)
+  if (ab != NULL) {
     buf_freelist = ab->next;
-  else {
+    /* The suggested size changes in adaptive mode, don't hand out stale sizes. */
+    if (ab->uv_buf_t.len != size) {
+      free(ab);
+      ab = NULL;
+    }
+  }
+
+  if (ab == NULL) {
     ab = malloc(size + sizeof(*ab));
     ab->uv_buf_t.len = size;
     ab->uv_buf_t.base = (char*) (ab + 1);
   }
 
+  nalloc_total += size;
   *buf = ab->uv_buf_t;
 }
 
@@ -373,10 +399,11 @@ static void buf_free(const uv_buf_t* buf) {
 }
 
 
-HELPER_IMPL(tcp_pump_server) {
+static int tcp_pump_server(unsigned int flags) {
   int r;
 
   type = TCP;
+  read_size_flags = flags;
   loop = uv_default_loop();
 
   ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &listen_addr));
@@ -396,6 +423,16 @@ HELPER_IMPL(tcp_pump_server) {
 }
 
 
+HELPER_IMPL(tcp_pump_server) {
+  return tcp_pump_server(0);
+}
+
+
+HELPER_IMPL(tcp_pump_adaptive_server) {
+  return tcp_pump_server(UV_READ_SIZE_ADAPTIVE | UV_READ_SIZE_FIONREAD);
+}
+
+
 HELPER_IMPL(pipe_pump_server) {
   int r;
   type = PIPE;
@@ -464,6 +501,18 @@ BENCHMARK_IMPL(tcp_pump1_client) {
 }
 
 
+BENCHMARK_IMPL(tcp_pump100_adaptive_client) {
+  tcp_pump(100);
+  return 0;
+}
+
+
+BENCHMARK_IMPL(tcp_pump1_adaptive_client) {
+  tcp_pump(1);
+  return 0;
+}
+
+
 BENCHMARK_IMPL(pipe_pump100_client) {
   pipe_pump(100);
   return 0;
@@ -0,0 +1,189 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+#endif
+
+/* NUM_STREAMS connections with an inactivity timeout, of which NUM_PAIRS
+ * pairs ping-pong a byte back and forth while the rest stay idle. Either
+ * every stream has its own timer that is restarted with uv_timer_again() on
+ * each read and write, or the streams use uv_stream_set_idle_timeout().
+ * Reports the round trips per second of the active pairs.
+ *
+ * File descriptor limits put 100k sockets out of reach, so the idle
+ * connections are TCP handles without a socket. Their timers or idle timeouts
+ * cost the same as those of connected handles.
+ */
+
+#define NUM_STREAMS   100000
+#define NUM_PAIRS     1000
+#define NUM_IDLE      (NUM_STREAMS - 2 * NUM_PAIRS)
+#define TIMEOUT       60000  /* ms */
+#define DURATION      2000   /* ms */
+
+static uv_pipe_t pipes[2 * NUM_PAIRS];
+static uv_tcp_t idle[NUM_IDLE];
+static uv_timer_t timers[NUM_STREAMS];
+static uv_timer_t duration_timer;
+static char slab[64];
+static char byte = 'x';
+static uint64_t round_trips;
+static int use_timers;
+static int stopping;
+
+
+static void timeout_cb(uv_stream_t* handle) {
+  ASSERT(0 && "should not have timed out");
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  ASSERT(0 && "should not have timed out");
+}
+
+
+static void activity(uv_stream_t* stream) {
+  if (use_timers)
+    ASSERT(0 == uv_timer_again(stream->data));
+}
+
+
+static void ping(uv_stream_t* stream) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init(&byte, 1);
+  ASSERT(1 == uv_try_write(stream, &buf, 1));
+  activity(stream);
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (stopping || nread == 0)
+    return;
+
+  ASSERT(nread == 1);
+  activity(stream);
+
+  /* Even pipes started the exchange, they count the round trips. */
+  if ((uv_pipe_t*) stream < pipes + NUM_PAIRS)
+    round_trips++;
+
+  ping(stream);
+}
+
+
+static void duration_cb(uv_timer_t* handle) {
+  stopping = 1;
+  uv_walk(handle->loop, close_walk_cb, NULL);
+}
+
+
+static void watch(uv_loop_t* loop, uv_stream_t* stream, uv_timer_t* timer) {
+  if (use_timers) {
+    stream->data = timer;
+    ASSERT(0 == uv_timer_init(loop, timer));
+    ASSERT(0 == uv_timer_start(timer, timer_cb, TIMEOUT, TIMEOUT));
+  } else {
+    ASSERT(0 == uv_stream_set_idle_timeout(stream, TIMEOUT, timeout_cb));
+  }
+}
+
+
+static int stream_idle_timeout(const char* name, int with_timers) {
+#ifdef _WIN32
+  RETURN_SKIP("Benchmark not implemented on Windows.");
+#else
+  uv_loop_t* loop;
+  uint64_t start;
+  double elapsed;
+  int fds[2];
+  int i;
+
+  loop = uv_default_loop();
+  use_timers = with_timers;
+
+  start = uv_hrtime();
+  for (i = 0; i < NUM_PAIRS; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT(0 == uv_pipe_init(loop, &pipes[i], 0));
+    ASSERT(0 == uv_pipe_init(loop, &pipes[NUM_PAIRS + i], 0));
+    ASSERT(0 == uv_pipe_open(&pipes[i], fds[0]));
+    ASSERT(0 == uv_pipe_open(&pipes[NUM_PAIRS + i], fds[1]));
+  }
+
+  for (i = 0; i < 2 * NUM_PAIRS; i++) {
+    watch(loop, (uv_stream_t*) &pipes[i], &timers[i]);
+    ASSERT(0 == uv_read_start((uv_stream_t*) &pipes[i], alloc_cb, read_cb));
+  }
+
+  for (i = 0; i < NUM_IDLE; i++) {
+    ASSERT(0 == uv_tcp_init(loop, &idle[i]));
+    watch(loop, (uv_stream_t*) &idle[i], &timers[2 * NUM_PAIRS + i]);
+  }
+
+  fprintf(stderr,
+          "%s: %d streams set up in %.1f ms\n",
+          name,
+          NUM_STREAMS,
+          (uv_hrtime() - start) / 1e6);
+
+  ASSERT(0 == uv_timer_init(loop, &duration_timer));
+  ASSERT(0 == uv_timer_start(&duration_timer, duration_cb, DURATION, 0));
+
+  start = uv_hrtime();
+  for (i = 0; i < NUM_PAIRS; i++)
+    ping((uv_stream_t*) &pipes[i]);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  elapsed = (uv_hrtime() - start) / 1e9;
+
+  fprintf(stderr,
+          "%s: %.0f round trips/s\n",
+          name,
+          round_trips / elapsed);
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+BENCHMARK_IMPL(stream_idle_timeout_timers) {
+  return stream_idle_timeout("stream_idle_timeout_timers", 1);
+}
+
+
+BENCHMARK_IMPL(stream_idle_timeout) {
+  return stream_idle_timeout("stream_idle_timeout", 0);
+}
@@ -0,0 +1,268 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+#endif
+
+/* Many streams on one loop, each limited to RATE bytes per second and kept
+ * busy with more data than that. Reports the aggregate throughput and how
+ * evenly it is shared by the streams: the lowest and highest per stream rate
+ * and Jain's fairness index, 1.0 when all streams get the same.
+ */
+
+#define NUM_STREAMS   32
+#define RATE          (2 * 1024 * 1024)  /* bytes per second and stream */
+#define CHUNK_SIZE    (64 * 1024)
+#define WARMUP        500                /* ms */
+#define DURATION      2000               /* ms */
+
+typedef union {
+  uv_tcp_t tcp;
+  uv_pipe_t pipe;
+  uv_stream_t stream;
+} stream_handle_t;
+
+typedef struct {
+  stream_handle_t writer;
+  stream_handle_t reader;
+  uv_write_t reqs[2];
+  uint64_t nread;
+  uint64_t mark;
+} conn_t;
+
+static conn_t conns[NUM_STREAMS];
+static uv_tcp_t server;
+static uv_connect_t connect_reqs[NUM_STREAMS];
+static uv_timer_t timer;
+static char chunk[CHUNK_SIZE];
+static char slab[CHUNK_SIZE];
+static int accepted;
+static int measuring;
+static int stopping;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  conn_t* conn;
+
+  if (nread < 0)
+    return;
+
+  conn = stream->data;
+  conn->nread += nread;
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  uv_buf_t buf;
+
+  if (stopping)
+    return;
+
+  ASSERT(status == 0);
+  buf = uv_buf_init(chunk, sizeof(chunk));
+  ASSERT(0 == uv_write(req, req->handle, &buf, 1, write_cb));
+}
+
+
+static void start_writing(conn_t* conn) {
+  uv_buf_t buf;
+  int i;
+
+  ASSERT(0 == uv_stream_set_rate_limit(&conn->writer.stream, RATE, 0));
+
+  /* Two chunks in flight keep the stream busy. */
+  buf = uv_buf_init(chunk, sizeof(chunk));
+  for (i = 0; i < 2; i++)
+    ASSERT(0 == uv_write(&conn->reqs[i],
+                         &conn->writer.stream,
+                         &buf,
+                         1,
+                         write_cb));
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  int i;
+
+  if (!measuring) {
+    for (i = 0; i < NUM_STREAMS; i++)
+      conns[i].mark = conns[i].nread;
+    measuring = 1;
+    ASSERT(0 == uv_timer_start(&timer, timer_cb, DURATION, 0));
+    return;
+  }
+
+  stopping = 1;
+  uv_close((uv_handle_t*) &timer, NULL);
+  for (i = 0; i < NUM_STREAMS; i++) {
+    conns[i].mark = conns[i].nread - conns[i].mark;
+    uv_close((uv_handle_t*) &conns[i].writer, NULL);
+    uv_close((uv_handle_t*) &conns[i].reader, NULL);
+  }
+}
+
+
+static void report(const char* name) {
+  double total;
+  double squares;
+  double rate;
+  double lo;
+  double hi;
+  int i;
+
+  total = 0;
+  squares = 0;
+  lo = 0;
+  hi = 0;
+
+  for (i = 0; i < NUM_STREAMS; i++) {
+    rate = conns[i].mark * 1000.0 / DURATION;
+    total += rate;
+    squares += rate * rate;
+    if (i == 0 || rate < lo)
+      lo = rate;
+    if (i == 0 || rate > hi)
+      hi = rate;
+  }
+
+  fprintf(stderr,
+          "%s: %d streams at %.1f MB/s: %.1f MB/s total, "
+          "%.2f-%.2f MB/s per stream, fairness %.3f\n",
+          name,
+          NUM_STREAMS,
+          RATE / (1024.0 * 1024),
+          total / (1024 * 1024),
+          lo / (1024 * 1024),
+          hi / (1024 * 1024),
+          total * total / (NUM_STREAMS * squares));
+  fflush(stderr);
+}
+
+
+static void start_timer(uv_loop_t* loop) {
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb, WARMUP, 0));
+}
+
+
+BENCHMARK_IMPL(stream_rate_limit_pipe) {
+#ifdef _WIN32
+  RETURN_SKIP("Benchmark not implemented on Windows.");
+#else
+  uv_loop_t* loop;
+  conn_t* conn;
+  int fds[2];
+  int i;
+
+  loop = uv_default_loop();
+
+  /* Pipes can't be paced by the kernel, this measures the token bucket. */
+  for (i = 0; i < NUM_STREAMS; i++) {
+    conn = &conns[i];
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT(0 == uv_pipe_init(loop, &conn->writer.pipe, 0));
+    ASSERT(0 == uv_pipe_init(loop, &conn->reader.pipe, 0));
+    ASSERT(0 == uv_pipe_open(&conn->writer.pipe, fds[0]));
+    ASSERT(0 == uv_pipe_open(&conn->reader.pipe, fds[1]));
+    conn->reader.stream.data = conn;
+    ASSERT(0 == uv_read_start(&conn->reader.stream, alloc_cb, read_cb));
+    start_writing(conn);
+  }
+
+  start_timer(loop);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  report("stream_rate_limit_pipe");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+static void connection_cb(uv_stream_t* stream, int status) {
+  conn_t* conn;
+
+  ASSERT(status == 0);
+  ASSERT(accepted < NUM_STREAMS);
+
+  conn = &conns[accepted++];
+  ASSERT(0 == uv_tcp_init(stream->loop, &conn->reader.tcp));
+  ASSERT(0 == uv_accept(stream, &conn->reader.stream));
+  conn->reader.stream.data = conn;
+  ASSERT(0 == uv_read_start(&conn->reader.stream, alloc_cb, read_cb));
+
+  if (accepted == NUM_STREAMS) {
+    uv_close((uv_handle_t*) stream, NULL);
+    start_timer(stream->loop);
+  }
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  start_writing(req->handle->data);
+}
+
+
+BENCHMARK_IMPL(stream_rate_limit_tcp) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  /* Paced by the kernel where it supports it. The streams that get counted
+   * together are the two ends of different connections, which doesn't
+   * matter for the totals.
+   */
+  for (i = 0; i < NUM_STREAMS; i++) {
+    ASSERT(0 == uv_tcp_init(loop, &conns[i].writer.tcp));
+    conns[i].writer.stream.data = &conns[i];
+    ASSERT(0 == uv_tcp_connect(&connect_reqs[i],
+                               &conns[i].writer.tcp,
+                               (const struct sockaddr*) &addr,
+                               connect_cb));
+  }
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  report("stream_rate_limit_tcp");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,270 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+#endif
+
+/* Opens one short-lived connection after another and sends a request from the
+ * connect callback. Reports the time from uv_tcp_connect() to the first byte
+ * of the reply.
+ */
+
+#define NUM_CONNECTS  2000
+#define REQUEST       "GET"
+
+static uv_thread_t server_tid;
+static uv_sem_t server_ready;
+static uv_async_t server_done;
+static uv_tcp_t server;
+static int fastopen;
+
+static uv_tcp_t client;
+static uv_connect_t connect_req;
+static uv_write_t write_req;
+static char server_buf[64];
+static char client_buf[64];
+
+static uint64_t latencies[NUM_CONNECTS];
+static uint64_t connect_start;
+static int syn_data;
+static int connects;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  if (handle == (uv_handle_t*) &client)
+    buf->base = client_buf;
+  else
+    buf->base = server_buf;
+  buf->len = sizeof(server_buf);
+}
+
+
+static void server_close_cb(uv_handle_t* handle) {
+  free(handle);
+}
+
+
+static void server_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  uv_buf_t reply;
+
+  if (nread < 0) {
+    uv_close((uv_handle_t*) stream, server_close_cb);
+    return;
+  }
+
+  if (nread == 0)
+    return;
+
+  reply = uv_buf_init(buf->base, nread);
+  ASSERT(nread == uv_try_write(stream, &reply, 1));
+}
+
+
+static void server_connection_cb(uv_stream_t* stream, int status) {
+  uv_tcp_t* conn;
+
+  ASSERT(status == 0);
+
+  conn = malloc(sizeof(*conn));
+  ASSERT(conn != NULL);
+  ASSERT(0 == uv_tcp_init(stream->loop, conn));
+  ASSERT(0 == uv_accept(stream, (uv_stream_t*) conn));
+  ASSERT(0 == uv_read_start((uv_stream_t*) conn,
+                            alloc_cb,
+                            server_read_cb));
+}
+
+
+static void server_done_cb(uv_async_t* handle) {
+  uv_close((uv_handle_t*) &server, NULL);
+  uv_close((uv_handle_t*) &server_done, NULL);
+}
+
+
+static void server_thread(void* arg) {
+  struct sockaddr_in addr;
+  uv_loop_t loop;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(&loop, &server));
+  if (fastopen)
+    ASSERT(0 == uv_tcp_fastopen(&server, 1, 0));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, server_connection_cb));
+  ASSERT(0 == uv_async_init(&loop, &server_done, server_done_cb));
+
+  uv_sem_post(&server_ready);
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+}
+
+
+static void client_connect(uv_loop_t* loop);
+
+
+static void client_close_cb(uv_handle_t* handle) {
+  if (connects < NUM_CONNECTS)
+    client_connect(handle->loop);
+  else
+    ASSERT(0 == uv_async_send(&server_done));
+}
+
+
+/* Counts the connections whose SYN carried the request. */
+static void client_check_syn_data(void) {
+#if defined(__linux__) && defined(TCPI_OPT_SYN_DATA)
+  struct tcp_info info;
+  socklen_t len;
+  uv_os_fd_t fd;
+
+  len = sizeof(info);
+  ASSERT(0 == uv_fileno((uv_handle_t*) &client, &fd));
+  ASSERT(0 == getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len));
+  if (info.tcpi_options & TCPI_OPT_SYN_DATA)
+    syn_data++;
+#endif
+}
+
+
+static void client_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread > 0);
+  latencies[connects++] = uv_hrtime() - connect_start;
+  client_check_syn_data();
+  uv_close((uv_handle_t*) stream, client_close_cb);
+}
+
+
+static void client_connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+
+  buf = uv_buf_init(REQUEST, sizeof(REQUEST) - 1);
+  ASSERT(0 == uv_write(&write_req, req->handle, &buf, 1, NULL));
+  ASSERT(0 == uv_read_start(req->handle, alloc_cb, client_read_cb));
+}
+
+
+static void client_connect(uv_loop_t* loop) {
+  struct sockaddr_in addr;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &client));
+  ASSERT(0 == uv_tcp_nodelay(&client, 1));
+  if (fastopen)
+    ASSERT(0 == uv_tcp_fastopen(&client, 1, 0));
+
+  connect_start = uv_hrtime();
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             client_connect_cb));
+}
+
+
+static int compare_latencies(const void* a, const void* b) {
+  uint64_t x;
+  uint64_t y;
+
+  x = *(const uint64_t*) a;
+  y = *(const uint64_t*) b;
+
+  return x < y ? -1 : x > y;
+}
+
+
+static int tcp_connect_first_byte(const char* name, int use_fastopen) {
+  uv_loop_t* loop;
+  uv_tcp_t probe;
+
+  loop = uv_default_loop();
+
+  if (use_fastopen) {
+    ASSERT(0 == uv_tcp_init(loop, &probe));
+    if (uv_tcp_fastopen(&probe, 1, 0) == UV_ENOTSUP) {
+      uv_close((uv_handle_t*) &probe, NULL);
+      uv_run(loop, UV_RUN_DEFAULT);
+      fprintf(stderr, "%s: TCP Fast Open is not supported\n", name);
+      fflush(stderr);
+      MAKE_VALGRIND_HAPPY();
+      return 0;
+    }
+    uv_close((uv_handle_t*) &probe, NULL);
+  }
+
+  fastopen = use_fastopen;
+  ASSERT(0 == uv_sem_init(&server_ready, 0));
+  ASSERT(0 == uv_thread_create(&server_tid, server_thread, NULL));
+  uv_sem_wait(&server_ready);
+
+  client_connect(loop);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_thread_join(&server_tid));
+  uv_sem_destroy(&server_ready);
+
+  ASSERT(connects == NUM_CONNECTS);
+  qsort(latencies, NUM_CONNECTS, sizeof(latencies[0]), compare_latencies);
+
+  fprintf(stderr,
+          "%s: connect to first byte p50 %.1f us, p99 %.1f us, "
+          "max %.1f us (%d of %d with data in the SYN)\n",
+          name,
+          latencies[NUM_CONNECTS / 2] / 1e3,
+          latencies[NUM_CONNECTS * 99 / 100] / 1e3,
+          latencies[NUM_CONNECTS - 1] / 1e3,
+          syn_data,
+          NUM_CONNECTS);
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(tcp_connect_first_byte) {
+  return tcp_connect_first_byte("tcp_connect_first_byte", 0);
+}
+
+
+BENCHMARK_IMPL(tcp_connect_first_byte_fastopen) {
+  return tcp_connect_first_byte("tcp_connect_first_byte_fastopen", 1);
+}
@@ -0,0 +1,331 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A client streams bulk data over a connection that the server drains at a
+ * fixed rate, and sends a one byte ping every few milliseconds on the same
+ * connection. The bulk writer only queues its next chunk when the previous one
+ * is done, so pings never wait in libuv's write queue for more than a chunk.
+ * Whatever sits in the kernel's send buffer is in front of them, though.
+ * Reports the ping round trip latencies and the bulk throughput.
+ */
+
+#define NUM_PINGS       200
+#define PING_INTERVAL   10                 /* ms */
+#define BULK_SIZE       (64 * 1024)
+#define READ_RATE       (64 * 1024)        /* bytes per ms */
+#define SEND_BUFFER     (4 * 1024 * 1024)
+#define RECV_BUFFER     (256 * 1024)
+#define LOWAT           (16 * 1024)
+#define PING            '\xff'
+
+static uv_thread_t server_tid;
+static uv_sem_t server_ready;
+static uv_async_t server_done;
+static uv_tcp_t server;
+static uv_tcp_t server_conn;
+static uv_timer_t server_timer;
+static char server_buf[READ_RATE];
+static ssize_t server_budget;
+static int server_reading;
+static uint64_t server_nread;
+
+static uv_tcp_t client;
+static uv_connect_t connect_req;
+static uv_timer_t ping_timer;
+static uv_write_t bulk_req;
+static uv_write_t ping_reqs[NUM_PINGS];
+static char bulk_data[BULK_SIZE];
+static char ping_data = PING;
+static char pong_buf[NUM_PINGS];
+static int stopping;
+
+static uint64_t ping_starts[NUM_PINGS];
+static uint64_t latencies[NUM_PINGS];
+static uint64_t start_time;
+static int pings_sent;
+static int pongs;
+
+
+static void server_alloc_cb(uv_handle_t* handle,
+                            size_t suggested_size,
+                            uv_buf_t* buf) {
+  buf->base = server_buf;
+  buf->len = server_budget;
+}
+
+
+static void server_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  uv_buf_t reply;
+  char* p;
+  char* end;
+
+  if (nread < 0) {
+    uv_close((uv_handle_t*) stream, NULL);
+    uv_close((uv_handle_t*) &server_timer, NULL);
+    return;
+  }
+
+  server_nread += nread;
+  server_budget -= nread;
+
+  /* Echo every ping. */
+  end = buf->base + nread;
+  for (p = buf->base; (p = memchr(p, PING, end - p)) != NULL; p++) {
+    reply = uv_buf_init(p, 1);
+    ASSERT(1 == uv_try_write(stream, &reply, 1));
+  }
+
+  if (server_budget == 0) {
+    ASSERT(0 == uv_read_stop(stream));
+    server_reading = 0;
+  }
+}
+
+
+static void server_timer_cb(uv_timer_t* handle) {
+  server_budget = READ_RATE;
+
+  if (!server_reading) {
+    ASSERT(0 == uv_read_start((uv_stream_t*) &server_conn,
+                              server_alloc_cb,
+                              server_read_cb));
+    server_reading = 1;
+  }
+}
+
+
+static void server_connection_cb(uv_stream_t* stream, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(stream->loop, &server_conn));
+  ASSERT(0 == uv_accept(stream, (uv_stream_t*) &server_conn));
+  ASSERT(0 == uv_tcp_nodelay(&server_conn, 1));
+  ASSERT(0 == uv_timer_init(stream->loop, &server_timer));
+  ASSERT(0 == uv_timer_start(&server_timer, server_timer_cb, 1, 1));
+  uv_close((uv_handle_t*) stream, NULL);
+}
+
+
+static void server_done_cb(uv_async_t* handle) {
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+static void server_thread(void* arg) {
+  struct sockaddr_in addr;
+  uv_loop_t loop;
+  int value;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(&loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+
+  /* Keep the receive window small, the queue should build up in the client. */
+  value = RECV_BUFFER;
+  ASSERT(0 == uv_recv_buffer_size((uv_handle_t*) &server, &value));
+
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, server_connection_cb));
+  ASSERT(0 == uv_async_init(&loop, &server_done, server_done_cb));
+
+  uv_sem_post(&server_ready);
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+}
+
+
+static void bulk_write(void);
+
+
+static void bulk_write_cb(uv_write_t* req, int status) {
+  if (stopping)
+    return;
+
+  ASSERT(status == 0);
+  bulk_write();
+}
+
+
+static void bulk_write(void) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init(bulk_data, sizeof(bulk_data));
+  ASSERT(0 == uv_write(&bulk_req,
+                       (uv_stream_t*) &client,
+                       &buf,
+                       1,
+                       bulk_write_cb));
+}
+
+
+static void ping_timer_cb(uv_timer_t* handle) {
+  uv_buf_t buf;
+
+  if (pings_sent == NUM_PINGS)
+    return;
+
+  buf = uv_buf_init(&ping_data, 1);
+  ping_starts[pings_sent] = uv_hrtime();
+  ASSERT(0 == uv_write(&ping_reqs[pings_sent],
+                       (uv_stream_t*) &client,
+                       &buf,
+                       1,
+                       NULL));
+  pings_sent++;
+}
+
+
+static void pong_alloc_cb(uv_handle_t* handle,
+                          size_t suggested_size,
+                          uv_buf_t* buf) {
+  buf->base = pong_buf + pongs;
+  buf->len = sizeof(pong_buf) - pongs;
+}
+
+
+static void pong_read_cb(uv_stream_t* stream,
+                         ssize_t nread,
+                         const uv_buf_t* buf) {
+  uint64_t now;
+
+  ASSERT(nread >= 0);
+
+  now = uv_hrtime();
+  while (nread-- > 0) {
+    latencies[pongs] = now - ping_starts[pongs];
+    pongs++;
+  }
+
+  if (pongs < NUM_PINGS)
+    return;
+
+  stopping = 1;
+  uv_close((uv_handle_t*) &ping_timer, NULL);
+  uv_close((uv_handle_t*) &client, NULL);
+  ASSERT(0 == uv_async_send(&server_done));
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_read_start((uv_stream_t*) &client,
+                            pong_alloc_cb,
+                            pong_read_cb));
+
+  start_time = uv_hrtime();
+  bulk_write();
+  ASSERT(0 == uv_timer_start(&ping_timer,
+                             ping_timer_cb,
+                             PING_INTERVAL,
+                             PING_INTERVAL));
+}
+
+
+static int compare_latencies(const void* a, const void* b) {
+  uint64_t x;
+  uint64_t y;
+
+  x = *(const uint64_t*) a;
+  y = *(const uint64_t*) b;
+
+  return x < y ? -1 : x > y;
+}
+
+
+static int tcp_notsent_lowat(const char* name, unsigned int lowat) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  double elapsed;
+  int value;
+  int r;
+
+  loop = uv_default_loop();
+  memset(bulk_data, 'x', sizeof(bulk_data));
+
+  ASSERT(0 == uv_tcp_init(loop, &client));
+  ASSERT(0 == uv_tcp_nodelay(&client, 1));
+  if (lowat != 0) {
+    r = uv_tcp_notsent_lowat(&client, lowat);
+    if (r == UV_ENOTSUP) {
+      uv_close((uv_handle_t*) &client, NULL);
+      uv_run(loop, UV_RUN_DEFAULT);
+      fprintf(stderr, "%s: TCP_NOTSENT_LOWAT is not supported\n", name);
+      fflush(stderr);
+      MAKE_VALGRIND_HAPPY();
+      return 0;
+    }
+    ASSERT(r == 0);
+  }
+
+  ASSERT(0 == uv_sem_init(&server_ready, 0));
+  ASSERT(0 == uv_thread_create(&server_tid, server_thread, NULL));
+  uv_sem_wait(&server_ready);
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_timer_init(loop, &ping_timer));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  /* A big send buffer, as on a long fat pipe. */
+  value = SEND_BUFFER;
+  ASSERT(0 == uv_send_buffer_size((uv_handle_t*) &client, &value));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_thread_join(&server_tid));
+  uv_sem_destroy(&server_ready);
+
+  ASSERT(pongs == NUM_PINGS);
+  elapsed = (uv_hrtime() - start_time) / 1e9;
+  qsort(latencies, NUM_PINGS, sizeof(latencies[0]), compare_latencies);
+
+  fprintf(stderr,
+          "%s: ping p50 %.1f ms, p99 %.1f ms, max %.1f ms, bulk %.1f MB/s\n",
+          name,
+          latencies[NUM_PINGS / 2] / 1e6,
+          latencies[NUM_PINGS * 99 / 100] / 1e6,
+          latencies[NUM_PINGS - 1] / 1e6,
+          server_nread / elapsed / (1024 * 1024));
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(tcp_notsent_lowat_off) {
+  return tcp_notsent_lowat("tcp_notsent_lowat_off", 0);
+}
+
+
+BENCHMARK_IMPL(tcp_notsent_lowat) {
+  return tcp_notsent_lowat("tcp_notsent_lowat", LOWAT);
+}
@@ -38,30 +38,50 @@ static write_req* write_reqs;
 static uv_tcp_t tcp_client;
 static uv_connect_t connect_req;
 static uv_shutdown_t shutdown_req;
+static int write_before_connect;
+static int write_copy;
 
 static int shutdown_cb_called = 0;
 static int connect_cb_called = 0;
 static int write_cb_called = 0;
+static int write_copy_cb_called = 0;
 static int close_cb_called = 0;
 
 static void connect_cb(uv_connect_t* req, int status);
 static void write_cb(uv_write_t* req, int status);
+static void write_copy_cb(uv_stream_t* handle, int status);
 static void shutdown_cb(uv_shutdown_t* req, int status);
 static void close_cb(uv_handle_t* handle);
 
 
-static void connect_cb(uv_connect_t* req, int status) {
+static void write_all(uv_stream_t* stream) {
   write_req* w;
   int i;
   int r;
 
-  ASSERT(req->handle == (uv_stream_t*)&tcp_client);
-
   for (i = 0; i < NUM_WRITE_REQS; i++) {
     w = &write_reqs[i];
-    r = uv_write(&w->req, req->handle, &w->buf, 1, write_cb);
+    if (write_copy) {
+      /* Only the last message asks to be told about its completion. */
+      r = uv_write_copy(stream,
+                        &w->buf,
+                        1,
+                        i == NUM_WRITE_REQS - 1 ? write_copy_cb : NULL);
+    } else {
+      r = uv_write(&w->req, stream, &w->buf, 1, write_cb);
+    }
     ASSERT(r == 0);
   }
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  int r;
+
+  ASSERT(req->handle == (uv_stream_t*)&tcp_client);
+
+  if (!write_before_connect)
+    write_all(req->handle);
 
   r = uv_shutdown(&shutdown_req, req->handle, shutdown_cb);
   ASSERT(r == 0);
@@ -77,6 +97,13 @@ static void write_cb(uv_write_t* req, int status) {
 }
 
 
+static void write_copy_cb(uv_stream_t* handle, int status) {
+  ASSERT(handle == (uv_stream_t*)&tcp_client);
+  ASSERT(status == 0);
+  write_copy_cb_called++;
+}
+
+
 static void shutdown_cb(uv_shutdown_t* req, int status) {
   ASSERT(req->handle == (uv_stream_t*)&tcp_client);
   ASSERT(req->handle->write_queue_size == 0);
@@ -94,11 +121,36 @@ static void close_cb(uv_handle_t* handle) {
 }
 
 
-BENCHMARK_IMPL(tcp_write_batch) {
+/* Number of write syscalls made by this process so far, or -1 when the
+ * platform doesn't expose it. Only Linux with task I/O accounting does.
+ */
+static int64_t write_syscalls(void) {
+  long long syscw;
+  char line[128];
+  FILE* fp;
+
+  syscw = -1;
+  fp = fopen("/proc/self/io", "r");
+  if (fp == NULL)
+    return -1;
+
+  while (fgets(line, sizeof(line), fp) != NULL)
+    if (sscanf(line, "syscw: %lld", &syscw) == 1)
+      break;
+
+  fclose(fp);
+  return syscw;
+}
+
+
+static int tcp_write_batch(const char* name, int queued, int copy) {
   struct sockaddr_in addr;
   uv_loop_t* loop;
   uint64_t start;
   uint64_t stop;
+  int64_t syscw_start;
+  int64_t syscw_stop;
+  double secs;
   int i;
   int r;
 
@@ -123,22 +175,61 @@ BENCHMARK_IMPL(tcp_write_batch) {
                      connect_cb);
   ASSERT(r == 0);
 
+  syscw_start = write_syscalls();
   start = uv_hrtime();
 
+  /* Writes issued while connecting are queued and flushed together once the
+   * connection is established.
+   */
+  write_before_connect = queued;
+  write_copy = copy;
+  if (write_before_connect)
+    write_all((uv_stream_t*) &tcp_client);
+
   r = uv_run(loop, UV_RUN_DEFAULT);
   ASSERT(r == 0);
 
   stop = uv_hrtime();
+  syscw_stop = write_syscalls();
 
   ASSERT(connect_cb_called == 1);
-  ASSERT(write_cb_called == NUM_WRITE_REQS);
+  if (write_copy) {
+    ASSERT(write_copy_cb_called == 1);
+  } else {
+    ASSERT(write_cb_called == NUM_WRITE_REQS);
+  }
   ASSERT(shutdown_cb_called == 1);
   ASSERT(close_cb_called == 1);
 
-  printf("%ld write requests in %.2fs.\n",
+  secs = (stop - start) / 1e9;
+  printf("%s: %ld writes in %.2fs (%.1f MB/s).\n",
+         name,
          (long)NUM_WRITE_REQS,
-         (stop - start) / 1e9);
+         secs,
+         NUM_WRITE_REQS * (sizeof(WRITE_REQ_DATA) - 1) / secs / (1024 * 1024));
+
+  if (syscw_start >= 0 && syscw_stop >= 0) {
+    printf("%s: %lld write syscalls, %.1f writes per syscall.\n",
+           name,
+           (long long) (syscw_stop - syscw_start),
+           (double) NUM_WRITE_REQS / (syscw_stop - syscw_start));
+  }
 
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+BENCHMARK_IMPL(tcp_write_batch) {
+  return tcp_write_batch("tcp_write_batch", 0, 0);
+}
+
+
+BENCHMARK_IMPL(tcp_write_batch_queued) {
+  return tcp_write_batch("tcp_write_batch_queued", 1, 0);
+}
+
+
+BENCHMARK_IMPL(tcp_write_copy) {
+  return tcp_write_batch("tcp_write_copy", 0, 1);
+}
@@ -32,9 +32,16 @@
 
 #define BASE_PORT 12345
 
+/* Room for as many datagrams as uv_udp_t reads with one recvmmsg() call. */
+#define MMSG_SLAB_SIZE (32 * 65536)
+
+/* Sends in flight per sender in mmsg mode, enough to fill a sendmmsg() call. */
+#define MMSG_SEND_DEPTH 32
+
 struct sender_state {
   struct sockaddr_in addr;
-  uv_udp_send_t send_req;
+  const struct sockaddr* dest;  /* NULL when connected. */
+  uv_udp_send_t send_reqs[MMSG_SEND_DEPTH];
   uv_udp_t udp_handle;
 };
 
@@ -55,17 +62,22 @@ static struct receiver_state receivers[1024];
 static unsigned int send_cb_called;
 static unsigned int recv_cb_called;
 static unsigned int close_cb_called;
+static unsigned int alloc_cb_called;
 static int timed;
 static int exiting;
+static int mmsg;
+static int connected;
 
 
+/* Called once per receive syscall, recvmsg() or recvmmsg(). */
 static void alloc_cb(uv_handle_t* handle,
                      size_t suggested_size,
                      uv_buf_t* buf) {
-  static char slab[65536];
+  static char slab[MMSG_SLAB_SIZE];
   ASSERT(suggested_size <= sizeof(slab));
   buf->base = slab;
-  buf->len = sizeof(slab);
+  buf->len = mmsg ? sizeof(slab) : 65536;
+  alloc_cb_called++;
 }
 
 
@@ -82,9 +94,12 @@ static void send_cb(uv_udp_send_t* req, int status) {
   if (exiting)
     return;
 
-  s = container_of(req, struct sender_state, send_req);
+  s = req->data;
   ASSERT(req->handle == &s->udp_handle);
 
+  if (uv_is_closing((uv_handle_t*) &s->udp_handle))
+    return;
+
   if (timed)
     goto send;
 
@@ -96,11 +111,11 @@ static void send_cb(uv_udp_send_t* req, int status) {
   packet_counter--;
 
 send:
-  ASSERT(0 == uv_udp_send(&s->send_req,
+  ASSERT(0 == uv_udp_send(req,
                           &s->udp_handle,
                           bufs,
                           ARRAY_SIZE(bufs),
-                          (const struct sockaddr*) &s->addr,
+                          s->dest,
                           send_cb));
   send_cb_called++;
 }
@@ -148,10 +163,13 @@ static void timeout_cb(uv_timer_t* timer) {
 static int pummel(unsigned int n_senders,
                   unsigned int n_receivers,
                   unsigned long timeout) {
+  uv_loop_memory_stats_t stats;
   uv_timer_t timer_handle;
   uint64_t duration;
   uv_loop_t* loop;
+  unsigned int depth;
   unsigned int i;
+  unsigned int k;
 
   ASSERT(n_senders <= ARRAY_SIZE(senders));
   ASSERT(n_receivers <= ARRAY_SIZE(receivers));
@@ -173,8 +191,15 @@ static int pummel(unsigned int n_senders,
     struct receiver_state* s = receivers + i;
     struct sockaddr_in addr;
     ASSERT(0 == uv_ip4_addr("0.0.0.0", BASE_PORT + i, &addr));
-    ASSERT(0 == uv_udp_init(loop, &s->udp_handle));
+    if (mmsg)
+      ASSERT(0 == uv_udp_init_ex(loop,
+                                 &s->udp_handle,
+                                 AF_INET | UV_UDP_RECVMMSG));
+    else
+      ASSERT(0 == uv_udp_init(loop, &s->udp_handle));
     ASSERT(0 == uv_udp_bind(&s->udp_handle, (const struct sockaddr*) &addr, 0));
+    /* Best effort, the count stays 0 where SO_RXQ_OVFL is missing. */
+    uv_udp_set_drop_counter(&s->udp_handle, 1);
     ASSERT(0 == uv_udp_recv_start(&s->udp_handle, alloc_cb, recv_cb));
     uv_unref((uv_handle_t*)&s->udp_handle);
   }
@@ -185,18 +210,29 @@ static int pummel(unsigned int n_senders,
   bufs[3] = uv_buf_init(EXPECTED + 30, 10);
   bufs[4] = uv_buf_init(EXPECTED + 40, 5);
 
+  /* Several sends in flight let the queue be flushed with sendmmsg(). */
+  depth = mmsg ? MMSG_SEND_DEPTH : 1;
+
   for (i = 0; i < n_senders; i++) {
     struct sender_state* s = senders + i;
     ASSERT(0 == uv_ip4_addr("127.0.0.1",
                             BASE_PORT + (i % n_receivers),
                             &s->addr));
     ASSERT(0 == uv_udp_init(loop, &s->udp_handle));
-    ASSERT(0 == uv_udp_send(&s->send_req,
-                            &s->udp_handle,
-                            bufs,
-                            ARRAY_SIZE(bufs),
-                            (const struct sockaddr*) &s->addr,
-                            send_cb));
+    s->dest = (const struct sockaddr*) &s->addr;
+    if (connected) {
+      ASSERT(0 == uv_udp_connect(&s->udp_handle, s->dest));
+      s->dest = NULL;
+    }
+    for (k = 0; k < depth; k++) {
+      s->send_reqs[k].data = s;
+      ASSERT(0 == uv_udp_send(&s->send_reqs[k],
+                              &s->udp_handle,
+                              bufs,
+                              ARRAY_SIZE(bufs),
+                              s->dest,
+                              send_cb));
+    }
   }
 
   duration = uv_hrtime();
@@ -205,15 +241,22 @@ static int pummel(unsigned int n_senders,
   /* convert from nanoseconds to milliseconds */
   duration = duration / (uint64_t) 1e6;
 
-  printf("udp_pummel_%dv%d: %.0f/s received, %.0f/s sent. "
-         "%u received, %u sent in %.1f seconds.\n",
+  if (uv_loop_memory_stats(loop, &stats))
+    stats.udp_rx_dropped = 0;
+
+  printf("udp_pummel_%s%dv%d: %.0f/s received, %.0f/s sent. "
+         "%u received, %u sent in %.1f seconds. "
+         "%.3f receive syscalls/packet, %llu dropped.\n",
+         mmsg ? "mmsg_" : (connected ? "connected_" : ""),
          n_receivers,
          n_senders,
          recv_cb_called / (duration / 1000.0),
          send_cb_called / (duration / 1000.0),
          recv_cb_called,
          send_cb_called,
-         duration / 1000.0);
+         duration / 1000.0,
+         recv_cb_called ? (double) alloc_cb_called / recv_cb_called : 0.0,
+         (unsigned long long) stats.udp_rx_dropped);
 
   MAKE_VALGRIND_HAPPY();
   return 0;
@@ -241,3 +284,217 @@ X(100, 1000)
 X(1000, 1000)
 
 #undef X
+
+#define X(a, b)                                                               \
+  BENCHMARK_IMPL(udp_pummel_mmsg_##a##v##b) {                                 \
+    mmsg = 1;                                                                 \
+    return pummel(a, b, 0);                                                   \
+  }                                                                           \
+  BENCHMARK_IMPL(udp_timed_pummel_mmsg_##a##v##b) {                           \
+    mmsg = 1;                                                                 \
+    return pummel(a, b, TEST_DURATION);                                       \
+  }
+
+X(1, 1)
+X(10, 10)
+X(100, 100)
+X(1000, 1000)
+
+#undef X
+
+#define X(a, b)                                                               \
+  BENCHMARK_IMPL(udp_pummel_connected_##a##v##b) {                            \
+    connected = 1;                                                            \
+    return pummel(a, b, 0);                                                   \
+  }                                                                           \
+  BENCHMARK_IMPL(udp_timed_pummel_connected_##a##v##b) {                      \
+    connected = 1;                                                            \
+    return pummel(a, b, TEST_DURATION);                                       \
+  }
+
+X(1, 1)
+X(10, 10)
+X(100, 100)
+X(1000, 1000)
+
+#undef X
+
+
+/* Sharded receive: one loop and thread per shard, bound to the same address
+ * with uv_udp_bind_group(), and as many threads that flood it with
+ * uv_udp_try_send() from SHARD_FLOWS sockets each.
+ */
+#define MAX_SHARDS 8
+#define SHARD_FLOWS 16
+
+struct shard_state {
+  uv_loop_t loop;
+  uv_udp_t udp_handle;
+  uv_async_t stop_handle;
+  uv_thread_t thread;
+  unsigned int received;
+};
+
+struct flood_state {
+  uv_loop_t loop;
+  uv_udp_t flows[SHARD_FLOWS];
+  uv_thread_t thread;
+  unsigned int sent;
+};
+
+static struct shard_state shards[MAX_SHARDS];
+static struct flood_state floods[MAX_SHARDS];
+static struct sockaddr_in shard_addr;
+static uint64_t flood_deadline;
+
+
+static void shard_recv_cb(uv_udp_t* handle,
+                          ssize_t nread,
+                          const uv_buf_t* buf,
+                          const struct sockaddr* addr,
+                          unsigned flags) {
+  struct shard_state* s;
+
+  if (nread <= 0)
+    return;
+
+  s = container_of(handle, struct shard_state, udp_handle);
+  s->received++;
+}
+
+
+static void shard_stop_cb(uv_async_t* handle) {
+  struct shard_state* s;
+
+  s = container_of(handle, struct shard_state, stop_handle);
+  uv_close((uv_handle_t*) &s->udp_handle, NULL);
+  uv_close((uv_handle_t*) &s->stop_handle, NULL);
+}
+
+
+static void shard_cb(void* arg) {
+  struct shard_state* s;
+
+  s = arg;
+  ASSERT(0 == uv_run(&s->loop, UV_RUN_DEFAULT));
+}
+
+
+static void flood_cb(void* arg) {
+  struct flood_state* f;
+  unsigned int i;
+
+  f = arg;
+  ASSERT(0 == uv_loop_init(&f->loop));
+  for (i = 0; i < SHARD_FLOWS; i++)
+    ASSERT(0 == uv_udp_init(&f->loop, &f->flows[i]));
+
+  while (uv_hrtime() < flood_deadline)
+    for (i = 0; i < SHARD_FLOWS; i++)
+      if (uv_udp_try_send(&f->flows[i],
+                          bufs,
+                          ARRAY_SIZE(bufs),
+                          (const struct sockaddr*) &shard_addr) > 0)
+        f->sent++;
+
+  for (i = 0; i < SHARD_FLOWS; i++)
+    uv_close((uv_handle_t*) &f->flows[i], NULL);
+  ASSERT(0 == uv_run(&f->loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&f->loop));
+}
+
+
+static int pummel_sharded(unsigned int n_shards) {
+  uv_loop_t* loops[MAX_SHARDS];
+  uv_udp_t* handles[MAX_SHARDS];
+  unsigned long long dropped;
+  unsigned int received;
+  unsigned int sent;
+  uint64_t duration;
+  unsigned int i;
+  int r;
+
+  ASSERT(n_shards <= MAX_SHARDS);
+
+  bufs[0] = uv_buf_init(EXPECTED + 0,  10);
+  bufs[1] = uv_buf_init(EXPECTED + 10, 10);
+  bufs[2] = uv_buf_init(EXPECTED + 20, 10);
+  bufs[3] = uv_buf_init(EXPECTED + 30, 10);
+  bufs[4] = uv_buf_init(EXPECTED + 40, 5);
+
+  for (i = 0; i < n_shards; i++) {
+    ASSERT(0 == uv_loop_init(&shards[i].loop));
+    loops[i] = &shards[i].loop;
+    handles[i] = &shards[i].udp_handle;
+  }
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", BASE_PORT, &shard_addr));
+  r = uv_udp_bind_group(loops,
+                        handles,
+                        n_shards,
+                        (const struct sockaddr*) &shard_addr,
+                        0);
+  if (r == UV_ENOTSUP) {
+    for (i = 0; i < n_shards; i++)
+      ASSERT(0 == uv_loop_close(&shards[i].loop));
+    RETURN_SKIP("SO_REUSEPORT is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  for (i = 0; i < n_shards; i++) {
+    struct shard_state* s = shards + i;
+    uv_udp_set_drop_counter(&s->udp_handle, 1);
+    ASSERT(0 == uv_udp_recv_start(&s->udp_handle, NULL, shard_recv_cb));
+    ASSERT(0 == uv_async_init(&s->loop, &s->stop_handle, shard_stop_cb));
+    ASSERT(0 == uv_thread_create(&s->thread, shard_cb, s));
+  }
+
+  duration = uv_hrtime();
+  flood_deadline = duration + (uint64_t) TEST_DURATION * 1000000;
+  for (i = 0; i < n_shards; i++)
+    ASSERT(0 == uv_thread_create(&floods[i].thread, flood_cb, floods + i));
+  for (i = 0; i < n_shards; i++)
+    ASSERT(0 == uv_thread_join(&floods[i].thread));
+  duration = (uv_hrtime() - duration) / (uint64_t) 1e6;
+
+  received = 0;
+  sent = 0;
+  dropped = 0;
+  for (i = 0; i < n_shards; i++) {
+    struct shard_state* s = shards + i;
+    ASSERT(0 == uv_async_send(&s->stop_handle));
+    ASSERT(0 == uv_thread_join(&s->thread));
+    ASSERT(0 == uv_loop_close(&s->loop));
+    received += s->received;
+    sent += floods[i].sent;
+    dropped += uv_udp_get_drop_counter(&s->udp_handle);
+  }
+
+  printf("udp_pummel_reuseport_%u: %.0f/s received, %.0f/s sent. "
+         "%u received, %u sent in %.1f seconds, %llu dropped.\n",
+         n_shards,
+         received / (duration / 1000.0),
+         sent / (duration / 1000.0),
+         received,
+         sent,
+         duration / 1000.0,
+         dropped);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(udp_pummel_reuseport_1) {
+  return pummel_sharded(1);
+}
+
+
+BENCHMARK_IMPL(udp_pummel_reuseport_2) {
+  return pummel_sharded(2);
+}
+
+
+BENCHMARK_IMPL(udp_pummel_reuseport_4) {
+  return pummel_sharded(4);
+}
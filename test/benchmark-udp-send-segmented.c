@@ -0,0 +1,199 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* A sender pushes QUIC sized datagrams to a receiver on the same loop over
+ * loopback, a burst of BURST datagrams at a time. It either queues every
+ * datagram with uv_udp_send() (flushed with sendmmsg() where available) or
+ * the whole burst with one uv_udp_send_segmented() call. In the last case the
+ * receiver can also take them coalesced with uv_udp_set_gro(). Reports
+ * datagrams per second on both ends.
+ */
+
+#define DURATION      5000          /* ms */
+#define SEGMENT_SIZE  1200
+#define BURST         32
+#define IN_FLIGHT     4
+
+struct burst_s {
+  uv_udp_send_t reqs[BURST];
+  int pending;
+};
+
+static uv_udp_t sender;
+static uv_udp_t receiver;
+static uv_timer_t timer;
+static struct sockaddr_in addr;
+static struct burst_s bursts[IN_FLIGHT];
+static char data[BURST * SEGMENT_SIZE];
+static int segmented;
+static int gro;
+static int stopping;
+
+static uint64_t sent;
+static uint64_t received;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  static char slab[32 * 65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  size_t segment_size;
+
+  ASSERT(nread >= 0 || nread == UV_ECANCELED);
+  if (nread <= 0)
+    return;
+
+  segment_size = uv_udp_get_gro_segment_size(handle);
+  if (flags & UV_UDP_GRO)
+    received += (nread + segment_size - 1) / segment_size;
+  else
+    received++;
+}
+
+
+static void send_burst(struct burst_s* b);
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  struct burst_s* b;
+
+  b = req->data;
+  if (status == UV_ECANCELED)
+    return;
+  ASSERT(status == 0);
+
+  if (--b->pending > 0)
+    return;
+
+  sent += BURST;
+  if (!stopping)
+    send_burst(b);
+}
+
+
+static void send_burst(struct burst_s* b) {
+  uv_buf_t buf;
+  int i;
+
+  if (segmented) {
+    buf = uv_buf_init(data, sizeof(data));
+    b->reqs[0].data = b;
+    b->pending = 1;
+    ASSERT(0 == uv_udp_send_segmented(&b->reqs[0],
+                                      &sender,
+                                      &buf,
+                                      1,
+                                      SEGMENT_SIZE,
+                                      (const struct sockaddr*) &addr,
+                                      send_cb));
+    return;
+  }
+
+  b->pending = BURST;
+  for (i = 0; i < BURST; i++) {
+    buf = uv_buf_init(data + i * SEGMENT_SIZE, SEGMENT_SIZE);
+    b->reqs[i].data = b;
+    ASSERT(0 == uv_udp_send(&b->reqs[i],
+                            &sender,
+                            &buf,
+                            1,
+                            (const struct sockaddr*) &addr,
+                            send_cb));
+  }
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  stopping = 1;
+  uv_close((uv_handle_t*) &sender, NULL);
+  uv_close((uv_handle_t*) &receiver, NULL);
+}
+
+
+static int run_benchmark(int segment, int coalesce) {
+  uv_loop_t* loop;
+  uint64_t duration;
+  int i;
+
+  segmented = segment;
+  gro = coalesce;
+  loop = uv_default_loop();
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init_ex(loop, &receiver, AF_INET | UV_UDP_RECVMMSG));
+  ASSERT(0 == uv_udp_bind(&receiver, (const struct sockaddr*) &addr, 0));
+  if (gro)
+    ASSERT(0 == uv_udp_set_gro(&receiver, 1));
+  ASSERT(0 == uv_udp_recv_start(&receiver, alloc_cb, recv_cb));
+
+  ASSERT(0 == uv_udp_init(loop, &sender));
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb, DURATION, 0));
+
+  duration = uv_hrtime();
+  for (i = 0; i < IN_FLIGHT; i++)
+    send_burst(&bursts[i]);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  duration = (uv_hrtime() - duration) / 1000000;
+
+  fprintf(stderr,
+          "udp_send_%s%s: %.0f datagrams/s sent, %.0f datagrams/s received\n",
+          segmented ? "segmented" : "unsegmented",
+          gro ? "_gro" : "",
+          sent / (duration / 1000.0),
+          received / (duration / 1000.0));
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(udp_send_unsegmented) {
+  return run_benchmark(0, 0);
+}
+
+
+BENCHMARK_IMPL(udp_send_segmented) {
+  return run_benchmark(1, 0);
+}
+
+
+BENCHMARK_IMPL(udp_send_segmented_gro) {
+  return run_benchmark(1, 1);
+}
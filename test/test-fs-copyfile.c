@@ -0,0 +1,177 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define FIXTURE "test_file"
+#define DST "test_file_copy"
+
+static char data[256 * 1024];
+static char readback[sizeof(data) + 1];
+static int copyfile_cb_called;
+
+
+static void write_file(const char* path, const char* buf, size_t len) {
+  uv_fs_t req;
+  uv_buf_t iov;
+  int fd;
+
+  fd = uv_fs_open(NULL, &req, path, O_WRONLY | O_CREAT | O_TRUNC, 0640, NULL);
+  ASSERT(fd >= 0);
+  uv_fs_req_cleanup(&req);
+
+  iov = uv_buf_init((char*) buf, len);
+  ASSERT((int) len == uv_fs_write(NULL, &req, fd, &iov, 1, 0, NULL));
+  uv_fs_req_cleanup(&req);
+
+  ASSERT(0 == uv_fs_close(NULL, &req, fd, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+/* Reads back `path` and checks that it holds `len` bytes of `data`. */
+static void check_file(const char* path, size_t len) {
+  uv_fs_t req;
+  uv_buf_t iov;
+  int fd;
+
+  fd = uv_fs_open(NULL, &req, path, O_RDONLY, 0, NULL);
+  ASSERT(fd >= 0);
+  uv_fs_req_cleanup(&req);
+
+  iov = uv_buf_init(readback, sizeof(readback));
+  ASSERT((int) len == uv_fs_read(NULL, &req, fd, &iov, 1, -1, NULL));
+  uv_fs_req_cleanup(&req);
+  ASSERT(0 == memcmp(readback, data, len));
+
+  ASSERT(0 == uv_fs_close(NULL, &req, fd, NULL));
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void unlink_file(const char* path) {
+  uv_fs_t req;
+
+  uv_fs_unlink(NULL, &req, path, NULL);
+  uv_fs_req_cleanup(&req);
+}
+
+
+static void copyfile_cb(uv_fs_t* req) {
+  ASSERT(req->fs_type == UV_FS_COPYFILE);
+  ASSERT(req->result == 0);
+  copyfile_cb_called++;
+  uv_fs_req_cleanup(req);
+}
+
+
+TEST_IMPL(fs_copyfile) {
+  uv_fs_t req;
+  size_t i;
+  int r;
+
+  for (i = 0; i < sizeof(data); i++)
+    data[i] = i % 251;
+
+  unlink_file(FIXTURE);
+  unlink_file(DST);
+
+  /* Missing source, and unknown flags. */
+  r = uv_fs_copyfile(NULL, &req, FIXTURE, DST, 0, NULL);
+  ASSERT(r == UV_ENOENT);
+  uv_fs_req_cleanup(&req);
+  r = uv_fs_copyfile(NULL, &req, FIXTURE, DST, 0x100, NULL);
+  ASSERT(r == UV_EINVAL);
+
+  /* Empty file. */
+  write_file(FIXTURE, data, 0);
+  r = uv_fs_copyfile(NULL, &req, FIXTURE, DST, 0, NULL);
+  ASSERT(r == 0);
+  uv_fs_req_cleanup(&req);
+  check_file(DST, 0);
+
+  /* Overwrites a longer destination. */
+  write_file(DST, data, sizeof(data));
+  write_file(FIXTURE, data, 1000);
+  r = uv_fs_copyfile(NULL, &req, FIXTURE, DST, 0, NULL);
+  ASSERT(r == 0);
+  uv_fs_req_cleanup(&req);
+  check_file(DST, 1000);
+
+  /* Refuses to overwrite with UV_FS_COPYFILE_EXCL. */
+  r = uv_fs_copyfile(NULL, &req, FIXTURE, DST, UV_FS_COPYFILE_EXCL, NULL);
+  ASSERT(r == UV_EEXIST);
+  uv_fs_req_cleanup(&req);
+  check_file(DST, 1000);
+
+  /* Larger than any single chunk, through the threadpool. */
+  unlink_file(DST);
+  write_file(FIXTURE, data, sizeof(data));
+  r = uv_fs_copyfile(uv_default_loop(),
+                     &req,
+                     FIXTURE,
+                     DST,
+                     UV_FS_COPYFILE_EXCL,
+                     copyfile_cb);
+  ASSERT(r == 0);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(copyfile_cb_called == 1);
+  check_file(DST, sizeof(data));
+
+#ifndef _WIN32
+  /* The destination takes the mode of the source. */
+  r = uv_fs_stat(NULL, &req, DST, NULL);
+  ASSERT(r == 0);
+  ASSERT((req.statbuf.st_mode & 0777) == 0640);
+  uv_fs_req_cleanup(&req);
+#endif
+
+  /* Copying a file onto itself, or onto a hard link to it, must not truncate
+   * the source.
+   */
+  r = uv_fs_copyfile(NULL, &req, FIXTURE, FIXTURE, 0, NULL);
+#ifndef _WIN32
+  ASSERT(r == 0);
+#endif
+  uv_fs_req_cleanup(&req);
+  check_file(FIXTURE, sizeof(data));
+
+  unlink_file(DST);
+  r = uv_fs_link(NULL, &req, FIXTURE, DST, NULL);
+  ASSERT(r == 0);
+  uv_fs_req_cleanup(&req);
+  r = uv_fs_copyfile(NULL, &req, FIXTURE, DST, 0, NULL);
+#ifndef _WIN32
+  ASSERT(r == 0);
+#endif
+  uv_fs_req_cleanup(&req);
+  check_file(FIXTURE, sizeof(data));
+  check_file(DST, sizeof(data));
+
+  unlink_file(FIXTURE);
+  unlink_file(DST);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -32,6 +32,9 @@ TEST_DECLARE   (loop_stop)
 TEST_DECLARE   (loop_update_time)
 TEST_DECLARE   (loop_backend_timeout)
 TEST_DECLARE   (loop_configure)
+TEST_DECLARE   (loop_memory_budget)
+TEST_DECLARE   (loop_io_budget)
+TEST_DECLARE   (loop_io_budget_accept)
 TEST_DECLARE   (default_loop_close)
 TEST_DECLARE   (barrier_1)
 TEST_DECLARE   (barrier_2)
@@ -76,6 +79,19 @@ TEST_DECLARE   (tcp_writealot)
 TEST_DECLARE   (tcp_write_fail)
 TEST_DECLARE   (tcp_try_write)
 TEST_DECLARE   (tcp_write_queue_order)
+TEST_DECLARE   (tcp_write_gather)
+TEST_DECLARE   (tcp_write_gather_empty_tail)
+TEST_DECLARE   (tcp_accept_group)
+TEST_DECLARE   (tcp_accept_group_least_connections)
+TEST_DECLARE   (tcp_reuseport)
+TEST_DECLARE   (write_copy)
+TEST_DECLARE   (write_copy_close)
+TEST_DECLARE   (write_copy_connect)
+TEST_DECLARE   (write_copy_try_write)
+TEST_DECLARE   (stream_watermarks)
+TEST_DECLARE   (stream_rate_limit)
+TEST_DECLARE   (stream_idle_timeout)
+TEST_DECLARE   (tcp_notsent_lowat)
 TEST_DECLARE   (tcp_open)
 TEST_DECLARE   (tcp_open_twice)
 TEST_DECLARE   (tcp_connect_error_after_write)
@@ -89,6 +105,9 @@ TEST_DECLARE   (tcp_bind_localhost_ok)
 TEST_DECLARE   (tcp_bind_invalid_flags)
 TEST_DECLARE   (tcp_listen_without_bind)
 TEST_DECLARE   (tcp_connect_error_fault)
+TEST_DECLARE   (tcp_connect_multi)
+TEST_DECLARE   (tcp_connect_multi_error)
+TEST_DECLARE   (tcp_connect_multi_close)
 TEST_DECLARE   (tcp_connect_timeout)
 TEST_DECLARE   (tcp_close_while_connecting)
 TEST_DECLARE   (tcp_close)
@@ -100,7 +119,10 @@ TEST_DECLARE   (tcp_create_early_accept)
 TEST_DECLARE   (tcp_close_accept)
 TEST_DECLARE   (tcp_oob)
 #endif
+TEST_DECLARE   (tcp_fastopen)
 TEST_DECLARE   (tcp_flags)
+TEST_DECLARE   (tcp_get_info)
+TEST_DECLARE   (tcp_rate_limit)
 TEST_DECLARE   (tcp_write_to_half_open_connection)
 TEST_DECLARE   (tcp_unexpected_read)
 TEST_DECLARE   (tcp_read_stop)
@@ -111,19 +133,31 @@ TEST_DECLARE   (tcp_bind6_error_inval)
 TEST_DECLARE   (tcp_bind6_localhost_ok)
 TEST_DECLARE   (udp_alloc_cb_fail)
 TEST_DECLARE   (udp_bind)
+TEST_DECLARE   (udp_reuseport)
+TEST_DECLARE   (udp_bind_group)
 TEST_DECLARE   (udp_bind_reuseaddr)
+TEST_DECLARE   (udp_connect)
 TEST_DECLARE   (udp_create_early)
 TEST_DECLARE   (udp_create_early_bad_bind)
 TEST_DECLARE   (udp_create_early_bad_domain)
 TEST_DECLARE   (udp_send_and_recv)
 TEST_DECLARE   (udp_send_immediate)
+TEST_DECLARE   (udp_send_segmented)
 TEST_DECLARE   (udp_send_unreachable)
 TEST_DECLARE   (udp_multicast_join)
 TEST_DECLARE   (udp_multicast_join6)
 TEST_DECLARE   (udp_multicast_ttl)
+TEST_DECLARE   (udp_mmsg)
 TEST_DECLARE   (udp_multicast_interface)
 TEST_DECLARE   (udp_multicast_interface6)
 TEST_DECLARE   (udp_dgram_too_big)
+TEST_DECLARE   (udp_gro)
+TEST_DECLARE   (udp_recv_info)
+TEST_DECLARE   (udp_recv_info_ipv6)
+TEST_DECLARE   (udp_drop_counter)
+TEST_DECLARE   (udp_drop_counter_enable_late)
+TEST_DECLARE   (udp_recv_slab)
+TEST_DECLARE   (udp_recv_slab_mmsg)
 TEST_DECLARE   (udp_dual_stack)
 TEST_DECLARE   (udp_ipv6_only)
 TEST_DECLARE   (udp_options)
@@ -132,6 +166,7 @@ TEST_DECLARE   (udp_no_autobind)
 TEST_DECLARE   (udp_open)
 TEST_DECLARE   (udp_open_twice)
 TEST_DECLARE   (udp_try_send)
+TEST_DECLARE   (udp_try_send_batch)
 TEST_DECLARE   (pipe_bind_error_addrinuse)
 TEST_DECLARE   (pipe_bind_error_addrnotavail)
 TEST_DECLARE   (pipe_bind_error_inval)
@@ -226,6 +261,9 @@ TEST_DECLARE   (getsockname_udp)
 TEST_DECLARE   (fail_always)
 TEST_DECLARE   (pass_always)
 TEST_DECLARE   (socket_buffer_size)
+TEST_DECLARE   (read_size_mode_errors)
+TEST_DECLARE   (read_size_mode_tcp_fionread)
+TEST_DECLARE   (read_size_mode_udp_fionread)
 TEST_DECLARE   (spawn_fails)
 #ifndef _WIN32
 TEST_DECLARE   (spawn_fails_check_for_waitpid_cleanup)
@@ -261,6 +299,7 @@ TEST_DECLARE   (fs_file_sync)
 TEST_DECLARE   (fs_file_write_null_buffer)
 TEST_DECLARE   (fs_async_dir)
 TEST_DECLARE   (fs_async_sendfile)
+TEST_DECLARE   (fs_copyfile)
 TEST_DECLARE   (fs_mkdtemp)
 TEST_DECLARE   (fs_fstat)
 TEST_DECLARE   (fs_access)
@@ -381,6 +420,9 @@ TASK_LIST_START
   TEST_ENTRY  (loop_update_time)
   TEST_ENTRY  (loop_backend_timeout)
   TEST_ENTRY  (loop_configure)
+  TEST_ENTRY  (loop_memory_budget)
+  TEST_ENTRY  (loop_io_budget)
+  TEST_ENTRY  (loop_io_budget_accept)
   TEST_ENTRY  (default_loop_close)
   TEST_ENTRY  (barrier_1)
   TEST_ENTRY  (barrier_2)
@@ -450,7 +492,20 @@ TASK_LIST_START
   TEST_ENTRY  (tcp_try_write)
 
   TEST_ENTRY  (tcp_write_queue_order)
-
+  TEST_ENTRY  (tcp_write_gather)
+  TEST_ENTRY  (tcp_write_gather_empty_tail)
+  TEST_ENTRY  (tcp_accept_group)
+  TEST_ENTRY  (tcp_accept_group_least_connections)
+  TEST_ENTRY  (tcp_reuseport)
+  TEST_ENTRY  (write_copy)
+  TEST_ENTRY  (write_copy_close)
+  TEST_ENTRY  (write_copy_connect)
+  TEST_ENTRY  (write_copy_try_write)
+  TEST_ENTRY  (stream_watermarks)
+  TEST_ENTRY  (stream_rate_limit)
+  TEST_ENTRY  (stream_idle_timeout)
+
+  TEST_ENTRY  (tcp_notsent_lowat)
   TEST_ENTRY  (tcp_open)
   TEST_HELPER (tcp_open, tcp4_echo_server)
   TEST_ENTRY  (tcp_open_twice)
@@ -468,6 +523,9 @@ TASK_LIST_START
   TEST_ENTRY  (tcp_bind_invalid_flags)
   TEST_ENTRY  (tcp_listen_without_bind)
   TEST_ENTRY  (tcp_connect_error_fault)
+  TEST_ENTRY  (tcp_connect_multi)
+  TEST_ENTRY  (tcp_connect_multi_error)
+  TEST_ENTRY  (tcp_connect_multi_close)
   TEST_ENTRY  (tcp_connect_timeout)
   TEST_ENTRY  (tcp_close_while_connecting)
   TEST_ENTRY  (tcp_close)
@@ -479,7 +537,10 @@ TASK_LIST_START
   TEST_ENTRY  (tcp_close_accept)
   TEST_ENTRY  (tcp_oob)
 #endif
+  TEST_ENTRY  (tcp_fastopen)
   TEST_ENTRY  (tcp_flags)
+  TEST_ENTRY  (tcp_get_info)
+  TEST_ENTRY  (tcp_rate_limit)
   TEST_ENTRY  (tcp_write_to_half_open_connection)
   TEST_ENTRY  (tcp_unexpected_read)
 
@@ -494,25 +555,38 @@ TASK_LIST_START
 
   TEST_ENTRY  (udp_alloc_cb_fail)
   TEST_ENTRY  (udp_bind)
+  TEST_ENTRY  (udp_reuseport)
+  TEST_ENTRY  (udp_bind_group)
   TEST_ENTRY  (udp_bind_reuseaddr)
+  TEST_ENTRY  (udp_connect)
   TEST_ENTRY  (udp_create_early)
   TEST_ENTRY  (udp_create_early_bad_bind)
   TEST_ENTRY  (udp_create_early_bad_domain)
   TEST_ENTRY  (udp_send_and_recv)
   TEST_ENTRY  (udp_send_immediate)
+  TEST_ENTRY  (udp_send_segmented)
   TEST_ENTRY  (udp_send_unreachable)
   TEST_ENTRY  (udp_dgram_too_big)
+  TEST_ENTRY  (udp_gro)
+  TEST_ENTRY  (udp_recv_info)
+  TEST_ENTRY  (udp_recv_info_ipv6)
+  TEST_ENTRY  (udp_drop_counter)
+  TEST_ENTRY  (udp_drop_counter_enable_late)
+  TEST_ENTRY  (udp_recv_slab)
+  TEST_ENTRY  (udp_recv_slab_mmsg)
   TEST_ENTRY  (udp_dual_stack)
   TEST_ENTRY  (udp_ipv6_only)
   TEST_ENTRY  (udp_options)
   TEST_ENTRY  (udp_options6)
   TEST_ENTRY  (udp_no_autobind)
+  TEST_ENTRY  (udp_mmsg)
   TEST_ENTRY  (udp_multicast_interface)
   TEST_ENTRY  (udp_multicast_interface6)
   TEST_ENTRY  (udp_multicast_join)
   TEST_ENTRY  (udp_multicast_join6)
   TEST_ENTRY  (udp_multicast_ttl)
   TEST_ENTRY  (udp_try_send)
+  TEST_ENTRY  (udp_try_send_batch)
 
   TEST_ENTRY  (udp_open)
   TEST_HELPER (udp_open, udp4_echo_server)
@@ -653,6 +727,10 @@ TASK_LIST_START
 
   TEST_ENTRY  (socket_buffer_size)
 
+  TEST_ENTRY  (read_size_mode_errors)
+  TEST_ENTRY  (read_size_mode_tcp_fionread)
+  TEST_ENTRY  (read_size_mode_udp_fionread)
+
   TEST_ENTRY  (spawn_fails)
 #ifndef _WIN32
   TEST_ENTRY  (spawn_fails_check_for_waitpid_cleanup)
@@ -718,6 +796,7 @@ TASK_LIST_START
   TEST_ENTRY  (fs_file_write_null_buffer)
   TEST_ENTRY  (fs_async_dir)
   TEST_ENTRY  (fs_async_sendfile)
+  TEST_ENTRY  (fs_copyfile)
   TEST_ENTRY  (fs_mkdtemp)
   TEST_ENTRY  (fs_fstat)
   TEST_ENTRY  (fs_access)
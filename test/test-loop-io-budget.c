@@ -0,0 +1,220 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#ifdef _WIN32
+
+TEST_IMPL(loop_io_budget) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+TEST_IMPL(loop_io_budget_accept) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define NUM_CLIENTS 40
+
+static uv_pipe_t pipes[2];
+static int fds[2][2];
+static char slab[1];
+static int read_cb_called[2];
+static uv_tcp_t server;
+static uv_tcp_t conns[NUM_CLIENTS];
+static int connection_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  /* One byte at a time so that every byte is a separate read callback. */
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  ASSERT(nread >= 0);
+  if (nread > 0)
+    read_cb_called[stream == (uv_stream_t*) &pipes[1]]++;
+}
+
+
+static void fill(int i, const char* data, size_t len) {
+  ASSERT((ssize_t) len == write(fds[i][1], data, len));
+}
+
+
+static void run_once(int expected0, int expected1) {
+  read_cb_called[0] = 0;
+  read_cb_called[1] = 0;
+  ASSERT(0 != uv_run(uv_default_loop(), UV_RUN_NOWAIT));
+  ASSERT(read_cb_called[0] == expected0);
+  ASSERT(read_cb_called[1] == expected1);
+}
+
+
+static int run_once_total(void) {
+  read_cb_called[0] = 0;
+  read_cb_called[1] = 0;
+  ASSERT(0 != uv_run(uv_default_loop(), UV_RUN_NOWAIT));
+  return read_cb_called[0] + read_cb_called[1];
+}
+
+
+TEST_IMPL(loop_io_budget) {
+  uv_loop_t* loop;
+  int i;
+
+  loop = uv_default_loop();
+
+  for (i = 0; i < 2; i++) {
+    ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+    ASSERT(0 == uv_pipe_init(loop, &pipes[i], 0));
+    ASSERT(0 == uv_pipe_open(&pipes[i], fds[i][0]));
+    ASSERT(0 == uv_read_start((uv_stream_t*) &pipes[i], alloc_cb, read_cb));
+  }
+
+  /* The default allows plenty of reads per handle and tick. */
+  fill(0, "abcd", 4);
+  run_once(4, 0);
+
+  /* At most two callbacks per handle and tick. */
+  ASSERT(0 == uv_loop_configure(loop,
+                                UV_LOOP_HANDLE_IO_BUDGET,
+                                2,
+                                (size_t) 0));
+  fill(0, "abcde", 5);
+  run_once(2, 0);
+  run_once(2, 0);
+  run_once(1, 0);
+
+  /* At most three bytes per handle and tick. */
+  ASSERT(0 == uv_loop_configure(loop,
+                                UV_LOOP_HANDLE_IO_BUDGET,
+                                0,
+                                (size_t) 3));
+  fill(0, "abcd", 4);
+  run_once(3, 0);
+  run_once(1, 0);
+
+  /* The loop-wide budget is shared, but every handle gets one callback. */
+  ASSERT(0 == uv_loop_configure(loop,
+                                UV_LOOP_ITERATION_IO_BUDGET,
+                                2,
+                                (size_t) 0));
+  fill(0, "abcd", 4);
+  fill(1, "abcd", 4);
+  ASSERT(3 == run_once_total());
+  ASSERT(3 == run_once_total());
+  ASSERT(2 == run_once_total());
+
+  for (i = 0; i < 2; i++) {
+    uv_close((uv_handle_t*) &pipes[i], NULL);
+    ASSERT(0 == close(fds[i][1]));
+  }
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+
+static void connection_cb(uv_stream_t* handle, int status) {
+  ASSERT(status == 0);
+  ASSERT(connection_cb_called < NUM_CLIENTS);
+  ASSERT(0 == uv_tcp_init(handle->loop, &conns[connection_cb_called]));
+  ASSERT(0 == uv_accept(handle,
+                        (uv_stream_t*) &conns[connection_cb_called]));
+  connection_cb_called++;
+}
+
+
+static void connect_clients(int* clients, const struct sockaddr_in* addr) {
+  int i;
+
+  for (i = 0; i < NUM_CLIENTS; i++) {
+    clients[i] = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT(clients[i] >= 0);
+    ASSERT(0 == connect(clients[i],
+                        (const struct sockaddr*) addr,
+                        sizeof(*addr)));
+  }
+}
+
+
+static void close_clients(int* clients) {
+  int i;
+
+  for (i = 0; i < NUM_CLIENTS; i++) {
+    ASSERT(0 == close(clients[i]));
+    uv_close((uv_handle_t*) &conns[i], NULL);
+  }
+}
+
+
+TEST_IMPL(loop_io_budget_accept) {
+  struct sockaddr_in addr;
+  int clients[NUM_CLIENTS];
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  /* By default the whole backlog is accepted in one tick. */
+  connect_clients(clients, &addr);
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+  ASSERT(connection_cb_called == NUM_CLIENTS);
+  close_clients(clients);
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+
+  /* An explicit handle budget applies to accepting too. */
+  ASSERT(0 == uv_loop_configure(loop,
+                                UV_LOOP_HANDLE_IO_BUDGET,
+                                16,
+                                (size_t) 0));
+  connection_cb_called = 0;
+  connect_clients(clients, &addr);
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+  ASSERT(connection_cb_called == 16);
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+  ASSERT(connection_cb_called == 32);
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+  ASSERT(connection_cb_called == NUM_CLIENTS);
+  close_clients(clients);
+
+  uv_close((uv_handle_t*) &server, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
@@ -0,0 +1,199 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#ifdef _WIN32
+
+TEST_IMPL(loop_memory_budget) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define BUDGET (64 * 1024)
+#define DATA_SIZE (128 * 1024)
+
+/* `reader` forwards everything it reads to `writer`, like a proxy would.
+ * The other end of `writer` isn't read at first, so the write queue of
+ * `writer` grows until the loop goes over its budget. It's read from the
+ * timer later on; reading it with a handle would make that handle the
+ * heaviest producer and get it throttled in turn.
+ */
+static uv_pipe_t reader;
+static uv_pipe_t writer;
+static uv_timer_t timer;
+static int source_fd;
+static int sink_fd;
+
+static size_t forwarded;
+static size_t drained;
+static int timer_cb_called;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = malloc(size);
+  buf->len = size;
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  free(req->data);
+  free(req);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  uv_write_t* req;
+  uv_buf_t wbuf;
+
+  ASSERT(nread >= 0);
+  if (nread == 0) {
+    free(buf->base);
+    return;
+  }
+
+  req = malloc(sizeof(*req));
+  ASSERT(req != NULL);
+  req->data = buf->base;
+  wbuf = uv_buf_init(buf->base, nread);
+  ASSERT(0 == uv_write(req, (uv_stream_t*) &writer, &wbuf, 1, write_cb));
+  forwarded += nread;
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  uv_loop_memory_stats_t stats;
+  char buf[4096];
+  ssize_t n;
+
+  ASSERT(0 == uv_loop_memory_stats(handle->loop, &stats));
+
+  switch (timer_cb_called++) {
+    case 0:
+      ASSERT(stats.budget == BUDGET);
+      ASSERT(stats.used == stats.stream_write_queued);
+      ASSERT(stats.used > BUDGET);
+      ASSERT(stats.throttled_streams == 1);
+      ASSERT(stats.throttle_count == 1);
+
+      /* The reader is throttled and must not pick this up yet. */
+      ASSERT(forwarded == DATA_SIZE);
+      ASSERT(4 == write(source_fd, "ping", 4));
+      return;
+
+    case 1:
+      ASSERT(stats.throttled_streams == 1);
+      ASSERT(forwarded == DATA_SIZE);
+      break;
+  }
+
+  /* Drain the other end of the writer. */
+  do {
+    n = read(sink_fd, buf, sizeof(buf));
+    if (n > 0)
+      drained += n;
+  } while (n > 0);
+  ASSERT(n == -1 && errno == EAGAIN);
+
+  if (drained < DATA_SIZE + 4)
+    return;
+
+  ASSERT(drained == DATA_SIZE + 4);
+  ASSERT(forwarded == DATA_SIZE + 4);
+  ASSERT(0 == uv_loop_memory_stats(handle->loop, &stats));
+  ASSERT(stats.throttled_streams == 0);
+
+  uv_close((uv_handle_t*) &reader, close_cb);
+  uv_close((uv_handle_t*) &writer, close_cb);
+  uv_close((uv_handle_t*) &timer, close_cb);
+}
+
+
+TEST_IMPL(loop_memory_budget) {
+  uv_loop_memory_stats_t stats;
+  uv_loop_t* loop;
+  char data[4096];
+  int sndbuf;
+  int a[2];
+  int b[2];
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_MEMORY_BUDGET, (size_t) BUDGET));
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, a));
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, b));
+  ASSERT(0 == uv_pipe_init(loop, &reader, 0));
+  ASSERT(0 == uv_pipe_init(loop, &writer, 0));
+  ASSERT(0 == uv_pipe_open(&reader, a[0]));
+  ASSERT(0 == uv_pipe_open(&writer, b[0]));
+  source_fd = a[1];
+  sink_fd = b[1];
+  ASSERT(0 == fcntl(sink_fd, F_SETFL, O_NONBLOCK));
+
+  /* Make the write queue of `writer` grow as soon as possible. */
+  sndbuf = 4096;
+  ASSERT(0 == uv_send_buffer_size((uv_handle_t*) &writer, &sndbuf));
+
+  /* Small writes, a single large one may not fit in the socket buffer. */
+  memset(data, 'x', sizeof(data));
+  for (i = 0; i < DATA_SIZE; i += sizeof(data))
+    ASSERT(sizeof(data) == write(source_fd, data, sizeof(data)));
+
+  ASSERT(0 == uv_read_start((uv_stream_t*) &reader, alloc_cb, read_cb));
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb, 50, 10));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(timer_cb_called > 2);
+  ASSERT(close_cb_called == 3);
+
+  ASSERT(0 == uv_loop_memory_stats(loop, &stats));
+  ASSERT(stats.used == 0);
+  ASSERT(stats.throttled_streams == 0);
+  ASSERT(stats.throttle_count == 1);
+
+  ASSERT(0 == close(source_fd));
+  ASSERT(0 == close(sink_fd));
+  ASSERT(0 == uv_loop_configure(loop, UV_LOOP_MEMORY_BUDGET, (size_t) 0));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
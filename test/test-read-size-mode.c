@@ -0,0 +1,225 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define PAYLOAD_SIZE 100
+#define NUM_DATAGRAMS 3
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t incoming;
+static uv_udp_t sender;
+static uv_udp_t receiver;
+static uv_connect_t connect_req;
+static uv_write_t write_req;
+static char payload[PAYLOAD_SIZE];
+static char slab[64 * 1024];
+static size_t last_suggested;
+static size_t read_sizes[NUM_DATAGRAMS];
+static int reads;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+  last_suggested = suggested_size;
+  buf->base = slab;
+  buf->len = suggested_size < sizeof(slab) ? suggested_size : sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread > 0) {
+    ASSERT(nread == PAYLOAD_SIZE);
+    read_sizes[reads++] = last_suggested;
+    return;
+  }
+
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == UV_EOF);
+  uv_close((uv_handle_t*) stream, close_cb);
+  uv_close((uv_handle_t*) &server, close_cb);
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+  buf = uv_buf_init(payload, sizeof(payload));
+  ASSERT(0 == uv_write(&write_req, req->handle, &buf, 1, write_cb));
+}
+
+
+static void connection_cb(uv_stream_t* stream, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(stream->loop, &incoming));
+  ASSERT(0 == uv_accept(stream, (uv_stream_t*) &incoming));
+  ASSERT(0 == uv_read_size_mode((uv_handle_t*) &incoming,
+                                UV_READ_SIZE_FIONREAD));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == PAYLOAD_SIZE);
+  ASSERT(flags == 0);
+  read_sizes[reads++] = last_suggested;
+
+  if (reads == NUM_DATAGRAMS) {
+    uv_close((uv_handle_t*) &receiver, close_cb);
+    uv_close((uv_handle_t*) &sender, close_cb);
+  }
+}
+
+
+TEST_IMPL(read_size_mode_errors) {
+  uv_timer_t timer;
+
+#ifdef _WIN32
+  RETURN_SKIP("Not supported on Windows.");
+#endif
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  ASSERT(UV_EINVAL == uv_read_size_mode((uv_handle_t*) &client, 4));
+  ASSERT(0 == uv_read_size_mode((uv_handle_t*) &client,
+                                UV_READ_SIZE_ADAPTIVE | UV_READ_SIZE_FIONREAD));
+  ASSERT(0 == uv_read_size_mode((uv_handle_t*) &client, 0));
+  uv_close((uv_handle_t*) &client, NULL);
+
+  /* Shrinking the buffer would truncate datagrams. */
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &receiver));
+  ASSERT(UV_EINVAL == uv_read_size_mode((uv_handle_t*) &receiver,
+                                        UV_READ_SIZE_ADAPTIVE));
+  ASSERT(UV_EINVAL == uv_read_size_mode((uv_handle_t*) &receiver,
+                                        UV_READ_SIZE_ADAPTIVE |
+                                        UV_READ_SIZE_FIONREAD));
+  ASSERT(0 == uv_read_size_mode((uv_handle_t*) &receiver,
+                                UV_READ_SIZE_FIONREAD));
+  uv_close((uv_handle_t*) &receiver, NULL);
+
+  ASSERT(0 == uv_timer_init(uv_default_loop(), &timer));
+  ASSERT(UV_EINVAL == uv_read_size_mode((uv_handle_t*) &timer,
+                                        UV_READ_SIZE_ADAPTIVE));
+  uv_close((uv_handle_t*) &timer, NULL);
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(read_size_mode_tcp_fionread) {
+  struct sockaddr_in addr;
+
+#ifdef _WIN32
+  RETURN_SKIP("Not supported on Windows.");
+#endif
+
+  ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(reads == 1);
+  /* Rounded up past the 100 pending bytes instead of the default 64 KiB. */
+  ASSERT(read_sizes[0] == 1024);
+  ASSERT(close_cb_called == 3);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(read_size_mode_udp_fionread) {
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+  int i;
+
+#ifdef _WIN32
+  RETURN_SKIP("Not supported on Windows.");
+#endif
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &receiver));
+  ASSERT(0 == uv_udp_bind(&receiver, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_read_size_mode((uv_handle_t*) &receiver,
+                                UV_READ_SIZE_FIONREAD));
+  ASSERT(0 == uv_udp_recv_start(&receiver, alloc_cb, recv_cb));
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &sender));
+  buf = uv_buf_init(payload, sizeof(payload));
+  for (i = 0; i < NUM_DATAGRAMS; i++)
+    ASSERT(PAYLOAD_SIZE == uv_udp_try_send(&sender,
+                                           &buf,
+                                           1,
+                                           (const struct sockaddr*) &addr));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(reads == NUM_DATAGRAMS);
+  /* Linux reports the size of the next datagram, other platforms the total
+   * of all pending datagrams. Either way the suggestion holds the datagram.
+   */
+  for (i = 0; i < NUM_DATAGRAMS; i++) {
+#if defined(__linux__)
+    ASSERT(read_sizes[i] == 1024);
+#endif
+    ASSERT(read_sizes[i] >= PAYLOAD_SIZE);
+  }
+  ASSERT(close_cb_called == 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,297 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#define NUM_LISTENERS 2
+#define NUM_CLIENTS 8
+
+static uv_tcp_t listeners[NUM_LISTENERS];
+static uv_tcp_t clients[NUM_CLIENTS];
+static uv_tcp_t conns[NUM_CLIENTS];
+static uv_connect_t connect_reqs[NUM_CLIENTS];
+static uv_udp_t udp_handles[NUM_LISTENERS + 1];
+static int connection_cb_called;
+static int connect_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+}
+
+
+static void connection_cb(uv_stream_t* server, int status) {
+  uv_tcp_t* conn;
+  int i;
+
+  ASSERT(status == 0);
+
+  conn = &conns[connection_cb_called++];
+  ASSERT(0 == uv_tcp_init(server->loop, conn));
+  ASSERT(0 == uv_accept(server, (uv_stream_t*) conn));
+  uv_close((uv_handle_t*) conn, close_cb);
+
+  if (connection_cb_called == NUM_CLIENTS)
+    for (i = 0; i < NUM_LISTENERS; i++)
+      uv_close((uv_handle_t*) &listeners[i], close_cb);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  connect_cb_called++;
+  uv_close((uv_handle_t*) req->handle, close_cb);
+}
+
+
+static int tcp_reuseport(unsigned int flags, int port) {
+  struct sockaddr_in addr;
+  uv_tcp_t other;
+  uv_loop_t* loop;
+  int r;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", port, &addr));
+
+  for (i = 0; i < NUM_LISTENERS; i++) {
+    ASSERT(0 == uv_tcp_init(loop, &listeners[i]));
+    r = uv_tcp_bind(&listeners[i], (const struct sockaddr*) &addr, flags);
+    if (r == UV_ENOTSUP) {
+      uv_close((uv_handle_t*) &listeners[i], NULL);
+      return r;
+    }
+    ASSERT(r == 0);
+    ASSERT(0 == uv_listen((uv_stream_t*) &listeners[i], 128, connection_cb));
+  }
+
+  /* A socket without the flag can't join the group. */
+  ASSERT(0 == uv_tcp_init(loop, &other));
+  ASSERT(0 == uv_tcp_bind(&other, (const struct sockaddr*) &addr, 0));
+  ASSERT(UV_EADDRINUSE == uv_listen((uv_stream_t*) &other, 128, NULL));
+  uv_close((uv_handle_t*) &other, NULL);
+
+  connection_cb_called = 0;
+  connect_cb_called = 0;
+  for (i = 0; i < NUM_CLIENTS; i++) {
+    ASSERT(0 == uv_tcp_init(loop, &clients[i]));
+    ASSERT(0 == uv_tcp_connect(&connect_reqs[i],
+                               &clients[i],
+                               (const struct sockaddr*) &addr,
+                               connect_cb));
+  }
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(connect_cb_called == NUM_CLIENTS);
+  ASSERT(connection_cb_called == NUM_CLIENTS);
+
+  return 0;
+}
+
+
+TEST_IMPL(tcp_reuseport) {
+  int r;
+
+  r = tcp_reuseport(UV_TCP_REUSEPORT, TEST_PORT);
+  if (r == UV_ENOTSUP)
+    RETURN_SKIP("SO_REUSEPORT is not supported on this platform.");
+
+  /* Not every platform can steer connections by CPU. */
+  r = tcp_reuseport(UV_TCP_REUSEPORT_CPU, TEST_PORT_2);
+  ASSERT(r == 0 || r == UV_ENOTSUP);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static int udp_reuseport(unsigned int flags, int port) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  int r;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", port, &addr));
+
+  for (i = 0; i < NUM_LISTENERS + 1; i++)
+    ASSERT(0 == uv_udp_init(loop, &udp_handles[i]));
+
+  r = 0;
+  for (i = 0; i < NUM_LISTENERS; i++) {
+    r = uv_udp_bind(&udp_handles[i], (const struct sockaddr*) &addr, flags);
+    if (r != 0)
+      break;
+  }
+
+  if (r == 0)
+    ASSERT(UV_EADDRINUSE == uv_udp_bind(&udp_handles[NUM_LISTENERS],
+                                        (const struct sockaddr*) &addr,
+                                        0));
+
+  for (i = 0; i < NUM_LISTENERS + 1; i++)
+    uv_close((uv_handle_t*) &udp_handles[i], NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  return r;
+}
+
+
+TEST_IMPL(udp_reuseport) {
+  int r;
+
+  r = udp_reuseport(UV_UDP_REUSEPORT, TEST_PORT);
+  if (r == UV_ENOTSUP)
+    RETURN_SKIP("SO_REUSEPORT is not supported on this platform.");
+  ASSERT(r == 0);
+
+  r = udp_reuseport(UV_UDP_REUSEPORT_CPU, TEST_PORT_2);
+  ASSERT(r == 0 || r == UV_ENOTSUP);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#define NUM_FLOWS 32
+
+static uv_udp_t flows[NUM_FLOWS];
+static int shard_received[NUM_LISTENERS];
+static int group_received;
+
+
+static void group_alloc_cb(uv_handle_t* handle,
+                           size_t suggested_size,
+                           uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void group_recv_cb(uv_udp_t* handle,
+                          ssize_t nread,
+                          const uv_buf_t* buf,
+                          const struct sockaddr* addr,
+                          unsigned flags) {
+  ASSERT(nread >= 0);
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == 4);
+  shard_received[handle - udp_handles]++;
+  group_received++;
+}
+
+
+TEST_IMPL(udp_bind_group) {
+  uv_udp_t* handles[NUM_LISTENERS];
+  uv_loop_t* loops[NUM_LISTENERS];
+  struct sockaddr_in addr;
+  struct sockaddr_in name;
+  uv_loop_t loop;
+  uv_buf_t buf;
+  int namelen;
+  int r;
+  int i;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  loops[0] = uv_default_loop();
+  loops[1] = &loop;
+  for (i = 0; i < NUM_LISTENERS; i++)
+    handles[i] = &udp_handles[i];
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", 0, &addr));
+  ASSERT(UV_EINVAL == uv_udp_bind_group(loops,
+                                        handles,
+                                        0,
+                                        (const struct sockaddr*) &addr,
+                                        0));
+  ASSERT(UV_EINVAL == uv_udp_bind_group(loops,
+                                        handles,
+                                        NUM_LISTENERS,
+                                        (const struct sockaddr*) &addr,
+                                        UV_UDP_REUSEADDR));
+
+  r = uv_udp_bind_group(loops,
+                        handles,
+                        NUM_LISTENERS,
+                        (const struct sockaddr*) &addr,
+                        0);
+  if (r == UV_ENOTSUP) {
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+    uv_run(&loop, UV_RUN_DEFAULT);
+    ASSERT(0 == uv_loop_close(&loop));
+    RETURN_SKIP("SO_REUSEPORT is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+  ASSERT(udp_handles[0].loop == uv_default_loop());
+  ASSERT(udp_handles[1].loop == &loop);
+
+  /* Port 0 picked one port for the whole group. */
+  namelen = sizeof(addr);
+  ASSERT(0 == uv_udp_getsockname(&udp_handles[0],
+                                 (struct sockaddr*) &addr,
+                                 &namelen));
+  ASSERT(addr.sin_port != 0);
+  namelen = sizeof(name);
+  ASSERT(0 == uv_udp_getsockname(&udp_handles[1],
+                                 (struct sockaddr*) &name,
+                                 &namelen));
+  ASSERT(name.sin_port == addr.sin_port);
+
+  for (i = 0; i < NUM_LISTENERS; i++)
+    ASSERT(0 == uv_udp_recv_start(&udp_handles[i],
+                                  group_alloc_cb,
+                                  group_recv_cb));
+
+  /* Every flow has its own source port, the kernel hashes them over the
+   * group.
+   */
+  buf = uv_buf_init("PING", 4);
+  for (i = 0; i < NUM_FLOWS; i++) {
+    ASSERT(0 == uv_udp_init(uv_default_loop(), &flows[i]));
+    ASSERT(4 == uv_udp_try_send(&flows[i],
+                                &buf,
+                                1,
+                                (const struct sockaddr*) &addr));
+  }
+
+  while (group_received < NUM_FLOWS) {
+    uv_run(uv_default_loop(), UV_RUN_NOWAIT);
+    uv_run(&loop, UV_RUN_NOWAIT);
+  }
+
+  ASSERT(group_received == NUM_FLOWS);
+  for (i = 0; i < NUM_LISTENERS; i++)
+    ASSERT(shard_received[i] > 0);
+
+  for (i = 0; i < NUM_FLOWS; i++)
+    uv_close((uv_handle_t*) &flows[i], NULL);
+  for (i = 0; i < NUM_LISTENERS; i++)
+    uv_close((uv_handle_t*) &udp_handles[i], NULL);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
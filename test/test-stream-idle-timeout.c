@@ -0,0 +1,167 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#ifdef _WIN32
+
+TEST_IMPL(stream_idle_timeout) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define TIMEOUT 100
+#define NUM_WRITES 5
+#define WRITE_INTERVAL 40
+#define NUM_IDLE 3
+
+/* `reader` gets a byte from `writer` every WRITE_INTERVAL ms, which keeps it
+ * from timing out until the writes stop. The `idle` streams never see any
+ * data and time out together. `disabled` has its timeout removed again.
+ */
+static uv_pipe_t reader;
+static uv_pipe_t writer;
+static uv_pipe_t idle[NUM_IDLE];
+static uv_pipe_t disabled;
+static uv_timer_t timer;
+static uv_write_t write_reqs[NUM_WRITES];
+static char byte = 'x';
+static char slab[64];
+static uint64_t last_write;
+static int writes;
+static int reader_timeout_cb_called;
+static int idle_timeout_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  ASSERT(nread >= 0);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init(&byte, 1);
+  ASSERT(0 == uv_write(&write_reqs[writes++],
+                       (uv_stream_t*) &writer,
+                       &buf,
+                       1,
+                       NULL));
+  last_write = uv_now(handle->loop);
+
+  if (writes == NUM_WRITES)
+    uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+static void reader_timeout_cb(uv_stream_t* stream) {
+  ASSERT(stream == (uv_stream_t*) &reader);
+  ASSERT(writes == NUM_WRITES);
+  ASSERT(uv_now(stream->loop) - last_write >= TIMEOUT);
+  reader_timeout_cb_called++;
+
+  uv_close((uv_handle_t*) &reader, NULL);
+  uv_close((uv_handle_t*) &writer, NULL);
+  uv_close((uv_handle_t*) &disabled, NULL);
+}
+
+
+static void idle_timeout_cb(uv_stream_t* stream) {
+  ASSERT(writes < NUM_WRITES);
+  idle_timeout_cb_called++;
+  uv_close((uv_handle_t*) stream, NULL);
+}
+
+
+static void disabled_timeout_cb(uv_stream_t* stream) {
+  ASSERT(0 && "should not have been called");
+}
+
+
+static void open_pipes(uv_loop_t* loop, uv_pipe_t* a, uv_pipe_t* b) {
+  int fds[2];
+
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, a, 0));
+  ASSERT(0 == uv_pipe_open(a, fds[0]));
+  if (b == NULL) {
+    ASSERT(0 == close(fds[1]));
+    return;
+  }
+  ASSERT(0 == uv_pipe_init(loop, b, 0));
+  ASSERT(0 == uv_pipe_open(b, fds[1]));
+}
+
+
+TEST_IMPL(stream_idle_timeout) {
+  uv_loop_t* loop;
+  int i;
+
+  loop = uv_default_loop();
+
+  open_pipes(loop, &reader, &writer);
+  ASSERT(0 == uv_read_start((uv_stream_t*) &reader, alloc_cb, read_cb));
+  ASSERT(0 == uv_stream_set_idle_timeout((uv_stream_t*) &reader,
+                                         TIMEOUT,
+                                         reader_timeout_cb));
+
+  for (i = 0; i < NUM_IDLE; i++) {
+    open_pipes(loop, &idle[i], NULL);
+    ASSERT(0 == uv_stream_set_idle_timeout((uv_stream_t*) &idle[i],
+                                           TIMEOUT,
+                                           idle_timeout_cb));
+  }
+
+  open_pipes(loop, &disabled, NULL);
+  ASSERT(UV_EINVAL == uv_stream_set_idle_timeout((uv_stream_t*) &disabled,
+                                                 TIMEOUT,
+                                                 NULL));
+  ASSERT(0 == uv_stream_set_idle_timeout((uv_stream_t*) &disabled,
+                                         TIMEOUT / 2,
+                                         disabled_timeout_cb));
+  ASSERT(0 == uv_stream_set_idle_timeout((uv_stream_t*) &disabled, 0, NULL));
+
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer,
+                             timer_cb,
+                             WRITE_INTERVAL,
+                             WRITE_INTERVAL));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(reader_timeout_cb_called == 1);
+  ASSERT(idle_timeout_cb_called == NUM_IDLE);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
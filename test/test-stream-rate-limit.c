@@ -0,0 +1,205 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#ifdef _WIN32
+
+TEST_IMPL(stream_rate_limit) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+TEST_IMPL(tcp_rate_limit) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define RATE (1024 * 1024)
+#define BURST (64 * 1024)
+#define DATA_SIZE (512 * 1024)
+
+/* The time that it must take at least to send DATA_SIZE bytes through the
+ * token bucket, in ms. The full bucket goes out right away.
+ */
+#define MIN_TIME ((DATA_SIZE - BURST) * 1000 / RATE - 50)
+
+static uv_tcp_t server;
+static uv_stream_t* writer;
+static uv_stream_t* reader;
+static uv_write_t write_req;
+static uv_connect_t connect_req;
+static uv_tcp_t tcp_client;
+static uv_tcp_t tcp_conn;
+static uv_pipe_t pipe_writer;
+static uv_pipe_t pipe_reader;
+
+static char data[DATA_SIZE];
+static size_t nread_total;
+static uint64_t start_time;
+static uint64_t end_time;
+static int write_cb_called;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  ASSERT(nread >= 0);
+  nread_total += nread;
+  if (nread_total < DATA_SIZE)
+    return;
+
+  ASSERT(nread_total == DATA_SIZE);
+  end_time = uv_hrtime();
+  uv_close((uv_handle_t*) stream, close_cb);
+  uv_close((uv_handle_t*) writer, close_cb);
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  write_cb_called++;
+}
+
+
+static void start_writing(void) {
+  uv_buf_t buf;
+
+  ASSERT(0 == uv_stream_set_rate_limit(writer, RATE, BURST));
+  ASSERT(0 == uv_read_start(reader, alloc_cb, read_cb));
+
+  start_time = uv_hrtime();
+  buf = uv_buf_init(data, sizeof(data));
+  ASSERT(0 == uv_write(&write_req, writer, &buf, 1, write_cb));
+}
+
+
+static void check_paced(uv_tcp_t* handle) {
+#if defined(SO_MAX_PACING_RATE)
+  unsigned int val;
+  socklen_t len;
+  uv_os_fd_t fd;
+
+  len = sizeof(val);
+  ASSERT(0 == uv_fileno((uv_handle_t*) handle, &fd));
+  ASSERT(0 == getsockopt(fd, SOL_SOCKET, SO_MAX_PACING_RATE, &val, &len));
+  ASSERT(val == RATE);
+#endif
+}
+
+
+TEST_IMPL(stream_rate_limit) {
+  uv_loop_t* loop;
+  int fds[2];
+
+  loop = uv_default_loop();
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_writer, 0));
+  ASSERT(0 == uv_pipe_init(loop, &pipe_reader, 0));
+  ASSERT(0 == uv_pipe_open(&pipe_writer, fds[0]));
+  ASSERT(0 == uv_pipe_open(&pipe_reader, fds[1]));
+
+  writer = (uv_stream_t*) &pipe_writer;
+  reader = (uv_stream_t*) &pipe_reader;
+
+  /* Not a socket that the kernel can pace, the token bucket applies. */
+  start_writing();
+
+  /* No more than a bucket goes out right away. */
+  ASSERT(pipe_writer.write_queue_size >= DATA_SIZE - BURST);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == 2);
+  ASSERT(nread_total == DATA_SIZE);
+  ASSERT(write_cb_called == 1);
+  ASSERT((end_time - start_time) / 1000000 >= MIN_TIME);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void connection_cb(uv_stream_t* handle, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(handle->loop, &tcp_conn));
+  ASSERT(0 == uv_accept(handle, (uv_stream_t*) &tcp_conn));
+  uv_close((uv_handle_t*) handle, close_cb);
+
+  reader = (uv_stream_t*) &tcp_conn;
+  start_writing();
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  check_paced((uv_tcp_t*) req->handle);
+}
+
+
+TEST_IMPL(tcp_rate_limit) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  /* Set before the socket exists. The kernel paces the socket where it can,
+   * which can't be timed here: the first segments go out unpaced and they
+   * are huge on the loopback interface.
+   */
+  ASSERT(0 == uv_tcp_init(loop, &tcp_client));
+  writer = (uv_stream_t*) &tcp_client;
+  ASSERT(0 == uv_stream_set_rate_limit(writer, RATE, BURST));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &tcp_client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == 3);
+  ASSERT(nread_total == DATA_SIZE);
+  ASSERT(write_cb_called == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
@@ -0,0 +1,193 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#ifdef _WIN32
+
+TEST_IMPL(stream_watermarks) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HIGH_WATERMARK (64 * 1024)
+#define LOW_WATERMARK (16 * 1024)
+#define DATA_SIZE (4 * 1024 * 1024)
+
+/* `writer` writes to `drainer`, which doesn't read until the timer fires.
+ * `reader` is paired with `writer` and must not see its data until the
+ * write queue of `writer` drained.
+ */
+static uv_pipe_t writer;
+static uv_pipe_t drainer;
+static uv_pipe_t reader;
+static uv_timer_t timer;
+static uv_write_t write_req;
+static uv_write_t write_req2;
+
+static char data[DATA_SIZE];
+static size_t drained;
+static int drain_cb_called;
+static int write_cb_called;
+static int reader_read_cb_called;
+static int timer_cb_called;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void drainer_read_cb(uv_stream_t* stream,
+                            ssize_t nread,
+                            const uv_buf_t* buf) {
+  ASSERT(nread > 0);
+  drained += nread;
+  if (drained == DATA_SIZE + 1)
+    uv_close((uv_handle_t*) stream, close_cb);
+}
+
+
+static void reader_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* buf) {
+  ASSERT(nread == 4);
+  ASSERT(0 == memcmp(buf->base, "ping", 4));
+  ASSERT(drain_cb_called == 1);
+  reader_read_cb_called++;
+  uv_close((uv_handle_t*) stream, close_cb);
+}
+
+
+static void maybe_close_writer(void) {
+  if (write_cb_called == 2 && drain_cb_called == 1)
+    uv_close((uv_handle_t*) &writer, close_cb);
+}
+
+
+static void drain_cb(uv_stream_t* handle) {
+  ASSERT(handle == (uv_stream_t*) &writer);
+  ASSERT(handle->write_queue_size <= LOW_WATERMARK);
+  ASSERT(0 == uv_stream_is_above_watermark(handle));
+  ASSERT(reader_read_cb_called == 0);
+  drain_cb_called++;
+  maybe_close_writer();
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  write_cb_called++;
+  maybe_close_writer();
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  /* Reading is paused while the writer is above its high watermark. */
+  ASSERT(reader_read_cb_called == 0);
+  ASSERT(drain_cb_called == 0);
+  ASSERT(0 == uv_read_start((uv_stream_t*) &drainer,
+                            alloc_cb,
+                            drainer_read_cb));
+  timer_cb_called++;
+}
+
+
+TEST_IMPL(stream_watermarks) {
+  uv_loop_t* loop;
+  uv_buf_t buf;
+  int a[2];
+  int b[2];
+
+  loop = uv_default_loop();
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, a));
+  ASSERT(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, b));
+
+  ASSERT(0 == uv_pipe_init(loop, &writer, 0));
+  ASSERT(0 == uv_pipe_init(loop, &drainer, 0));
+  ASSERT(0 == uv_pipe_init(loop, &reader, 0));
+  ASSERT(0 == uv_pipe_open(&writer, a[0]));
+  ASSERT(0 == uv_pipe_open(&drainer, a[1]));
+  ASSERT(0 == uv_pipe_open(&reader, b[0]));
+
+  ASSERT(UV_EINVAL == uv_stream_set_watermarks((uv_stream_t*) &writer,
+                                               LOW_WATERMARK,
+                                               LOW_WATERMARK,
+                                               drain_cb));
+  ASSERT(0 == uv_stream_set_watermarks((uv_stream_t*) &writer,
+                                       HIGH_WATERMARK,
+                                       LOW_WATERMARK,
+                                       drain_cb));
+  ASSERT(UV_EINVAL == uv_stream_set_peer((uv_stream_t*) &writer,
+                                         (uv_stream_t*) &writer));
+  ASSERT(0 == uv_stream_set_peer((uv_stream_t*) &writer,
+                                 (uv_stream_t*) &reader));
+
+  ASSERT(0 == uv_read_start((uv_stream_t*) &reader, alloc_cb, reader_read_cb));
+  ASSERT(4 == write(b[1], "ping", 4));
+
+  /* More than the socket buffer holds, the rest stays queued. */
+  ASSERT(0 == uv_stream_is_above_watermark((uv_stream_t*) &writer));
+  buf = uv_buf_init(data, sizeof(data));
+  ASSERT(0 == uv_write(&write_req, (uv_stream_t*) &writer, &buf, 1, write_cb));
+  ASSERT(writer.write_queue_size >= HIGH_WATERMARK);
+  ASSERT(1 == uv_stream_is_above_watermark((uv_stream_t*) &writer));
+
+  /* Still reported until the drain callback ran. */
+  buf = uv_buf_init(data, 1);
+  ASSERT(0 == uv_write(&write_req2, (uv_stream_t*) &writer, &buf, 1, write_cb));
+  ASSERT(1 == uv_stream_is_above_watermark((uv_stream_t*) &writer));
+
+  ASSERT(0 == uv_timer_init(loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb, 50, 0));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(timer_cb_called == 1);
+  ASSERT(drain_cb_called == 1);
+  ASSERT(write_cb_called == 2);
+  ASSERT(reader_read_cb_called == 1);
+  ASSERT(drained == DATA_SIZE + 1);
+  ASSERT(close_cb_called == 3);
+
+  ASSERT(0 == close(b[1]));
+  uv_close((uv_handle_t*) &timer, NULL);
+  uv_run(loop, UV_RUN_DEFAULT);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
@@ -0,0 +1,248 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+
+TEST_IMPL(tcp_accept_group) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+TEST_IMPL(tcp_accept_group_least_connections) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#define NUM_WORKERS 2
+#define NUM_CLIENTS 8
+
+typedef struct {
+  uv_thread_t thread;
+  uv_tcp_t handle;
+  int connections;
+} worker_t;
+
+static uv_accept_group_t group;
+static uv_sem_t workers_ready;
+static worker_t workers[NUM_WORKERS];
+static uv_tcp_t server;
+static uv_async_t workers_done;
+static uv_tcp_t clients[NUM_CLIENTS];
+static uv_connect_t connect_reqs[NUM_CLIENTS];
+static struct sockaddr_in addr;
+static int connect_cb_called;
+static int num_clients;
+static int keep;
+
+
+static void close_free_cb(uv_handle_t* handle) {
+  free(handle);
+}
+
+
+static void worker_connection_cb(uv_stream_t* handle, int status) {
+  worker_t* worker;
+  uv_tcp_t* conn;
+
+  ASSERT(status == 0);
+  worker = container_of(handle, worker_t, handle);
+
+  conn = malloc(sizeof(*conn));
+  ASSERT(conn != NULL);
+  ASSERT(0 == uv_tcp_init(handle->loop, conn));
+  ASSERT(0 == uv_accept(handle, (uv_stream_t*) conn));
+  worker->connections++;
+  uv_close((uv_handle_t*) conn, close_free_cb);
+
+  if (worker->connections == NUM_CLIENTS / NUM_WORKERS) {
+    uv_close((uv_handle_t*) handle, NULL);
+    ASSERT(0 == uv_async_send(&workers_done));
+  }
+}
+
+
+/* A connection can complete before the server accepts it, wait for the
+ * workers to have them all before closing the server.
+ */
+static void workers_done_cb(uv_async_t* handle) {
+  int i;
+
+  for (i = 0; i < NUM_WORKERS; i++)
+    if (workers[i].connections != NUM_CLIENTS / NUM_WORKERS)
+      return;
+
+  uv_close((uv_handle_t*) &server, NULL);
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+static void worker_thread(void* arg) {
+  worker_t* worker;
+  uv_loop_t loop;
+
+  worker = arg;
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_tcp_init(&loop, &worker->handle));
+  ASSERT(0 == uv_accept_group_join(&group,
+                                   &worker->handle,
+                                   worker_connection_cb));
+  uv_sem_post(&workers_ready);
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  uv_close((uv_handle_t*) req->handle, NULL);
+  connect_cb_called++;
+}
+
+
+static void start_server(uv_loop_t* loop) {
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_accept_group_listen(&group, &server, 128));
+}
+
+
+static void connect_client(uv_loop_t* loop, int i) {
+  ASSERT(0 == uv_tcp_init(loop, &clients[i]));
+  ASSERT(0 == uv_tcp_connect(&connect_reqs[i],
+                             &clients[i],
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+}
+
+
+TEST_IMPL(tcp_accept_group) {
+  uv_loop_t* loop;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_accept_group_init(&group, 0));
+  ASSERT(0 == uv_sem_init(&workers_ready, 0));
+  ASSERT(0 == uv_async_init(loop, &workers_done, workers_done_cb));
+
+  for (i = 0; i < NUM_WORKERS; i++) {
+    ASSERT(0 == uv_thread_create(&workers[i].thread,
+                                 worker_thread,
+                                 &workers[i]));
+    uv_sem_wait(&workers_ready);
+  }
+
+  start_server(loop);
+  for (i = 0; i < NUM_CLIENTS; i++)
+    connect_client(loop, i);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(connect_cb_called == NUM_CLIENTS);
+
+  /* Round-robin gives each worker the same share. */
+  for (i = 0; i < NUM_WORKERS; i++) {
+    ASSERT(0 == uv_thread_join(&workers[i].thread));
+    ASSERT(workers[i].connections == NUM_CLIENTS / NUM_WORKERS);
+  }
+
+  uv_sem_destroy(&workers_ready);
+  uv_accept_group_destroy(&group);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void lc_connection_cb(uv_stream_t* handle, int status) {
+  worker_t* worker;
+  uv_tcp_t* conn;
+
+  ASSERT(status == 0);
+  worker = container_of(handle, worker_t, handle);
+
+  conn = malloc(sizeof(*conn));
+  ASSERT(conn != NULL);
+  ASSERT(0 == uv_tcp_init(handle->loop, conn));
+  ASSERT(0 == uv_accept(handle, (uv_stream_t*) conn));
+  worker->connections++;
+
+  /* The first worker hangs up right away, the second one keeps them. */
+  if (worker == &workers[0])
+    uv_close((uv_handle_t*) conn, close_free_cb);
+  else
+    conn->data = &keep;
+
+  if (num_clients < NUM_CLIENTS)
+    connect_client(handle->loop, num_clients++);
+}
+
+
+static void lc_close_walk_cb(uv_handle_t* handle, void* arg) {
+  if (handle->data == &keep)
+    uv_close(handle, close_free_cb);
+}
+
+
+TEST_IMPL(tcp_accept_group_least_connections) {
+  uv_loop_t* loop;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_accept_group_init(&group,
+                                   UV_ACCEPT_GROUP_LEAST_CONNECTIONS));
+
+  for (i = 0; i < NUM_WORKERS; i++) {
+    ASSERT(0 == uv_tcp_init(loop, &workers[i].handle));
+    ASSERT(0 == uv_accept_group_join(&group,
+                                     &workers[i].handle,
+                                     lc_connection_cb));
+  }
+
+  /* Connect one client at a time so that the counts are exact. */
+  start_server(loop);
+  connect_client(loop, num_clients++);
+
+  while (connect_cb_called < NUM_CLIENTS ||
+         workers[0].connections + workers[1].connections < NUM_CLIENTS)
+    ASSERT(0 != uv_run(loop, UV_RUN_ONCE));
+
+  ASSERT(workers[0].connections == NUM_CLIENTS - 1);
+  ASSERT(workers[1].connections == 1);
+
+  uv_walk(loop, lc_close_walk_cb, NULL);
+  uv_close((uv_handle_t*) &server, NULL);
+  for (i = 0; i < NUM_WORKERS; i++)
+    uv_close((uv_handle_t*) &workers[i].handle, NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  uv_accept_group_destroy(&group);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
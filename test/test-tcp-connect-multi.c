@@ -0,0 +1,187 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+
+TEST_IMPL(tcp_connect_multi) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+TEST_IMPL(tcp_connect_multi_error) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+TEST_IMPL(tcp_connect_multi_close) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+/* Documentation addresses, connecting to them never completes. */
+#define BLACKHOLE_ADDR4 "192.0.2.1"
+#define BLACKHOLE_ADDR6 "100::1"
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t conn;
+static uv_connect_t connect_req;
+static struct sockaddr_in6 addr6;
+static struct sockaddr_in addr4;
+static struct addrinfo ai[2];
+static int connection_cb_called;
+static int connect_cb_called;
+static int connect_status;
+
+
+static void init_addrinfo(struct addrinfo* info,
+                          const struct sockaddr* addr,
+                          struct addrinfo* next) {
+  memset(info, 0, sizeof(*info));
+  info->ai_family = addr->sa_family;
+  info->ai_socktype = SOCK_STREAM;
+  info->ai_protocol = IPPROTO_TCP;
+  info->ai_addr = (struct sockaddr*) addr;
+  if (addr->sa_family == AF_INET6)
+    info->ai_addrlen = sizeof(struct sockaddr_in6);
+  else
+    info->ai_addrlen = sizeof(struct sockaddr_in);
+  info->ai_next = next;
+}
+
+
+static void connection_cb(uv_stream_t* handle, int status) {
+  ASSERT(status == 0);
+  connection_cb_called++;
+  ASSERT(0 == uv_tcp_init(handle->loop, &conn));
+  ASSERT(0 == uv_accept(handle, (uv_stream_t*) &conn));
+  uv_close((uv_handle_t*) &conn, NULL);
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  connect_cb_called++;
+  connect_status = status;
+
+  if (status == 0) {
+    struct sockaddr_storage peer;
+    int len;
+
+    /* The IPv4 attempt won. */
+    len = sizeof(peer);
+    ASSERT(0 == uv_tcp_getpeername((uv_tcp_t*) req->handle,
+                                   (struct sockaddr*) &peer,
+                                   &len));
+    ASSERT(peer.ss_family == AF_INET);
+    ASSERT(((struct sockaddr_in*) &peer)->sin_port == addr4.sin_port);
+  }
+
+  if (!uv_is_closing((uv_handle_t*) req->handle))
+    uv_close((uv_handle_t*) req->handle, NULL);
+}
+
+
+TEST_IMPL(tcp_connect_multi) {
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip6_addr(BLACKHOLE_ADDR6, TEST_PORT, &addr6));
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr4));
+  init_addrinfo(&ai[0], (const struct sockaddr*) &addr6, &ai[1]);
+  init_addrinfo(&ai[1], (const struct sockaddr*) &addr4, NULL);
+
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr4, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_tcp_init(loop, &client));
+  ASSERT(0 == uv_tcp_connect_multi(&connect_req, &client, ai, connect_cb));
+  ASSERT(UV_EALREADY == uv_tcp_connect_multi(&connect_req,
+                                             &client,
+                                             ai,
+                                             connect_cb));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(connect_cb_called == 1);
+  ASSERT(connect_status == 0);
+  ASSERT(connection_cb_called == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(tcp_connect_multi_error) {
+  uv_loop_t* loop;
+
+  /* Nothing listens on either address. */
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip6_addr("::1", TEST_PORT, &addr6));
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr4));
+  init_addrinfo(&ai[0], (const struct sockaddr*) &addr6, &ai[1]);
+  init_addrinfo(&ai[1], (const struct sockaddr*) &addr4, NULL);
+
+  ASSERT(0 == uv_tcp_init(loop, &client));
+  ASSERT(UV_EINVAL == uv_tcp_connect_multi(&connect_req,
+                                           &client,
+                                           NULL,
+                                           connect_cb));
+  ASSERT(0 == uv_tcp_connect_multi(&connect_req, &client, ai, connect_cb));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(connect_cb_called == 1);
+  ASSERT(connect_status == UV_ECONNREFUSED);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(tcp_connect_multi_close) {
+  uv_loop_t* loop;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip6_addr(BLACKHOLE_ADDR6, TEST_PORT, &addr6));
+  ASSERT(0 == uv_ip4_addr(BLACKHOLE_ADDR4, TEST_PORT, &addr4));
+  init_addrinfo(&ai[0], (const struct sockaddr*) &addr6, &ai[1]);
+  init_addrinfo(&ai[1], (const struct sockaddr*) &addr4, NULL);
+
+  ASSERT(0 == uv_tcp_init(loop, &client));
+  ASSERT(0 == uv_tcp_connect_multi(&connect_req, &client, ai, connect_cb));
+
+  /* Closing the handle cancels the attempts that are still running. */
+  ASSERT(0 != uv_run(loop, UV_RUN_NOWAIT));
+  uv_close((uv_handle_t*) &client, NULL);
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(connect_cb_called == 1);
+  ASSERT(connect_status == UV_ECANCELED);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
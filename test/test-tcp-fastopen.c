@@ -0,0 +1,165 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define NUM_ROUNDS 3
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t conn;
+static uv_connect_t connect_req;
+static uv_write_t write_req;
+static struct sockaddr_in addr;
+static char buf[64];
+static size_t nread_total;
+static int connect_cb_called;
+static int write_cb_called;
+static int conn_close_cb_called;
+static int client_close_cb_called;
+
+
+static void connect_client(void);
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* b) {
+  b->base = buf + nread_total;
+  b->len = sizeof(buf) - nread_total;
+}
+
+
+static void conn_close_cb(uv_handle_t* handle) {
+  conn_close_cb_called++;
+}
+
+
+static void conn_read_cb(uv_stream_t* stream,
+                         ssize_t nread,
+                         const uv_buf_t* b) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread > 0);
+  nread_total += nread;
+  if (nread_total < 4)
+    return;
+
+  ASSERT(nread_total == 4);
+  ASSERT(0 == memcmp(buf, "PING", 4));
+  uv_close((uv_handle_t*) stream, conn_close_cb);
+}
+
+
+static void connection_cb(uv_stream_t* handle, int status) {
+  ASSERT(status == 0);
+  nread_total = 0;
+  ASSERT(0 == uv_tcp_init(handle->loop, &conn));
+  ASSERT(0 == uv_accept(handle, (uv_stream_t*) &conn));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &conn, alloc_cb, conn_read_cb));
+}
+
+
+static void client_close_cb(uv_handle_t* handle) {
+  client_close_cb_called++;
+
+  if (client_close_cb_called < NUM_ROUNDS)
+    connect_client();
+  else
+    uv_close((uv_handle_t*) &server, NULL);
+}
+
+
+static void client_read_cb(uv_stream_t* stream,
+                           ssize_t nread,
+                           const uv_buf_t* b) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == UV_EOF);
+  uv_close((uv_handle_t*) stream, client_close_cb);
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  write_cb_called++;
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t b;
+
+  ASSERT(status == 0);
+  connect_cb_called++;
+
+  /* Goes out with the SYN once the kernel has a cookie for the server. */
+  b = uv_buf_init("PING", 4);
+  ASSERT(0 == uv_write(&write_req, req->handle, &b, 1, write_cb));
+  ASSERT(0 == uv_read_start(req->handle, alloc_cb, client_read_cb));
+}
+
+
+static void connect_client(void) {
+  ASSERT(0 == uv_tcp_init(server.loop, &client));
+  ASSERT(0 == uv_tcp_fastopen(&client, 1, 0));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+}
+
+
+TEST_IMPL(tcp_fastopen) {
+  uv_loop_t* loop;
+  int r;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(loop, &server));
+
+  r = uv_tcp_fastopen(&server, 1, 16);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &server, NULL);
+    uv_run(loop, UV_RUN_DEFAULT);
+    RETURN_SKIP("TCP Fast Open is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  /* Can be switched while listening. */
+  ASSERT(0 == uv_tcp_fastopen(&server, 1, 0));
+
+  connect_client();
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == NUM_ROUNDS);
+  ASSERT(write_cb_called == NUM_ROUNDS);
+  ASSERT(conn_close_cb_called == NUM_ROUNDS);
+  ASSERT(client_close_cb_called == NUM_ROUNDS);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
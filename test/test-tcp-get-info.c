@@ -0,0 +1,155 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define WRITE_SIZE  (64 * 1024)
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t conn;
+static uv_connect_t connect_req;
+static uv_write_t write_req;
+static char write_data[WRITE_SIZE];
+static char read_buf[WRITE_SIZE];
+static size_t nread_total;
+static int info_cb_called;
+static int client_seen;
+static int conn_seen;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = read_buf;
+  buf->len = sizeof(read_buf);
+}
+
+
+static void info_cb(uv_tcp_t* handle,
+                    const uv_tcp_info_t* info,
+                    void* arg) {
+  ASSERT(arg == &server);
+  ASSERT(handle != &server);
+  ASSERT(info->cwnd > 0);
+
+  if (handle == &client)
+    client_seen++;
+  if (handle == &conn)
+    conn_seen++;
+
+  info_cb_called++;
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  uv_tcp_info_t info;
+
+  ASSERT(nread >= 0);
+  nread_total += nread;
+  if (nread_total < WRITE_SIZE)
+    return;
+
+  /* Everything has arrived, so the sender has seen acknowledgements. */
+  ASSERT(0 == uv_tcp_get_info(&client, &info));
+  ASSERT(info.rtt > 0);
+  ASSERT(info.cwnd > 0);
+
+  /* Listening handles are skipped. */
+  ASSERT(2 == uv_tcp_get_info_all(stream->loop, info_cb, &server));
+  ASSERT(info_cb_called == 2);
+  ASSERT(client_seen == 1);
+  ASSERT(conn_seen == 1);
+
+  uv_close((uv_handle_t*) stream, NULL);
+  uv_close((uv_handle_t*) &client, NULL);
+  uv_close((uv_handle_t*) &server, NULL);
+
+  /* Closing handles are skipped too. */
+  ASSERT(0 == uv_tcp_get_info_all(stream->loop, info_cb, &server));
+  ASSERT(info_cb_called == 2);
+}
+
+
+static void connection_cb(uv_stream_t* handle, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(handle->loop, &conn));
+  ASSERT(0 == uv_accept(handle, (uv_stream_t*) &conn));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &conn, alloc_cb, read_cb));
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_tcp_info_t info;
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_get_info((uv_tcp_t*) req->handle, &info));
+  ASSERT(info.cwnd > 0);
+
+  buf = uv_buf_init(write_data, sizeof(write_data));
+  ASSERT(0 == uv_write(&write_req, req->handle, &buf, 1, write_cb));
+}
+
+
+TEST_IMPL(tcp_get_info) {
+  struct sockaddr_in addr;
+  uv_tcp_info_t info;
+  uv_loop_t* loop;
+  int r;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_tcp_init(loop, &client));
+  r = uv_tcp_get_info_all(loop, info_cb, &server);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &client, NULL);
+    uv_run(loop, UV_RUN_DEFAULT);
+    RETURN_SKIP("TCP_INFO is not supported on this platform.");
+  }
+
+  /* No socket yet. */
+  ASSERT(r == 0);
+  ASSERT(UV_EBADF == uv_tcp_get_info(&client, &info));
+
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(nread_total == WRITE_SIZE);
+  ASSERT(info_cb_called == 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,146 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+#endif
+
+#define LOWAT       (16 * 1024)
+#define WRITE_SIZE  (1024 * 1024)
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t conn;
+static uv_connect_t connect_req;
+static uv_write_t write_req;
+static char* write_data;
+static char read_buf[64 * 1024];
+static size_t nread_total;
+static int write_cb_called;
+
+
+static void check_lowat(uv_tcp_t* handle) {
+#if defined(TCP_NOTSENT_LOWAT)
+  unsigned int value;
+  socklen_t len;
+  uv_os_fd_t fd;
+
+  len = sizeof(value);
+  ASSERT(0 == uv_fileno((uv_handle_t*) handle, &fd));
+  ASSERT(0 == getsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &value, &len));
+  ASSERT(value == LOWAT);
+#endif
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  buf->base = read_buf;
+  buf->len = sizeof(read_buf);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread == UV_EOF) {
+    uv_close((uv_handle_t*) stream, NULL);
+    uv_close((uv_handle_t*) &server, NULL);
+    return;
+  }
+
+  ASSERT(nread >= 0);
+  nread_total += nread;
+}
+
+
+static void connection_cb(uv_stream_t* handle, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(handle->loop, &conn));
+  ASSERT(0 == uv_accept(handle, (uv_stream_t*) &conn));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &conn, alloc_cb, read_cb));
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  write_cb_called++;
+  uv_close((uv_handle_t*) req->handle, NULL);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+
+  /* Set before the socket existed. */
+  check_lowat((uv_tcp_t*) req->handle);
+
+  /* Everything still goes out, it just waits in the write queue longer. */
+  buf = uv_buf_init(write_data, WRITE_SIZE);
+  ASSERT(0 == uv_write(&write_req, req->handle, &buf, 1, write_cb));
+}
+
+
+TEST_IMPL(tcp_notsent_lowat) {
+  struct sockaddr_in addr;
+  uv_loop_t* loop;
+  int r;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_tcp_init(loop, &client));
+  r = uv_tcp_notsent_lowat(&client, LOWAT);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &client, NULL);
+    uv_run(loop, UV_RUN_DEFAULT);
+    RETURN_SKIP("TCP_NOTSENT_LOWAT is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+
+  write_data = malloc(WRITE_SIZE);
+  ASSERT(write_data != NULL);
+  memset(write_data, 'x', WRITE_SIZE);
+
+  ASSERT(0 == uv_tcp_init(loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(write_cb_called == 1);
+  ASSERT(nread_total == WRITE_SIZE);
+
+  free(write_data);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,224 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+/* Writes queued before the connection is established are flushed in batches
+ * by the unix backend. Check that the data arrives intact and in order, and
+ * that every request completes in the order it was issued.
+ */
+
+#define REQ_COUNT 4096
+#define DATA_SIZE (REQ_COUNT * 7)
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t incoming;
+static uv_connect_t connect_req;
+static uv_shutdown_t shutdown_req;
+static uv_write_t write_reqs[REQ_COUNT];
+
+static char data[DATA_SIZE];
+static size_t nrecv;
+static size_t nexpected;
+static int write_cb_called;
+static int connect_cb_called;
+static int shutdown_cb_called;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread < 0) {
+    ASSERT(nread == UV_EOF);
+    ASSERT(nrecv == nexpected);
+    uv_close((uv_handle_t*) stream, close_cb);
+    uv_close((uv_handle_t*) &server, close_cb);
+    return;
+  }
+
+  ASSERT(nrecv + nread <= nexpected);
+  ASSERT(0 == memcmp(buf->base, data + nrecv, nread));
+  nrecv += nread;
+}
+
+
+static void connection_cb(uv_stream_t* tcp, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(tcp->loop, &incoming));
+  ASSERT(0 == uv_accept(tcp, (uv_stream_t*) &incoming));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(req == &write_reqs[write_cb_called]);
+  write_cb_called++;
+}
+
+
+static void shutdown_cb(uv_shutdown_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(write_cb_called == REQ_COUNT);
+  ASSERT(client.write_queue_size == 0);
+  shutdown_cb_called++;
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+  connect_cb_called++;
+  ASSERT(0 == uv_shutdown(&shutdown_req, req->handle, shutdown_cb));
+}
+
+
+TEST_IMPL(tcp_write_gather) {
+  struct sockaddr_in addr;
+  uv_buf_t bufs[3];
+  size_t offset;
+  int i;
+
+  for (i = 0; i < DATA_SIZE; i++)
+    data[i] = i % 251;
+  nexpected = DATA_SIZE;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  /* 7 bytes per request, split over 1 to 3 buffers, one of them empty. */
+  offset = 0;
+  for (i = 0; i < REQ_COUNT; i++) {
+    switch (i % 3) {
+      case 0:
+        bufs[0] = uv_buf_init(data + offset, 7);
+        break;
+      case 1:
+        bufs[0] = uv_buf_init(data + offset, 4);
+        bufs[1] = uv_buf_init(data + offset + 4, 3);
+        break;
+      case 2:
+        bufs[0] = uv_buf_init(data + offset, 4);
+        bufs[1] = uv_buf_init(data + offset + 4, 0);
+        bufs[2] = uv_buf_init(data + offset + 4, 3);
+        break;
+    }
+    ASSERT(0 == uv_write(&write_reqs[i],
+                         (uv_stream_t*) &client,
+                         bufs,
+                         1 + i % 3,
+                         write_cb));
+    offset += 7;
+  }
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == 1);
+  ASSERT(write_cb_called == REQ_COUNT);
+  ASSERT(shutdown_cb_called == 1);
+  ASSERT(close_cb_called == 3);
+  ASSERT(nrecv == DATA_SIZE);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void prepare_cb(uv_prepare_t* handle) {
+  /* The request was done when uv_write() returned, its callback runs from the
+   * pending queue of this iteration instead of waiting for POLLOUT.
+   */
+  ASSERT(write_cb_called == 1);
+  uv_close((uv_handle_t*) handle, close_cb);
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+static void connect_empty_tail_cb(uv_connect_t* req, int status) {
+  static uv_prepare_t prepare;
+  uv_buf_t bufs[3];
+
+  ASSERT(status == 0);
+  connect_cb_called++;
+
+  bufs[0] = uv_buf_init(data, 7);
+  bufs[1] = uv_buf_init(data + 7, 0);
+  bufs[2] = uv_buf_init(data + 7, 0);
+  ASSERT(0 == uv_write(&write_reqs[0], req->handle, bufs, 3, write_cb));
+  ASSERT(req->handle->write_queue_size == 0);
+
+  ASSERT(0 == uv_prepare_init(req->handle->loop, &prepare));
+  ASSERT(0 == uv_prepare_start(&prepare, prepare_cb));
+}
+
+
+TEST_IMPL(tcp_write_gather_empty_tail) {
+  struct sockaddr_in addr;
+  int i;
+
+  for (i = 0; i < 7; i++)
+    data[i] = i;
+  nexpected = 7;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_empty_tail_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == 1);
+  ASSERT(write_cb_called == 1);
+  ASSERT(close_cb_called == 4);
+  ASSERT(nrecv == 7);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,203 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+
+TEST_IMPL(udp_connect) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#define NUM_SENDS 4
+
+static uv_udp_t server;
+static uv_udp_t client;
+static uv_udp_t stranger;
+static uv_udp_send_t send_reqs[NUM_SENDS];
+static uv_buf_t buf;
+static struct sockaddr_in server_addr;
+static struct sockaddr_in client_addr;
+static int send_cb_called;
+static int server_recv_cb_called;
+static int client_recv_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  ASSERT(status == 0);
+  send_cb_called++;
+}
+
+
+static void client_recv_cb(uv_udp_t* handle,
+                           ssize_t nread,
+                           const uv_buf_t* rcvbuf,
+                           const struct sockaddr* addr,
+                           unsigned flags) {
+  ASSERT(nread >= 0);
+  if (nread == 0)
+    return;
+
+  /* Only the peer gets through, the stranger is filtered out. */
+  ASSERT(nread == 4);
+  ASSERT(!memcmp("PONG", rcvbuf->base, nread));
+  client_recv_cb_called++;
+
+  uv_close((uv_handle_t*) &server, close_cb);
+  uv_close((uv_handle_t*) &client, close_cb);
+  uv_close((uv_handle_t*) &stranger, close_cb);
+}
+
+
+static void server_recv_cb(uv_udp_t* handle,
+                           ssize_t nread,
+                           const uv_buf_t* rcvbuf,
+                           const struct sockaddr* addr,
+                           unsigned flags) {
+  uv_buf_t reply;
+
+  ASSERT(nread >= 0);
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == 4);
+  ASSERT(addr != NULL);
+  ASSERT(!memcmp("PING", rcvbuf->base, nread));
+
+  if (++server_recv_cb_called < NUM_SENDS)
+    return;
+
+  /* The stranger's datagram is sent first, so it would arrive first. */
+  reply = uv_buf_init("JUNK", 4);
+  ASSERT(4 == uv_udp_try_send(&stranger,
+                              &reply,
+                              1,
+                              (const struct sockaddr*) &client_addr));
+  reply = uv_buf_init("PONG", 4);
+  ASSERT(4 == uv_udp_try_send(&server, &reply, 1, addr));
+}
+
+
+TEST_IMPL(udp_connect) {
+  struct sockaddr_storage peer;
+  struct sockaddr_in bad_addr;
+  uv_buf_t* bufs[2];
+  unsigned int nbufs[2];
+  int namelen;
+  int r;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &server_addr));
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT_2, &client_addr));
+  buf = uv_buf_init("PING", 4);
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &server_addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, server_recv_cb));
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &stranger));
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &client));
+  ASSERT(0 == uv_udp_bind(&client, (const struct sockaddr*) &client_addr, 0));
+
+  /* Not connected yet. */
+  ASSERT(UV_ENOTCONN == uv_udp_connect(&client, NULL));
+  r = uv_udp_send(&send_reqs[0], &client, &buf, 1, NULL, send_cb);
+  ASSERT(r == UV_EDESTADDRREQ);
+  namelen = sizeof(peer);
+  r = uv_udp_getpeername(&client, (struct sockaddr*) &peer, &namelen);
+  ASSERT(r == UV_ENOTCONN);
+
+  memset(&bad_addr, 0, sizeof(bad_addr));
+  bad_addr.sin_family = AF_UNIX;
+  r = uv_udp_connect(&client, (const struct sockaddr*) &bad_addr);
+  ASSERT(r == UV_EINVAL);
+
+  /* Connect, disconnect and connect again. */
+  ASSERT(0 == uv_udp_connect(&client, (const struct sockaddr*) &server_addr));
+  ASSERT(0 == uv_udp_connect(&client, NULL));
+  ASSERT(0 == uv_udp_connect(&client, (const struct sockaddr*) &server_addr));
+  r = uv_udp_connect(&client, (const struct sockaddr*) &server_addr);
+  ASSERT(r == UV_EISCONN);
+
+  namelen = sizeof(peer);
+  ASSERT(0 == uv_udp_getpeername(&client, (struct sockaddr*) &peer, &namelen));
+  ASSERT(namelen == sizeof(server_addr));
+  ASSERT(!memcmp(&peer, &server_addr, namelen));
+
+  /* An address is no longer allowed. */
+  r = uv_udp_send(&send_reqs[0],
+                  &client,
+                  &buf,
+                  1,
+                  (const struct sockaddr*) &server_addr,
+                  send_cb);
+  ASSERT(r == UV_EISCONN);
+  r = uv_udp_try_send(&client, &buf, 1, (const struct sockaddr*) &server_addr);
+  ASSERT(r == UV_EISCONN);
+
+  ASSERT(0 == uv_udp_send(&send_reqs[0], &client, &buf, 1, NULL, send_cb));
+  ASSERT(0 == uv_udp_send(&send_reqs[1], &client, &buf, 1, NULL, send_cb));
+  r = uv_udp_try_send(&client, &buf, 1, NULL);
+  ASSERT(r == 4 || r == UV_EAGAIN);
+  if (r == UV_EAGAIN)
+    ASSERT(0 == uv_udp_send(&send_reqs[2], &client, &buf, 1, NULL, send_cb));
+
+  bufs[0] = &buf;
+  nbufs[0] = 1;
+  r = uv_udp_try_send_batch(&client, 1, bufs, nbufs, NULL);
+  ASSERT(r == 1 || r == UV_EAGAIN);
+  if (r == UV_EAGAIN)
+    ASSERT(0 == uv_udp_send(&send_reqs[3], &client, &buf, 1, NULL, send_cb));
+
+  ASSERT(0 == uv_udp_recv_start(&client, alloc_cb, client_recv_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(send_cb_called >= 2);
+  ASSERT(server_recv_cb_called == NUM_SENDS);
+  ASSERT(client_recv_cb_called == 1);
+  ASSERT(close_cb_called == 3);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
@@ -0,0 +1,160 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define NUM_DATAGRAMS 200
+
+static uv_udp_t server;
+static uv_udp_t client;
+static struct sockaddr_in addr;
+static unsigned int burst_received;
+static int last_sent;
+static int last_received;
+static int close_cb_called;
+static int enable_late;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr_,
+                    unsigned flags) {
+  uv_loop_memory_stats_t stats;
+  uv_buf_t last;
+  uint64_t dropped;
+
+  ASSERT(nread >= 0);
+
+  /* The kernel reports drops with the next datagram it queues, send one
+   * more once the burst that fit in the receive buffer has been read.
+   */
+  if (nread == 0) {
+    ASSERT(addr_ == NULL);
+    if (!last_sent) {
+      last = uv_buf_init("LAST", 4);
+      ASSERT(4 == uv_udp_try_send(&client,
+                                  &last,
+                                  1,
+                                  (const struct sockaddr*) &addr));
+      last_sent = 1;
+    }
+    return;
+  }
+
+  if (nread == 4 && !memcmp(buf->base, "LAST", 4)) {
+    dropped = uv_udp_get_drop_counter(handle);
+    if (enable_late) {
+      ASSERT(dropped == 0);
+    } else {
+      ASSERT(dropped > 0);
+      ASSERT(dropped + burst_received == NUM_DATAGRAMS);
+    }
+    ASSERT(0 == uv_loop_memory_stats(handle->loop, &stats));
+    ASSERT(stats.udp_rx_dropped == dropped);
+    last_received = 1;
+    uv_close((uv_handle_t*) handle, close_cb);
+    uv_close((uv_handle_t*) &client, close_cb);
+    return;
+  }
+
+  ASSERT(nread == 1024);
+  ASSERT(!last_sent);
+  burst_received++;
+}
+
+
+static int drop_counter_run(int late) {
+  static char data[1024];
+  uv_buf_t buf;
+  int value;
+  int i;
+  int r;
+
+  enable_late = late;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+
+  r = uv_udp_set_drop_counter(&server, !late);
+  if (r == UV_ENOTSUP)
+    RETURN_SKIP("SO_RXQ_OVFL is not supported on this platform.");
+  ASSERT(r == 0);
+  ASSERT(0 == uv_udp_get_drop_counter(&server));
+
+  /* The kernel rounds this up to its minimum, far below the burst. */
+  value = 1;
+  ASSERT(0 == uv_recv_buffer_size((uv_handle_t*) &server, &value));
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &client));
+  memset(data, 'x', sizeof(data));
+  buf = uv_buf_init(data, sizeof(data));
+  for (i = 0; i < NUM_DATAGRAMS; i++)
+    ASSERT(sizeof(data) == uv_udp_try_send(&client,
+                                           &buf,
+                                           1,
+                                           (const struct sockaddr*) &addr));
+
+  /* The drops of the burst happened before the counter was enabled and
+   * must not show up in it.
+   */
+  if (late)
+    ASSERT(0 == uv_udp_set_drop_counter(&server, 1));
+
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(last_received == 1);
+  ASSERT(close_cb_called == 2);
+  ASSERT(burst_received > 0);
+  ASSERT(burst_received < NUM_DATAGRAMS);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(udp_drop_counter) {
+  return drop_counter_run(0);
+}
+
+
+TEST_IMPL(udp_drop_counter_enable_late) {
+  return drop_counter_run(1);
+}
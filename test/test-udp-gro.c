@@ -0,0 +1,142 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define NUM_SEGMENTS 10
+#define SEGMENT_SIZE 1000
+
+static uv_udp_t server;
+static uv_udp_t client;
+static uv_udp_send_t send_req;
+static char data[NUM_SEGMENTS * SEGMENT_SIZE];
+static size_t received;
+static int datagrams;
+static int gro_cb_called;
+static int send_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  static char slab[65536];
+  ASSERT(suggested_size == sizeof(slab));
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  ASSERT(status == 0);
+  send_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  size_t segment_size;
+
+  ASSERT(nread >= 0);
+  if (nread == 0) {
+    ASSERT(addr == NULL);
+    return;
+  }
+
+  ASSERT(addr != NULL);
+  ASSERT(!(flags & UV_UDP_PARTIAL));
+  ASSERT(received + nread <= sizeof(data));
+  ASSERT(!memcmp(buf->base, data + received, nread));
+
+  segment_size = uv_udp_get_gro_segment_size(handle);
+  if (flags & UV_UDP_GRO) {
+    ASSERT(segment_size == SEGMENT_SIZE);
+    datagrams += (nread + segment_size - 1) / segment_size;
+    gro_cb_called++;
+  } else {
+    ASSERT(segment_size == 0);
+    ASSERT(nread == SEGMENT_SIZE);
+    datagrams++;
+  }
+
+  received += nread;
+  if (received == sizeof(data)) {
+    uv_close((uv_handle_t*) handle, close_cb);
+    uv_close((uv_handle_t*) &client, close_cb);
+  }
+}
+
+
+TEST_IMPL(udp_gro) {
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+  size_t i;
+  int r;
+
+  for (i = 0; i < sizeof(data); i++)
+    data[i] = i % 251;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+
+  r = uv_udp_set_gro(&server, 1);
+  if (r == UV_ENOTSUP || r == UV_ENOPROTOOPT)
+    RETURN_SKIP("UDP_GRO is not supported on this platform.");
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &client));
+
+  /* With UDP_SEGMENT the datagrams cross loopback as one and arrive
+   * coalesced, without it the kernel is free to coalesce them or not.
+   */
+  buf = uv_buf_init(data, sizeof(data));
+  ASSERT(0 == uv_udp_send_segmented(&send_req,
+                                    &client,
+                                    &buf,
+                                    1,
+                                    SEGMENT_SIZE,
+                                    (const struct sockaddr*) &addr,
+                                    send_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(send_cb_called == 1);
+  ASSERT(close_cb_called == 2);
+  ASSERT(received == sizeof(data));
+  ASSERT(datagrams == NUM_SEGMENTS);
+  ASSERT(gro_cb_called > 0);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
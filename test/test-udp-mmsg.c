@@ -0,0 +1,142 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_SENDS 16
+#define NUM_SLOTS 8
+#define SLOT_SIZE (64 * 1024)
+
+static uv_udp_t recver;
+static uv_udp_t sender;
+static int recv_cb_called;
+static int chunk_cb_called;
+static int close_cb_called;
+static int alloc_cb_called;
+static int free_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  buf->base = malloc(NUM_SLOTS * SLOT_SIZE);
+  ASSERT(buf->base != NULL);
+  buf->len = NUM_SLOTS * SLOT_SIZE;
+  alloc_cb_called++;
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  ASSERT(nread >= 0);
+
+  if (flags & UV_UDP_MMSG_FREE) {
+    ASSERT(nread == 0);
+    ASSERT(addr == NULL);
+    free(buf->base);
+    free_cb_called++;
+    return;
+  }
+
+  /* Nothing to read, hand the buffer back. */
+  if (nread == 0 && addr == NULL) {
+    ASSERT(!(flags & UV_UDP_MMSG_CHUNK));
+    free(buf->base);
+    free_cb_called++;
+    return;
+  }
+
+  ASSERT(nread == 4);
+  ASSERT(addr != NULL);
+  ASSERT(!memcmp("PING", buf->base, nread));
+  ASSERT(!(flags & UV_UDP_PARTIAL));
+
+  if (flags & UV_UDP_MMSG_CHUNK) {
+    chunk_cb_called++;
+  } else {
+    /* Not received with recvmmsg(), the buffer is ours to release. */
+    free(buf->base);
+    free_cb_called++;
+  }
+
+  if (++recv_cb_called == NUM_SENDS) {
+    uv_close((uv_handle_t*) handle, close_cb);
+    uv_close((uv_handle_t*) &sender, close_cb);
+  }
+}
+
+
+TEST_IMPL(udp_mmsg) {
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+  int i;
+  int r;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(UV_EINVAL == uv_udp_init_ex(uv_default_loop(),
+                                     &recver,
+                                     AF_INET | 512));
+  ASSERT(0 == uv_udp_init_ex(uv_default_loop(),
+                             &recver,
+                             AF_INET | UV_UDP_RECVMMSG));
+  ASSERT(0 == uv_udp_bind(&recver, (const struct sockaddr*) &addr, 0));
+
+  /* Queue all datagrams up so that they can be read in a batch. */
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &sender));
+  buf = uv_buf_init("PING", 4);
+  for (i = 0; i < NUM_SENDS; i++) {
+    r = uv_udp_try_send(&sender, &buf, 1, (const struct sockaddr*) &addr);
+    ASSERT(r == 4);
+  }
+
+  ASSERT(0 == uv_udp_recv_start(&recver, alloc_cb, recv_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(close_cb_called == 2);
+  ASSERT(recv_cb_called == NUM_SENDS);
+  ASSERT(alloc_cb_called == free_cb_called);
+#ifdef __linux__
+  /* Two batches of NUM_SLOTS datagrams, unless the kernel lacks recvmmsg(). */
+  if (chunk_cb_called != 0) {
+    ASSERT(chunk_cb_called == NUM_SENDS);
+    ASSERT(alloc_cb_called == NUM_SENDS / NUM_SLOTS);
+  }
+#else
+  ASSERT(chunk_cb_called == 0);
+#endif
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,156 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+#include <time.h>
+
+static uv_udp_t server;
+static uv_udp_t client;
+static uv_udp_send_t send_req;
+static int recv_cb_called;
+static int send_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  ASSERT(status == 0);
+  send_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  const struct sockaddr_in6* local6;
+  const struct sockaddr_in* local4;
+  uv_udp_recv_info_t info;
+  struct in6_addr loopback6;
+  long now;
+
+  ASSERT(nread >= 0);
+  if (nread == 0) {
+    ASSERT(addr == NULL);
+    return;
+  }
+
+  ASSERT(nread == 4);
+  ASSERT(!memcmp(buf->base, "PING", 4));
+
+  ASSERT(0 == uv_udp_get_recv_info(handle, &info));
+  ASSERT(info.flags == (UV_UDP_RECV_TIMESTAMP | UV_UDP_RECV_PKTINFO));
+
+  now = (long) time(NULL);
+  ASSERT(info.timestamp.tv_sec > now - 60);
+  ASSERT(info.timestamp.tv_sec <= now);
+  ASSERT(info.timestamp.tv_nsec >= 0);
+  ASSERT(info.timestamp.tv_nsec < 1000000000);
+
+  ASSERT(info.local_addr.ss_family == addr->sa_family);
+  if (addr->sa_family == AF_INET) {
+    local4 = (const struct sockaddr_in*) &info.local_addr;
+    ASSERT(local4->sin_addr.s_addr == htonl(INADDR_LOOPBACK));
+    ASSERT(local4->sin_port == 0);
+  } else {
+    loopback6 = in6addr_loopback;
+    local6 = (const struct sockaddr_in6*) &info.local_addr;
+    ASSERT(!memcmp(&local6->sin6_addr, &loopback6, sizeof(loopback6)));
+    ASSERT(local6->sin6_port == 0);
+  }
+
+  recv_cb_called++;
+
+  uv_close((uv_handle_t*) handle, close_cb);
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+static int run_test(const struct sockaddr* addr) {
+  uv_udp_recv_info_t info;
+  uv_buf_t buf;
+  int r;
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_udp_bind(&server, addr, 0));
+
+  r = uv_udp_set_recv_info(&server,
+                           UV_UDP_RECV_TIMESTAMP | UV_UDP_RECV_PKTINFO);
+  if (r == UV_ENOTSUP)
+    RETURN_SKIP("Receive info is not supported on this platform.");
+  ASSERT(r == 0);
+  ASSERT(UV_EINVAL == uv_udp_set_recv_info(&server, 4));
+
+  /* Only valid inside the receive callback. */
+  ASSERT(UV_EINVAL == uv_udp_get_recv_info(&server, &info));
+  ASSERT(info.flags == 0);
+
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &client));
+
+  buf = uv_buf_init("PING", 4);
+  ASSERT(0 == uv_udp_send(&send_req, &client, &buf, 1, addr, send_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(send_cb_called == 1);
+  ASSERT(recv_cb_called == 1);
+  ASSERT(close_cb_called == 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(udp_recv_info) {
+  struct sockaddr_in addr;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  return run_test((const struct sockaddr*) &addr);
+}
+
+
+TEST_IMPL(udp_recv_info_ipv6) {
+  struct sockaddr_in6 addr;
+
+  if (!can_ipv6())
+    RETURN_SKIP("IPv6 not supported");
+
+  ASSERT(0 == uv_ip6_addr("::1", TEST_PORT, &addr));
+  return run_test((const struct sockaddr*) &addr);
+}
@@ -0,0 +1,118 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define NUM_DATAGRAMS 16
+
+static uv_udp_t server;
+static uv_udp_t client;
+static struct sockaddr_in addr;
+static const char* slab;
+static int received;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr_,
+                    unsigned flags) {
+  char expected[NUM_DATAGRAMS + 1];
+
+  ASSERT(nread >= 0);
+  ASSERT(!(flags & UV_UDP_MMSG_FREE));
+  if (nread == 0) {
+    ASSERT(addr_ == NULL);
+    return;
+  }
+
+  /* Datagram i holds i + 1 bytes of 'a' + i. */
+  ASSERT(nread == received + 1);
+  ASSERT(buf->len == (size_t) nread);
+  memset(expected, 'a' + received, nread);
+  ASSERT(!memcmp(buf->base, expected, nread));
+
+  /* Every slice comes from the same slab. */
+  if (slab == NULL)
+    slab = buf->base;
+  ASSERT(buf->base >= slab);
+  ASSERT(buf->base < slab + 32 * 65536);
+
+  if (++received == NUM_DATAGRAMS) {
+    uv_close((uv_handle_t*) handle, close_cb);
+    uv_close((uv_handle_t*) &client, close_cb);
+  }
+}
+
+
+static int run_test(unsigned int flags) {
+  char data[NUM_DATAGRAMS];
+  uv_buf_t buf;
+  int r;
+  int i;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init_ex(uv_default_loop(), &server, AF_INET | flags));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+
+  r = uv_udp_recv_start(&server, NULL, recv_cb);
+  if (r == UV_ENOTSUP)
+    RETURN_SKIP("Library-managed receive buffers are not supported.");
+  ASSERT(r == 0);
+  ASSERT(UV_EINVAL == uv_udp_recv_start(&server, NULL, NULL));
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &client));
+  for (i = 0; i < NUM_DATAGRAMS; i++) {
+    memset(data, 'a' + i, i + 1);
+    buf = uv_buf_init(data, i + 1);
+    ASSERT(i + 1 == uv_udp_try_send(&client,
+                                    &buf,
+                                    1,
+                                    (const struct sockaddr*) &addr));
+  }
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(received == NUM_DATAGRAMS);
+  ASSERT(close_cb_called == 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(udp_recv_slab) {
+  return run_test(0);
+}
+
+
+TEST_IMPL(udp_recv_slab_mmsg) {
+  return run_test(UV_UDP_RECVMMSG);
+}
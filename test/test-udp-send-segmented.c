@@ -0,0 +1,175 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+
+TEST_IMPL(udp_send_segmented) {
+  RETURN_SKIP("Test not implemented on Windows.");
+}
+
+#else  /* !_WIN32 */
+
+#define DATA_SIZE 60000
+
+static uv_udp_t server;
+static uv_udp_t client;
+static uv_udp_send_t send_reqs[2];
+static char data[DATA_SIZE];
+
+/* Datagram layout of the two sends: 300 byte segments, more than fit in a
+ * single UDP_SEGMENT call, then segments too large to offload.
+ */
+static const size_t segment_sizes[] = { 300, 40000 };
+static const size_t send_sizes[] = { 70 * 300 + 123, DATA_SIZE };
+
+static size_t expected_send;
+static size_t expected_offset;
+static int recv_cb_called;
+static int send_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle,
+                     size_t suggested_size,
+                     uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(req == &send_reqs[send_cb_called]);
+  send_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  size_t expected_len;
+
+  ASSERT(nread >= 0);
+  if (nread == 0) {
+    ASSERT(addr == NULL);
+    return;
+  }
+
+  ASSERT(addr != NULL);
+  ASSERT(!(flags & UV_UDP_PARTIAL));
+
+  expected_len = send_sizes[expected_send] - expected_offset;
+  if (expected_len > segment_sizes[expected_send])
+    expected_len = segment_sizes[expected_send];
+
+  ASSERT((size_t) nread == expected_len);
+  ASSERT(!memcmp(buf->base, data + expected_offset, nread));
+  recv_cb_called++;
+
+  expected_offset += nread;
+  if (expected_offset < send_sizes[expected_send])
+    return;
+
+  expected_offset = 0;
+  if (++expected_send < ARRAY_SIZE(send_sizes))
+    return;
+
+  uv_close((uv_handle_t*) handle, close_cb);
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+TEST_IMPL(udp_send_segmented) {
+  struct sockaddr_in addr;
+  uv_buf_t bufs[3];
+  size_t i;
+  int r;
+
+  for (i = 0; i < sizeof(data); i++)
+    data[i] = i % 251;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+
+  ASSERT(0 == uv_udp_init(uv_default_loop(), &client));
+
+  /* Segments that straddle buffer boundaries. */
+  bufs[0] = uv_buf_init(data, 1000);
+  bufs[1] = uv_buf_init(data + 1000, 7);
+  bufs[2] = uv_buf_init(data + 1007, send_sizes[0] - 1007);
+
+  r = uv_udp_send_segmented(&send_reqs[0],
+                            &client,
+                            bufs,
+                            ARRAY_SIZE(bufs),
+                            0,
+                            (const struct sockaddr*) &addr,
+                            send_cb);
+  ASSERT(r == UV_EINVAL);
+
+  r = uv_udp_send_segmented(&send_reqs[0],
+                            &client,
+                            bufs,
+                            ARRAY_SIZE(bufs),
+                            segment_sizes[0],
+                            (const struct sockaddr*) &addr,
+                            send_cb);
+  ASSERT(r == 0);
+
+  bufs[0] = uv_buf_init(data, send_sizes[1]);
+  r = uv_udp_send_segmented(&send_reqs[1],
+                            &client,
+                            bufs,
+                            1,
+                            segment_sizes[1],
+                            (const struct sockaddr*) &addr,
+                            send_cb);
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(send_cb_called == 2);
+  ASSERT(recv_cb_called == 71 + 2);
+  ASSERT(close_cb_called == 2);
+  ASSERT(client.send_queue_size == 0);
+  ASSERT(client.send_queue_count == 0);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+#endif  /* !_WIN32 */
@@ -34,15 +34,25 @@ TEST_IMPL(udp_try_send) {
   return 0;
 }
 
+TEST_IMPL(udp_try_send_batch) {
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
 #else  /* !_WIN32 */
 
 #define CHECK_HANDLE(handle) \
   ASSERT((uv_udp_t*)(handle) == &server || (uv_udp_t*)(handle) == &client)
 
+/* More than one sendmmsg() call's worth. */
+#define NUM_BATCH 40
+
 static uv_udp_t server;
 static uv_udp_t client;
 
 static int sv_recv_cb_called;
+static int sv_ping_cb_called;
 
 static int close_cb_called;
 
@@ -88,6 +98,35 @@ static void sv_recv_cb(uv_udp_t* handle,
 }
 
 
+static void sv_batch_recv_cb(uv_udp_t* handle,
+                             ssize_t nread,
+                             const uv_buf_t* rcvbuf,
+                             const struct sockaddr* addr,
+                             unsigned flags) {
+  ASSERT(nread >= 0);
+
+  if (nread == 0) {
+    ASSERT(addr == NULL);
+    return;
+  }
+
+  ASSERT(nread == 4);
+  ASSERT(addr != NULL);
+
+  if (memcmp("PING", rcvbuf->base, nread) == 0) {
+    sv_ping_cb_called++;
+    return;
+  }
+
+  ASSERT(memcmp("EXIT", rcvbuf->base, nread) == 0);
+  ASSERT(sv_ping_cb_called == NUM_BATCH - 1);
+  uv_close((uv_handle_t*) handle, close_cb);
+  uv_close((uv_handle_t*) &client, close_cb);
+
+  sv_recv_cb_called++;
+}
+
+
 TEST_IMPL(udp_try_send) {
   struct sockaddr_in addr;
   static char buffer[64 * 1024];
@@ -130,4 +169,82 @@ TEST_IMPL(udp_try_send) {
   return 0;
 }
 
+
+TEST_IMPL(udp_try_send_batch) {
+  struct sockaddr_in addr;
+  struct sockaddr* addrs[NUM_BATCH];
+  static char buffer[64 * 1024];
+  uv_buf_t ping;
+  uv_buf_t last;
+  uv_buf_t big;
+  uv_buf_t* bufs[NUM_BATCH];
+  unsigned int nbufs[NUM_BATCH];
+  int sent;
+  int i;
+  int r;
+
+  ASSERT(0 == uv_ip4_addr("0.0.0.0", TEST_PORT, &addr));
+
+  r = uv_udp_init(uv_default_loop(), &server);
+  ASSERT(r == 0);
+
+  r = uv_udp_bind(&server, (const struct sockaddr*) &addr, 0);
+  ASSERT(r == 0);
+
+  r = uv_udp_recv_start(&server, alloc_cb, sv_batch_recv_cb);
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  r = uv_udp_init(uv_default_loop(), &client);
+  ASSERT(r == 0);
+
+  ping = uv_buf_init("PING", 4);
+  last = uv_buf_init("EXIT", 4);
+  big = uv_buf_init(buffer, sizeof(buffer));
+
+  for (i = 0; i < NUM_BATCH; i++) {
+    addrs[i] = (struct sockaddr*) &addr;
+    bufs[i] = &ping;
+    nbufs[i] = 1;
+  }
+
+  /* An error in the first datagram is returned as is. */
+  bufs[0] = &big;
+  r = uv_udp_try_send_batch(&client, NUM_BATCH, bufs, nbufs, addrs);
+  ASSERT(r == UV_EMSGSIZE);
+
+  /* Datagrams before a failing one count as sent. */
+  bufs[0] = &ping;
+  bufs[1] = &big;
+  r = uv_udp_try_send_batch(&client, NUM_BATCH, bufs, nbufs, addrs);
+  ASSERT(r == 1);
+
+  bufs[1] = &ping;
+  bufs[NUM_BATCH - 1] = &last;
+  sent = 1;
+  while (sent < NUM_BATCH) {
+    r = uv_udp_try_send_batch(&client,
+                              NUM_BATCH - sent,
+                              bufs + sent,
+                              nbufs + sent,
+                              addrs + sent);
+    ASSERT(r > 0);
+    sent += r;
+  }
+  ASSERT(sent == NUM_BATCH);
+
+  uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+  ASSERT(close_cb_called == 2);
+  ASSERT(sv_recv_cb_called == 1);
+  ASSERT(sv_ping_cb_called == NUM_BATCH - 1);
+
+  ASSERT(client.send_queue_size == 0);
+  ASSERT(server.send_queue_size == 0);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
 #endif  /* !_WIN32 */
@@ -0,0 +1,400 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#define MSG_COUNT 10000
+#define MSG_SIZE 12
+
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t incoming;
+static uv_connect_t connect_req;
+static uv_connect_t filler_req;
+static uv_shutdown_t shutdown_req;
+static uv_write_t write_req;
+
+static char data[MSG_COUNT * MSG_SIZE];
+static size_t nrecv;
+static int write_copy_cb_called;
+static int write_copy_cancel_cb_called;
+static int write_cb_called;
+static int shutdown_cb_called;
+static int connect_cb_called;
+static int close_cb_called;
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread < 0) {
+    ASSERT(nread == UV_EOF);
+    ASSERT(nrecv == sizeof(data));
+    uv_close((uv_handle_t*) stream, close_cb);
+    uv_close((uv_handle_t*) &server, close_cb);
+    return;
+  }
+
+  ASSERT(nrecv + nread <= sizeof(data));
+  ASSERT(0 == memcmp(buf->base, data + nrecv, nread));
+  nrecv += nread;
+}
+
+
+static void connection_cb(uv_stream_t* tcp, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(tcp->loop, &incoming));
+  ASSERT(0 == uv_accept(tcp, (uv_stream_t*) &incoming));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+}
+
+
+static void write_copy_cb(uv_stream_t* handle, int status) {
+  ASSERT(handle == (uv_stream_t*) &client);
+  ASSERT(status == 0);
+  write_copy_cb_called++;
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(req == &write_req);
+  ASSERT(status == 0);
+  write_cb_called++;
+}
+
+
+static void shutdown_cb(uv_shutdown_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(write_copy_cb_called == MSG_COUNT / 100);
+  ASSERT(write_cb_called == 1);
+  shutdown_cb_called++;
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+  int i;
+
+  ASSERT(status == 0);
+
+  /* Every 100th message asks for a callback, message 5000 goes through a
+   * regular write request. The data must arrive in order all the same.
+   */
+  for (i = 0; i < MSG_COUNT; i++) {
+    buf = uv_buf_init(data + i * MSG_SIZE, MSG_SIZE);
+    if (i == MSG_COUNT / 2) {
+      ASSERT(0 == uv_write(&write_req, req->handle, &buf, 1, write_cb));
+      continue;
+    }
+    ASSERT(0 == uv_write_copy(req->handle,
+                              &buf,
+                              1,
+                              i % 100 == 99 ? write_copy_cb : NULL));
+  }
+
+  ASSERT(0 == uv_shutdown(&shutdown_req, req->handle, shutdown_cb));
+}
+
+
+TEST_IMPL(write_copy) {
+#if defined(_WIN32)
+  RETURN_SKIP("uv_write_copy() is not supported on Windows.");
+#else
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+  size_t i;
+
+  for (i = 0; i < sizeof(data); i++)
+    data[i] = i % 251;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  buf = uv_buf_init(data, MSG_SIZE);
+  ASSERT(UV_EBADF == uv_write_copy((uv_stream_t*) &client, &buf, 1, NULL));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(write_copy_cb_called == MSG_COUNT / 100);
+  ASSERT(write_cb_called == 1);
+  ASSERT(shutdown_cb_called == 1);
+  ASSERT(close_cb_called == 3);
+  ASSERT(nrecv == sizeof(data));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+static void write_copy_cancel_cb(uv_stream_t* handle, int status) {
+  ASSERT(handle == (uv_stream_t*) &client);
+  ASSERT(status == UV_ECANCELED);
+  write_copy_cancel_cb_called++;
+}
+
+
+static void connect_close_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+
+  buf = uv_buf_init(data, sizeof(data));
+  ASSERT(0 == uv_write_copy(req->handle, &buf, 1, NULL));
+  buf = uv_buf_init(data, MSG_SIZE);
+  ASSERT(0 == uv_write_copy(req->handle, &buf, 1, write_copy_cancel_cb));
+
+  uv_close((uv_handle_t*) req->handle, close_cb);
+  uv_close((uv_handle_t*) &server, close_cb);
+}
+
+
+static void connection_close_cb(uv_stream_t* tcp, int status) {
+  /* The connection may or may not be accepted before the server closes. */
+}
+
+
+TEST_IMPL(write_copy_close) {
+#if defined(_WIN32)
+  RETURN_SKIP("uv_write_copy() is not supported on Windows.");
+#else
+  struct sockaddr_in addr;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_close_cb));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_close_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(write_copy_cancel_cb_called == 1);
+  ASSERT(close_cb_called == 2);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+
+static void write_copy_connecting_cb(uv_stream_t* handle, int status) {
+  ASSERT(handle == (uv_stream_t*) &client);
+  ASSERT(status == UV_ECANCELED);
+  ASSERT(connect_cb_called == 1);
+  write_copy_cancel_cb_called++;
+}
+
+
+static void connect_connecting_cb(uv_connect_t* req, int status) {
+  ASSERT(req == &connect_req);
+  ASSERT(status == UV_ECANCELED);
+  ASSERT(write_copy_cancel_cb_called == 0);
+  connect_cb_called++;
+}
+
+
+static void connecting_timer_cb(uv_timer_t* handle) {
+  /* The connection is still in SYN_SENT. */
+  ASSERT(connect_cb_called == 0);
+  uv_close((uv_handle_t*) &client, close_cb);
+  uv_close((uv_handle_t*) &incoming, close_cb);
+  uv_close((uv_handle_t*) handle, close_cb);
+}
+
+
+static void connect_filler_cb(uv_connect_t* req, int status) {
+  static uv_timer_t timer;
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+
+  /* The accept queue is full now, the kernel drops the next SYN. */
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(req->handle->loop, &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_connecting_cb));
+  buf = uv_buf_init(data, MSG_SIZE);
+  ASSERT(0 == uv_write_copy((uv_stream_t*) &client,
+                            &buf,
+                            1,
+                            write_copy_connecting_cb));
+
+  ASSERT(0 == uv_timer_init(req->handle->loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, connecting_timer_cb, 100, 0));
+}
+
+
+TEST_IMPL(write_copy_connect) {
+#if !defined(__linux__)
+  RETURN_SKIP("Depends on how Linux handles a full accept queue.");
+#else
+  struct sockaddr_in addr;
+  int fd;
+  int on;
+
+  /* A listen socket with a backlog of zero that nobody accepts from. */
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT(fd >= 0);
+  on = 1;
+  ASSERT(0 == setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)));
+  ASSERT(0 == bind(fd, (const struct sockaddr*) &addr, sizeof(addr)));
+  ASSERT(0 == listen(fd, 0));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &incoming));
+  ASSERT(0 == uv_tcp_connect(&filler_req,
+                             &incoming,
+                             (const struct sockaddr*) &addr,
+                             connect_filler_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(connect_cb_called == 1);
+  ASSERT(write_copy_cancel_cb_called == 1);
+  ASSERT(close_cb_called == 3);
+
+  ASSERT(0 == close(fd));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
+
+
+static void try_write_read_cb(uv_stream_t* stream,
+                              ssize_t nread,
+                              const uv_buf_t* buf) {
+  if (nread < 0) {
+    ASSERT(nread == UV_EOF);
+    ASSERT(nrecv == 2 * MSG_SIZE);
+    uv_close((uv_handle_t*) stream, close_cb);
+    uv_close((uv_handle_t*) &server, close_cb);
+    return;
+  }
+
+  ASSERT(nrecv + nread <= 2 * MSG_SIZE);
+  ASSERT(0 == memcmp(buf->base, data + nrecv, nread));
+  nrecv += nread;
+}
+
+
+static void try_write_connection_cb(uv_stream_t* tcp, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(tcp->loop, &incoming));
+  ASSERT(0 == uv_accept(tcp, (uv_stream_t*) &incoming));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming,
+                            alloc_cb,
+                            try_write_read_cb));
+}
+
+
+static void try_write_shutdown_cb(uv_shutdown_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(write_copy_cb_called == 1);
+  shutdown_cb_called++;
+  uv_close((uv_handle_t*) req->handle, close_cb);
+}
+
+
+static void try_write_connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+
+  /* uv_try_write() flushes the coalesced data first, the socket buffer
+   * takes both at once.
+   */
+  buf = uv_buf_init(data, MSG_SIZE);
+  ASSERT(0 == uv_write_copy(req->handle, &buf, 1, write_copy_cb));
+  buf = uv_buf_init(data + MSG_SIZE, MSG_SIZE);
+  ASSERT(MSG_SIZE == uv_try_write(req->handle, &buf, 1));
+
+  ASSERT(0 == uv_shutdown(&shutdown_req, req->handle, try_write_shutdown_cb));
+}
+
+
+TEST_IMPL(write_copy_try_write) {
+#if defined(_WIN32)
+  RETURN_SKIP("uv_write_copy() is not supported on Windows.");
+#else
+  struct sockaddr_in addr;
+  size_t i;
+
+  for (i = 0; i < sizeof(data); i++)
+    data[i] = i % 251;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, try_write_connection_cb));
+
+  ASSERT(0 == uv_tcp_init(uv_default_loop(), &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             try_write_connect_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  ASSERT(write_copy_cb_called == 1);
+  ASSERT(shutdown_cb_called == 1);
+  ASSERT(close_cb_called == 3);
+  ASSERT(nrecv == 2 * MSG_SIZE);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
@@ -341,6 +341,7 @@
         'test/test-emfile.c',
         'test/test-fail-always.c',
         'test/test-fs.c',
+        'test/test-fs-copyfile.c',
         'test/test-fs-event.c',
         'test/test-get-currentexe.c',
         'test/test-get-memory.c',
@@ -357,13 +358,16 @@
         'test/test-ipc-send-recv.c',
         'test/test-list.h',
         'test/test-loop-handles.c',
+        'test/test-loop-memory-budget.c',
         'test/test-loop-alive.c',
         'test/test-loop-close.c',
         'test/test-loop-stop.c',
         'test/test-loop-time.c',
         'test/test-loop-configure.c',
+        'test/test-loop-io-budget.c',
         'test/test-walk-handles.c',
         'test/test-watcher-cross-stop.c',
+        'test/test-write-copy.c',
         'test/test-multiple-listen.c',
         'test/test-osx-select.c',
         'test/test-pass-always.c',
@@ -385,7 +389,9 @@
         'test/test-poll-closesocket.c',
         'test/test-process-title.c',
         'test/test-queue-foreach-delete.c',
+        'test/test-read-size-mode.c',
         'test/test-ref.c',
+        'test/test-reuseport.c',
         'test/test-run-nowait.c',
         'test/test-run-once.c',
         'test/test-semaphore.c',
@@ -398,6 +404,10 @@
         'test/test-spawn.c',
         'test/test-fs-poll.c',
         'test/test-stdio-over-pipes.c',
+        'test/test-stream-idle-timeout.c',
+        'test/test-stream-rate-limit.c',
+        'test/test-stream-watermarks.c',
+        'test/test-tcp-accept-group.c',
         'test/test-tcp-alloc-cb-fail.c',
         'test/test-tcp-bind-error.c',
         'test/test-tcp-bind6-error.c',
@@ -407,10 +417,14 @@
         'test/test-tcp-create-socket-early.c',
         'test/test-tcp-connect-error-after-write.c',
         'test/test-tcp-shutdown-after-write.c',
+        'test/test-tcp-fastopen.c',
         'test/test-tcp-flags.c',
+        'test/test-tcp-get-info.c',
         'test/test-tcp-connect-error.c',
+        'test/test-tcp-connect-multi.c',
         'test/test-tcp-connect-timeout.c',
         'test/test-tcp-connect6-error.c',
+        'test/test-tcp-notsent-lowat.c',
         'test/test-tcp-open.c',
         'test/test-tcp-write-to-half-open-connection.c',
         'test/test-tcp-write-after-connect.c',
@@ -421,6 +435,7 @@
         'test/test-tcp-oob.c',
         'test/test-tcp-read-stop.c',
         'test/test-tcp-write-queue-order.c',
+        'test/test-tcp-write-gather.c',
         'test/test-threadpool.c',
         'test/test-threadpool-cancel.c',
         'test/test-thread-equal.c',
@@ -435,13 +450,19 @@
         'test/test-tty.c',
         'test/test-udp-alloc-cb-fail.c',
         'test/test-udp-bind.c',
+        'test/test-udp-connect.c',
         'test/test-udp-create-socket-early.c',
         'test/test-udp-dgram-too-big.c',
+        'test/test-udp-drop-counter.c',
+        'test/test-udp-gro.c',
         'test/test-udp-ipv6.c',
         'test/test-udp-open.c',
         'test/test-udp-options.c',
+        'test/test-udp-recv-info.c',
+        'test/test-udp-recv-slab.c',
         'test/test-udp-send-and-recv.c',
         'test/test-udp-send-immediate.c',
+        'test/test-udp-send-segmented.c',
         'test/test-udp-send-unreachable.c',
         'test/test-udp-multicast-join.c',
         'test/test-udp-multicast-join6.c',
@@ -449,6 +470,7 @@
         'test/test-udp-multicast-ttl.c',
         'test/test-ip4-addr.c',
         'test/test-ip6-addr.c',
+        'test/test-udp-mmsg.c',
         'test/test-udp-multicast-interface.c',
         'test/test-udp-multicast-interface6.c',
         'test/test-udp-try-send.c',
@@ -516,10 +538,12 @@
       'sources': [
         'test/benchmark-async.c',
         'test/benchmark-async-pummel.c',
+        'test/benchmark-fs-copyfile.c',
         'test/benchmark-fs-stat.c',
         'test/benchmark-getaddrinfo.c',
         'test/benchmark-list.h',
         'test/benchmark-loop-count.c',
+        'test/benchmark-loop-fairness.c',
         'test/benchmark-million-async.c',
         'test/benchmark-million-timers.c',
         'test/benchmark-multi-accept.c',
@@ -528,9 +552,14 @@
         'test/benchmark-pump.c',
         'test/benchmark-sizes.c',
         'test/benchmark-spawn.c',
+        'test/benchmark-stream-idle-timeout.c',
+        'test/benchmark-stream-rate-limit.c',
         'test/benchmark-thread.c',
+        'test/benchmark-tcp-fastopen.c',
+        'test/benchmark-tcp-notsent-lowat.c',
         'test/benchmark-tcp-write-batch.c',
         'test/benchmark-udp-pummel.c',
+        'test/benchmark-udp-send-segmented.c',
         'test/dns-server.c',
         'test/echo-server.c',
         'test/blackhole-server.c',